@@ -0,0 +1,823 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Benchmark.cpp
+ *
+ */
+
+#include "Raymarcher.h"
+#include "TileRenderer.h"
+#include "ShaderManager.h"
+#include "ParameterBuffer.h"
+#include "BrickMap.h"
+#include "OccupancyOctree.h"
+#include "MeshExtractor.h"
+#include "AdaptiveSampler.h"
+
+#include "helpers/RootDir.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// number of random points of SDF benchmark
+const int sdfPoints = 1 << 16;
+
+// resolution of the ray grid of trace and normal benchmarks
+const glm::ivec2 rayGrid = glm::ivec2(128, 72);
+
+// preset camera view of all benchmarks
+const int benchmarkView = 1;
+
+// samples along the side of a pixel of temporal antialiasing benchmarks, all AA*AA subframes are measured together
+const int benchmarkAntialiasing = 4;
+
+// temporary file of mesh extraction benchmark
+const char* const benchmarkMeshPath = "benchmark_mesh.ply";
+
+/**
+ * @brief Settings given on command line
+ */
+typedef struct benchmarkSettings
+{
+	int warmup;
+	int repetitions;
+	bool quick;
+	bool gpu;
+	std::string filter;
+	std::string outputPath;
+} BenchmarkSettings;
+
+/**
+ * @brief Times of all repetitions of one benchmark case
+ */
+typedef struct benchmarkResult
+{
+	std::string name;
+	std::vector<std::pair<std::string, std::string>> params;
+	long long items;
+	std::vector<double> times;		// milliseconds of every repetition
+} BenchmarkResult;
+
+/**
+ * @brief Gives benchmarks access to the private stages of the raymarcher
+ */
+class RaymarcherBenchmark
+{
+public:
+	static float mandelbulbSDF(const Raymarcher& raymarcher, glm::vec3 point)
+	{
+		return raymarcher.mandelbulbSDF(point);
+	}
+
+	static glm::vec3 estimateNormal(const Raymarcher& raymarcher, glm::vec3 point, float dist, float epsilon)
+	{
+		return raymarcher.estimateNormal(point, dist, epsilon);
+	}
+
+	static glm::vec3 trace(const Raymarcher& raymarcher, const Ray& ray)
+	{
+		return raymarcher.trace(ray, 0.5f);
+	}
+
+	static Ray primaryRay(const Raymarcher& raymarcher, glm::vec2 pixel)
+	{
+		glm::vec4 dir = raymarcher.viewMatrix * glm::vec4(raymarcher.rayDirection(pixel), 0.0f);
+		Ray ray = { raymarcher.camera->position, glm::vec3(dir) };
+		return ray;
+	}
+
+	static MarchResult march(const Raymarcher& raymarcher, const Ray& ray)
+	{
+		return raymarcher.march(ray);
+	}
+};
+
+/**
+ * @brief Returns median of sorted times
+ */
+static double median(const std::vector<double>& sorted)
+{
+	size_t middle = sorted.size() / 2;
+	return sorted.size() % 2 ? sorted[middle] : 0.5 * (sorted[middle - 1] + sorted[middle]);
+}
+
+// results are accumulated here, so the compiler can not remove measured work
+static volatile float sink = 0.0f;
+
+static Camera createBenchmarkCamera()
+{
+	Camera camera(glm::vec3(0.0f, 2.5f, 5.0f), glm::vec3(0.0f, -0.5f, -1.0f), 45.0f);
+	camera.setView(benchmarkView);
+	return camera;
+}
+
+/**
+ * @brief Runs warmup and measured repetitions of the body
+ * @param items Number of items (points, rays, pixels) processed by one run of the body
+ */
+static void runCase(const BenchmarkSettings& settings, std::vector<BenchmarkResult>& results, const std::string& name,
+	const std::vector<std::pair<std::string, std::string>>& params, long long items, const std::function<void()>& body)
+{
+	BenchmarkResult result;
+	result.name = name;
+	result.params = params;
+	result.items = items;
+
+	std::string label = name;
+	for (const auto& param : params)
+		label += " " + param.first + "=" + param.second;
+
+	if (!settings.filter.empty() && label.find(settings.filter) == std::string::npos)
+		return;
+
+	for (int i = 0; i < settings.warmup; i++)
+		body();
+
+	for (int i = 0; i < settings.repetitions; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		body();
+		auto end = std::chrono::steady_clock::now();
+		result.times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	std::vector<double> sorted = result.times;
+	std::sort(sorted.begin(), sorted.end());
+	double medianTime = median(sorted);
+
+	printf("%-72s median %10.3f ms  min %10.3f ms  %10.2f ns/item\n", label.c_str(), medianTime, sorted.front(), medianTime * 1e6 / double(items));
+	fflush(stdout);
+
+	results.push_back(result);
+}
+
+static std::string toString(float value)
+{
+	std::ostringstream stream;
+	stream << value;
+	return stream.str();
+}
+
+static void benchmarkCPU(const BenchmarkSettings& settings, std::vector<BenchmarkResult>& results)
+{
+	std::vector<float> powers = { 8.0f, 7.5f };
+	std::vector<int> iterations = { 5, 10 };
+	std::vector<glm::ivec2> resolutions = { glm::ivec2(320, 180), glm::ivec2(640, 360), glm::ivec2(1280, 720) };
+
+	if (settings.quick)
+	{
+		powers = { 8.0f };
+		iterations = { 10 };
+		resolutions = { glm::ivec2(320, 180) };
+	}
+
+	Camera camera = createBenchmarkCamera();
+	Rendering rendering = defaultRendering();
+	Coloring coloring = defaultColoring();
+
+	// points are generated by fixed LCG, so every run measures the same work
+	std::vector<glm::vec3> points(sdfPoints);
+	uint32_t state = 12345;
+	for (glm::vec3& point : points)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			state = state * 1664525u + 1013904223u;
+			point[i] = (float(state >> 8) / float(1 << 24)) * 2.4f - 1.2f;
+		}
+	}
+
+	for (float power : powers)
+	{
+		for (int iteration : iterations)
+		{
+			Fractal fractal;
+			fractal.power = power;
+			fractal.iterations = iteration;
+
+			Raymarcher raymarcher(glm::vec2(rayGrid), &camera, &fractal, &rendering, &coloring);
+			std::vector<std::pair<std::string, std::string>> params = { { "power", toString(power) }, { "iterations", std::to_string(iteration) } };
+
+			runCase(settings, results, "mandelbulbSDF", params, sdfPoints, [&]() {
+				float sum = 0.0f;
+				for (const glm::vec3& point : points)
+					sum += RaymarcherBenchmark::mandelbulbSDF(raymarcher, point);
+				sink = sink + sum;
+			});
+
+			std::vector<Ray> rays;
+			for (int y = 0; y < rayGrid.y; y++)
+				for (int x = 0; x < rayGrid.x; x++)
+					rays.push_back(RaymarcherBenchmark::primaryRay(raymarcher, glm::vec2(x, y)));
+
+			runCase(settings, results, "trace", params, (long long)rays.size(), [&]() {
+				float sum = 0.0f;
+				for (const Ray& ray : rays)
+					sum += RaymarcherBenchmark::trace(raymarcher, ray).x;
+				sink = sink + sum;
+			});
+
+			// normals are estimated in the points where primary rays hit the fractal
+			std::vector<MarchResult> hits;
+			std::vector<glm::vec3> hitPoints;
+			for (const Ray& ray : rays)
+			{
+				MarchResult hit = RaymarcherBenchmark::march(raymarcher, ray);
+				if (hit.status == marchHit)
+				{
+					hits.push_back(hit);
+					hitPoints.push_back(ray.origin + hit.sampleDist * ray.dir);
+				}
+			}
+
+			if (!hits.empty())
+			{
+				runCase(settings, results, "estimateNormal", params, (long long)hits.size(), [&]() {
+					float sum = 0.0f;
+					for (size_t i = 0; i < hits.size(); i++)
+						sum += RaymarcherBenchmark::estimateNormal(raymarcher, hitPoints[i], hits[i].lastDist, hits[i].epsilon).x;
+					sink = sink + sum;
+				});
+			}
+		}
+	}
+
+	ThreadPool pool;
+
+	// baking of brick maps and tracing of rays which march them, bricks are baked on all threads
+	for (float power : powers)
+	{
+		for (int iteration : iterations)
+		{
+			for (int bricks : brickMapResolutions)
+			{
+				if (settings.quick && bricks != brickMapResolutions[1])
+					continue;
+
+				Fractal fractal;
+				fractal.power = power;
+				fractal.iterations = iteration;
+
+				Raymarcher raymarcher(glm::vec2(rayGrid), &camera, &fractal, &rendering, &coloring);
+				BrickMap brickMap;
+
+				std::vector<std::pair<std::string, std::string>> params = {
+					{ "power", toString(power) }, { "iterations", std::to_string(iteration) },
+					{ "bricks", std::to_string(bricks) }, { "threads", std::to_string(pool.getThreadCount()) } };
+
+				runCase(settings, results, "brickMapBake", params, (long long)bricks * bricks * bricks, [&]() {
+					brickMap.bake(fractal, bricks, pool);
+					sink = sink + float(brickMap.getBrickCount());
+				});
+
+				// trace needs the map even if baking is filtered out
+				if (!brickMap.matches(fractal, bricks))
+					brickMap.bake(fractal, bricks, pool);
+
+				raymarcher.setBrickMap(&brickMap);
+
+				std::vector<Ray> rays;
+				for (int y = 0; y < rayGrid.y; y++)
+					for (int x = 0; x < rayGrid.x; x++)
+						rays.push_back(RaymarcherBenchmark::primaryRay(raymarcher, glm::vec2(x, y)));
+
+				runCase(settings, results, "traceBrickMap", params, (long long)rays.size(), [&]() {
+					float sum = 0.0f;
+					for (const Ray& ray : rays)
+						sum += RaymarcherBenchmark::trace(raymarcher, ray).x;
+					sink = sink + sum;
+				});
+			}
+		}
+	}
+
+	// building of occupancy octrees and tracing of rays which skip their empty nodes, octree is built on all threads
+	for (float power : powers)
+	{
+		for (int iteration : iterations)
+		{
+			for (int leaves : occupancyResolutions)
+			{
+				if (settings.quick && leaves != occupancyResolutions[1])
+					continue;
+
+				Fractal fractal;
+				fractal.power = power;
+				fractal.iterations = iteration;
+
+				Raymarcher raymarcher(glm::vec2(rayGrid), &camera, &fractal, &rendering, &coloring);
+				OccupancyOctree octree;
+
+				std::vector<std::pair<std::string, std::string>> params = {
+					{ "power", toString(power) }, { "iterations", std::to_string(iteration) },
+					{ "leaves", std::to_string(leaves) }, { "threads", std::to_string(pool.getThreadCount()) } };
+
+				runCase(settings, results, "occupancyBuild", params, (long long)leaves * leaves * leaves, [&]() {
+					octree.build(fractal, leaves, pool);
+					sink = sink + octree.getEmptyFraction();
+				});
+
+				// trace needs the octree even if building is filtered out
+				if (!octree.matches(fractal, leaves))
+					octree.build(fractal, leaves, pool);
+
+				raymarcher.setOccupancyOctree(&octree);
+
+				std::vector<Ray> rays;
+				for (int y = 0; y < rayGrid.y; y++)
+					for (int x = 0; x < rayGrid.x; x++)
+						rays.push_back(RaymarcherBenchmark::primaryRay(raymarcher, glm::vec2(x, y)));
+
+				runCase(settings, results, "traceOctree", params, (long long)rays.size(), [&]() {
+					float sum = 0.0f;
+					for (const Ray& ray : rays)
+						sum += RaymarcherBenchmark::trace(raymarcher, ray).x;
+					sink = sink + sum;
+				});
+			}
+		}
+	}
+
+	// extraction of the surface including writing of the mesh, the file is removed afterwards
+	std::vector<int> meshResolutions = { 128, 256 };
+	if (settings.quick)
+		meshResolutions = { 128 };
+
+	for (float power : powers)
+	{
+		for (int cells : meshResolutions)
+		{
+			Fractal fractal = defaultFractal();
+			fractal.power = power;
+
+			MeshExtractor extractor(&pool);
+
+			std::vector<std::pair<std::string, std::string>> params = {
+				{ "power", toString(power) }, { "iterations", std::to_string(fractal.iterations) },
+				{ "cells", std::to_string(cells) }, { "threads", std::to_string(pool.getThreadCount()) } };
+
+			runCase(settings, results, "meshExtract", params, (long long)cells * cells * cells, [&]() {
+				MeshWriter writer;
+				writer.open(benchmarkMeshPath);
+				extractor.extract(fractal, cells, writer);
+				writer.close();
+				sink = sink + float(writer.getTriangleCount());
+			});
+
+			std::remove(benchmarkMeshPath);
+		}
+	}
+
+	TileRenderer tileRenderer(&pool);
+	std::vector<SimdLevel> simdLevels = { simdScalar };
+	if (detectSimdLevel() != simdScalar)
+		simdLevels.push_back(detectSimdLevel());
+
+	for (glm::ivec2 resolution : resolutions)
+	{
+		for (float power : powers)
+		{
+			for (int iteration : iterations)
+			{
+				for (SimdLevel simdLevel : simdLevels)
+				{
+					Fractal fractal;
+					fractal.power = power;
+					fractal.iterations = iteration;
+
+					Raymarcher raymarcher(glm::vec2(resolution), &camera, &fractal, &rendering, &coloring);
+					raymarcher.setSimdLevel(simdLevel);
+					std::vector<glm::vec4> data;
+
+					std::vector<std::pair<std::string, std::string>> params = {
+						{ "width", std::to_string(resolution.x) }, { "height", std::to_string(resolution.y) },
+						{ "power", toString(power) }, { "iterations", std::to_string(iteration) },
+						{ "simd", simdLevelToString(simdLevel) }, { "threads", std::to_string(pool.getThreadCount()) } };
+
+					runCase(settings, results, "cpuFrame", params, (long long)resolution.x * resolution.y, [&]() {
+						tileRenderer.render(raymarcher, resolution, data);
+						sink = sink + data[data.size() / 2].x;
+					});
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Creates hidden window with OpenGL context
+ * @return TRUE if context is available, else FALSE
+ */
+static bool createContext(GLFWwindow*& window)
+{
+	if (!glfwInit())
+		return false;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+	window = glfwCreateWindow(64, 64, "Benchmark", NULL, NULL);
+	if (window == NULL)
+	{
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return false;
+	}
+
+	return true;
+}
+
+static void benchmarkGPU(const BenchmarkSettings& settings, std::vector<BenchmarkResult>& results, std::string& glRenderer)
+{
+	GLFWwindow* window = NULL;
+	if (!createContext(window))
+	{
+		std::cout << "OpenGL context is not available, GPU benchmarks are skipped" << std::endl;
+		return;
+	}
+
+	glRenderer = (const char*)glGetString(GL_RENDERER);
+
+	std::vector<glm::ivec2> resolutions = { glm::ivec2(640, 360), glm::ivec2(1280, 720), glm::ivec2(1920, 1080) };
+	std::vector<int> iterations = { 5, 10 };
+
+	if (settings.quick)
+	{
+		resolutions = { glm::ivec2(640, 360) };
+		iterations = { 10 };
+	}
+
+	fs::path computeShaderPath = fs::u8path(ROOT_DIR);
+	computeShaderPath += fs::path("Shaders/compShader.comp");
+
+	{
+		ShaderManager shaderManager;
+		ParameterBuffer parameterBuffer;
+		Camera camera = createBenchmarkCamera();
+		Rendering rendering = defaultRendering();
+
+		// same variant as the default settings of the viewer, fields that are not set are zero, which disables them
+		ShaderVariant variant = ShaderVariant();
+		variant.fractalType = fractalMandelbulb;
+		variant.shadows = rendering.shadows;
+		variant.ambientOcclusion = rendering.ambientOcclusion;
+		GLuint program = shaderManager.getComputeProgram(computeShaderPath, variant);
+
+		// rays starting from depth of the cone prepass
+		ShaderVariant coneVariant = variant;
+		coneVariant.conePass = coneStart;
+		ShaderVariant prepassVariant = variant;
+		prepassVariant.shadows = false;
+		prepassVariant.ambientOcclusion = false;
+		prepassVariant.conePass = conePrepass;
+		GLuint coneProgram = shaderManager.getComputeProgram(computeShaderPath, coneVariant);
+		GLuint prepassProgram = shaderManager.getComputeProgram(computeShaderPath, prepassVariant);
+
+		// rays marching brick map far from the surface
+		ShaderVariant brickVariant = variant;
+		brickVariant.brickMap = true;
+		GLuint brickProgram = shaderManager.getComputeProgram(computeShaderPath, brickVariant);
+
+		// rays skipping empty nodes of occupancy octree
+		ShaderVariant octreeVariant = variant;
+		octreeVariant.occupancyOctree = true;
+		GLuint octreeProgram = shaderManager.getComputeProgram(computeShaderPath, octreeVariant);
+
+		// adaptive sampling, full subframes sum moments, compaction and list pass sample only noisy pixels
+		ShaderVariant fullVariant = variant;
+		fullVariant.adaptivePass = adaptiveFull;
+		ShaderVariant listVariant = variant;
+		listVariant.adaptivePass = adaptiveList;
+		ShaderVariant compactVariant = variant;
+		compactVariant.shadows = false;
+		compactVariant.ambientOcclusion = false;
+		compactVariant.adaptivePass = adaptiveCompact;
+		GLuint fullProgram = shaderManager.getComputeProgram(computeShaderPath, fullVariant);
+		GLuint listProgram = shaderManager.getComputeProgram(computeShaderPath, listVariant);
+		GLuint compactProgram = shaderManager.getComputeProgram(computeShaderPath, compactVariant);
+
+		if (program == 0 || coneProgram == 0 || prepassProgram == 0 || brickProgram == 0 || octreeProgram == 0 ||
+			fullProgram == 0 || listProgram == 0 || compactProgram == 0 || !parameterBuffer.create())
+		{
+			std::cout << "Failed to create compute program, GPU benchmarks are skipped" << std::endl;
+			glfwDestroyWindow(window);
+			glfwTerminate();
+			return;
+		}
+
+		ThreadPool pool;
+		BrickMap brickMap;
+		GLuint brickMapTextures[3] = { 0, 0, 0 };
+		OccupancyOctree octree;
+		GLuint octreeTexture = 0;
+		AdaptiveSampler adaptiveSampler;
+
+		for (glm::ivec2 resolution : resolutions)
+		{
+			GLuint frameBuffer = shaderManager.createTexture(resolution.x, resolution.y, 0, GL_WRITE_ONLY);
+			GLuint accumulationBuffer = shaderManager.createTexture(resolution.x, resolution.y, 1, GL_READ_WRITE);
+
+			glm::ivec2 workGroups = (resolution + tileDimensions - 1) / tileDimensions;
+			glm::ivec2 coneGroups = (workGroups + tileDimensions - 1) / tileDimensions;
+			GLuint coneBuffer = shaderManager.createTexture(workGroups.x, workGroups.y, 5, GL_READ_WRITE);
+			adaptiveSampler.create(resolution);
+
+			for (int iteration : iterations)
+			{
+				Fractal fractal;
+				fractal.power = 8.0f;
+				fractal.iterations = iteration;
+				ShaderParameters parameters = createShaderParameters(camera, fractal, rendering, defaultColoring(), resolution);
+
+				std::vector<std::pair<std::string, std::string>> params = {
+					{ "width", std::to_string(resolution.x) }, { "height", std::to_string(resolution.y) },
+					{ "power", toString(parameters.power) }, { "iterations", std::to_string(iteration) } };
+
+				// waiting for the dispatch is part of the measured time, so the time is the time of GPU work
+				runCase(settings, results, "gpuDispatch", params, (long long)resolution.x * resolution.y, [&]() {
+					glUseProgram(program);
+					parameterBuffer.upload(parameters);
+					glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+					glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+					parameterBuffer.frameSubmitted();
+					glFinish();
+				});
+
+				// prepass is part of the measured time
+				runCase(settings, results, "gpuDispatchCone", params, (long long)resolution.x * resolution.y, [&]() {
+					parameterBuffer.upload(parameters);
+					glUseProgram(prepassProgram);
+					glDispatchCompute(GLuint(coneGroups.x), GLuint(coneGroups.y), 1);
+					glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+					glUseProgram(coneProgram);
+					glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+					glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+					parameterBuffer.frameSubmitted();
+					glFinish();
+				});
+
+				for (int bricks : brickMapResolutions)
+				{
+					if (settings.quick && bricks != brickMapResolutions[1])
+						continue;
+
+					// baking is not part of the measured time
+					brickMap.bake(fractal, bricks, pool);
+					brickMap.upload(brickMapTextures);
+
+					ShaderParameters brickParameters = parameters;
+					brickMap.setParameters(brickParameters);
+
+					std::vector<std::pair<std::string, std::string>> brickParams = params;
+					brickParams.push_back({ "bricks", std::to_string(bricks) });
+
+					runCase(settings, results, "gpuDispatchBrickMap", brickParams, (long long)resolution.x * resolution.y, [&]() {
+						glUseProgram(brickProgram);
+						parameterBuffer.upload(brickParameters);
+						glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+						glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+						parameterBuffer.frameSubmitted();
+						glFinish();
+					});
+				}
+
+				for (int leaves : occupancyResolutions)
+				{
+					if (settings.quick && leaves != occupancyResolutions[1])
+						continue;
+
+					// building is not part of the measured time
+					octree.build(fractal, leaves, pool);
+					octree.upload(octreeTexture);
+
+					ShaderParameters octreeParameters = parameters;
+					octree.setParameters(octreeParameters);
+
+					std::vector<std::pair<std::string, std::string>> octreeParams = params;
+					octreeParams.push_back({ "leaves", std::to_string(leaves) });
+
+					runCase(settings, results, "gpuDispatchOctree", octreeParams, (long long)resolution.x * resolution.y, [&]() {
+						glUseProgram(octreeProgram);
+						parameterBuffer.upload(octreeParameters);
+						glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+						glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+						parameterBuffer.frameSubmitted();
+						glFinish();
+					});
+				}
+
+				// whole temporal antialiasing, adaptive sampling stops sampling pixels below default noise threshold
+				int subframes = benchmarkAntialiasing * benchmarkAntialiasing;
+				for (bool adaptive : { false, true })
+				{
+					runCase(settings, results, adaptive ? "gpuAccumulateAdaptive" : "gpuAccumulate", params, (long long)resolution.x * resolution.y * subframes, [&]() {
+						for (int subframe = 0; subframe < subframes; subframe++)
+						{
+							ShaderParameters subframeParameters = parameters;
+							subframeParameters.subframeID = subframe;
+							subframeParameters.subframeOffset = getStratifiedSubframeOffset(subframe, benchmarkAntialiasing);
+							subframeParameters.noiseThreshold = noiseThresholdDefault;
+							parameterBuffer.upload(subframeParameters);
+
+							if (adaptive && subframe >= adaptiveStartSubframes)
+							{
+								adaptiveSampler.compact(compactProgram, workGroups);
+								adaptiveSampler.dispatchList(listProgram);
+							}
+							else
+							{
+								glUseProgram(adaptive ? fullProgram : program);
+								glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+							}
+
+							glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+							parameterBuffer.frameSubmitted();
+						}
+						glFinish();
+					});
+				}
+			}
+
+			glDeleteTextures(1, &frameBuffer);
+			glDeleteTextures(1, &accumulationBuffer);
+			glDeleteTextures(1, &coneBuffer);
+			adaptiveSampler.destroy();
+		}
+
+		glDeleteTextures(3, brickMapTextures);
+		if (octreeTexture != 0)
+			glDeleteTextures(1, &octreeTexture);
+		parameterBuffer.destroy();
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+static std::string escapeJSON(const std::string& text)
+{
+	std::string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		if (c >= 0 && c < 0x20)
+			continue;
+		escaped += c;
+	}
+	return escaped;
+}
+
+static bool writeJSON(const std::string& path, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results, const std::string& glRenderer)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.precision(9);
+	file << "{\n";
+	file << "  \"version\": 1,\n";
+	file << "  \"simd\": \"" << simdLevelToString(detectSimdLevel()) << "\",\n";
+	file << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+	file << "  \"glRenderer\": \"" << escapeJSON(glRenderer) << "\",\n";
+	file << "  \"warmup\": " << settings.warmup << ",\n";
+	file << "  \"repetitions\": " << settings.repetitions << ",\n";
+	file << "  \"benchmarks\": [";
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+
+		std::vector<double> sorted = result.times;
+		std::sort(sorted.begin(), sorted.end());
+
+		double mean = 0.0;
+		for (double time : sorted)
+			mean += time;
+		mean /= double(sorted.size());
+
+		double variance = 0.0;
+		for (double time : sorted)
+			variance += (time - mean) * (time - mean);
+		double stddev = sorted.size() > 1 ? std::sqrt(variance / double(sorted.size() - 1)) : 0.0;
+
+		double medianTime = median(sorted);
+		int rank = std::max(int(std::ceil(0.95 * sorted.size())), 1);
+
+		file << (i ? ",\n" : "\n") << "    {\n";
+		file << "      \"name\": \"" << escapeJSON(result.name) << "\",\n";
+		file << "      \"params\": {";
+		for (size_t j = 0; j < result.params.size(); j++)
+			file << (j ? ", " : " ") << "\"" << escapeJSON(result.params[j].first) << "\": \"" << escapeJSON(result.params[j].second) << "\"";
+		file << " },\n";
+		file << "      \"items\": " << result.items << ",\n";
+		file << "      \"minMs\": " << sorted.front() << ",\n";
+		file << "      \"medianMs\": " << medianTime << ",\n";
+		file << "      \"meanMs\": " << mean << ",\n";
+		file << "      \"stddevMs\": " << stddev << ",\n";
+		file << "      \"p95Ms\": " << sorted[rank - 1] << ",\n";
+		file << "      \"maxMs\": " << sorted.back() << ",\n";
+		file << "      \"nsPerItem\": " << medianTime * 1e6 / double(result.items) << ",\n";
+		file << "      \"timesMs\": [";
+		for (size_t j = 0; j < result.times.size(); j++)
+			file << (j ? ", " : "") << result.times[j];
+		file << "]\n";
+		file << "    }";
+	}
+
+	file << "\n  ]\n}\n";
+
+	return file.good();
+}
+
+static void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+		<< "  --output <file.json>   write results as JSON\n"
+		<< "  --warmup <n>           unmeasured runs of every case (default 2)\n"
+		<< "  --repetitions <n>      measured runs of every case (default 10)\n"
+		<< "  --filter <text>        run only cases whose name and parameters contain the text\n"
+		<< "  --quick                run one configuration of every case\n"
+		<< "  --no-gpu               skip compute shader benchmarks\n";
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	settings.warmup = 2;
+	settings.repetitions = 10;
+	settings.quick = false;
+	settings.gpu = true;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string name = argv[i];
+
+		if (name == "--help" || name == "-h")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (name == "--quick")
+			settings.quick = true;
+		else if (name == "--no-gpu")
+			settings.gpu = false;
+		else if (i + 1 < argc && name == "--output")
+			settings.outputPath = argv[++i];
+		else if (i + 1 < argc && name == "--filter")
+			settings.filter = argv[++i];
+		else if (i + 1 < argc && name == "--warmup")
+			settings.warmup = std::max(0, atoi(argv[++i]));
+		else if (i + 1 < argc && name == "--repetitions")
+			settings.repetitions = std::max(1, atoi(argv[++i]));
+		else
+		{
+			std::cout << "Unknown argument " << name << std::endl;
+			printUsage(argv[0]);
+			return -1;
+		}
+	}
+
+	std::vector<BenchmarkResult> results;
+	std::string glRenderer;
+
+	benchmarkCPU(settings, results);
+
+	if (settings.gpu)
+		benchmarkGPU(settings, results, glRenderer);
+
+	if (!settings.outputPath.empty())
+	{
+		if (!writeJSON(settings.outputPath, settings, results, glRenderer))
+		{
+			std::cout << "Failed to write " << settings.outputPath << std::endl;
+			return -1;
+		}
+		std::cout << "Results written to " << settings.outputPath << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,455 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Regression.cpp
+ *
+ */
+
+#include "Raymarcher.h"
+#include "TileRenderer.h"
+#include "ShaderManager.h"
+#include "ParameterBuffer.h"
+#include "ImageWriter.h"
+#include "ImageCompare.h"
+#include "BrickMap.h"
+#include "OccupancyOctree.h"
+
+#include "helpers/RootDir.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// resolution of all regression images
+const glm::ivec2 regressionResolution = glm::ivec2(320, 180);
+
+// exit code of a run that could not render anything, ctest reports the test as skipped
+const int skippedExitCode = 77;
+
+/**
+ * @brief Canonical scene rendered by both raymarchers
+ */
+typedef struct regressionScene
+{
+	const char* name;
+	int view;
+	float power;
+	int iterations;
+	bool shadows;
+	bool ambientOcclusion;
+} RegressionScene;
+
+const RegressionScene regressionScenes[] = {
+	{ "view1", 0, 8.0f, 6, false, true },
+	{ "view2", 1, 8.0f, 6, false, true },
+	{ "view3_power7.5", 2, 7.5f, 6, false, true },
+	{ "view4_iterations12", 3, 8.0f, 12, false, true },
+	{ "view2_shadows", 1, 8.0f, 6, true, true },
+	{ "view1_no_ao", 0, 8.0f, 6, false, false },
+};
+
+/**
+ * @brief Settings given on command line
+ */
+typedef struct regressionSettings
+{
+	bool update;
+	bool cpu;
+	bool gpu;
+	bool parity;			// CPU and GPU images of a scene have to match each other too
+	bool scalar;			// CPU raymarcher does not use SIMD packets
+	bool coneMarching;		// GPU rays start from depth of the cone prepass
+	int brickMapResolution;	// bricks along the edge of brick map marched by both raymarchers, 0 if it is not used
+	int octreeResolution;	// leaves along the edge of occupancy octree used by both raymarchers, 0 if it is not used
+	bool deepZoom;			// rays are marched relative to the camera in double (CPU) and double-float (GPU) precision
+	float tolerance;
+	float maxBadPixels;		// fraction of pixels that can exceed the tolerance
+	float parityMaxBadPixels;	// fraction of pixels that can differ between CPU and GPU image
+	std::string referenceDir;
+} RegressionSettings;
+
+static Camera createSceneCamera(const RegressionScene& scene)
+{
+	Camera camera(glm::vec3(0.0f, 2.5f, 5.0f), glm::vec3(0.0f, -0.5f, -1.0f), 45.0f);
+	camera.setView(scene.view);
+	return camera;
+}
+
+static void getSceneParameters(const RegressionScene& scene, Fractal& fractal, Rendering& rendering)
+{
+	fractal = defaultFractal();
+	fractal.power = scene.power;
+	fractal.iterations = scene.iterations;
+
+	rendering = defaultRendering();
+	rendering.shadows = scene.shadows;
+	rendering.ambientOcclusion = scene.ambientOcclusion;
+}
+
+static void renderCPU(const RegressionSettings& settings, ThreadPool& pool, const RegressionScene& scene, std::vector<glm::vec4>& data)
+{
+	Camera camera = createSceneCamera(scene);
+	Fractal fractal;
+	Rendering rendering;
+	getSceneParameters(scene, fractal, rendering);
+
+	Coloring coloring = defaultColoring();
+
+	Raymarcher raymarcher(glm::vec2(regressionResolution), &camera, &fractal, &rendering, &coloring);
+	if (settings.scalar)
+		raymarcher.setSimdLevel(simdScalar);
+
+	BrickMap brickMap;
+	if (settings.brickMapResolution > 0)
+	{
+		brickMap.bake(fractal, settings.brickMapResolution, pool);
+		raymarcher.setBrickMap(&brickMap);
+	}
+
+	OccupancyOctree octree;
+	if (settings.octreeResolution > 0)
+	{
+		octree.build(fractal, settings.octreeResolution, pool);
+		raymarcher.setOccupancyOctree(&octree);
+	}
+
+	raymarcher.setDeepZoom(settings.deepZoom);
+
+	TileRenderer tileRenderer(&pool);
+	tileRenderer.render(raymarcher, regressionResolution, data);
+}
+
+static bool renderGPU(const RegressionSettings& settings, ShaderManager& shaderManager, ParameterBuffer& parameterBuffer, ThreadPool& pool, const RegressionScene& scene, std::vector<glm::vec4>& data)
+{
+	Camera camera = createSceneCamera(scene);
+	Fractal fractal;
+	Rendering rendering;
+	getSceneParameters(scene, fractal, rendering);
+
+	fs::path computeShaderPath = fs::u8path(ROOT_DIR);
+	computeShaderPath += fs::path("Shaders/compShader.comp");
+
+	bool useBrickMap = settings.brickMapResolution > 0;
+	bool useOctree = settings.octreeResolution > 0;
+
+	// fields that are not set are zero, which disables them
+	ShaderVariant variant = ShaderVariant();
+	variant.fractalType = fractalMandelbulb;
+	variant.shadows = rendering.shadows;
+	variant.ambientOcclusion = rendering.ambientOcclusion;
+	variant.conePass = settings.coneMarching ? coneStart : coneNone;
+	variant.brickMap = useBrickMap;
+	variant.occupancyOctree = useOctree;
+	variant.deepZoom = settings.deepZoom;
+	GLuint program = shaderManager.getComputeProgram(computeShaderPath, variant);
+
+	ShaderVariant prepassVariant = variant;
+	prepassVariant.shadows = false;
+	prepassVariant.ambientOcclusion = false;
+	prepassVariant.conePass = conePrepass;
+	prepassVariant.occupancyOctree = false;
+	GLuint prepassProgram = settings.coneMarching ? shaderManager.getComputeProgram(computeShaderPath, prepassVariant) : 0;
+
+	if (program == 0 || (settings.coneMarching && prepassProgram == 0))
+		return false;
+
+	glm::ivec2 workGroups = (regressionResolution + tileDimensions - 1) / tileDimensions;
+
+	GLuint frameBuffer = shaderManager.createTexture(regressionResolution.x, regressionResolution.y, 0, GL_WRITE_ONLY);
+	GLuint accumulationBuffer = shaderManager.createTexture(regressionResolution.x, regressionResolution.y, 1, GL_READ_WRITE);
+	GLuint coneBuffer = shaderManager.createTexture(workGroups.x, workGroups.y, 5, GL_READ_WRITE);
+
+	ShaderParameters parameters = createShaderParameters(camera, fractal, rendering, defaultColoring(), regressionResolution);
+
+	BrickMap brickMap;
+	GLuint brickMapTextures[3] = { 0, 0, 0 };
+	if (useBrickMap)
+	{
+		brickMap.bake(fractal, settings.brickMapResolution, pool);
+		brickMap.upload(brickMapTextures);
+		brickMap.setParameters(parameters);
+	}
+
+	OccupancyOctree octree;
+	GLuint octreeTexture = 0;
+	if (useOctree)
+	{
+		octree.build(fractal, settings.octreeResolution, pool);
+		octree.upload(octreeTexture);
+		octree.setParameters(parameters);
+	}
+
+	parameterBuffer.upload(parameters);
+
+	if (settings.coneMarching)
+	{
+		glm::ivec2 coneGroups = (workGroups + tileDimensions - 1) / tileDimensions;
+		glUseProgram(prepassProgram);
+		glDispatchCompute(GLuint(coneGroups.x), GLuint(coneGroups.y), 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	glUseProgram(program);
+	glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	parameterBuffer.frameSubmitted();
+
+	data.resize(size_t(regressionResolution.x) * regressionResolution.y);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, frameBuffer);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, data.data());
+
+	glDeleteTextures(1, &frameBuffer);
+	glDeleteTextures(1, &accumulationBuffer);
+	glDeleteTextures(1, &coneBuffer);
+	glDeleteTextures(3, brickMapTextures);
+	if (octreeTexture != 0)
+		glDeleteTextures(1, &octreeTexture);
+
+	return true;
+}
+
+/**
+ * @brief Creates hidden window with OpenGL context, software drivers such as llvmpipe are enough
+ * @return TRUE if context is available, else FALSE
+ */
+static bool createContext(GLFWwindow*& window)
+{
+	if (!glfwInit())
+		return false;
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+	window = glfwCreateWindow(64, 64, "Regression", NULL, NULL);
+	if (window == NULL)
+	{
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Prints comparison and returns whether it passed
+ * @param maxBadPixels Fraction of pixels that can exceed the tolerance
+ * @param enforced FALSE if failed comparison is only reported
+ */
+static bool reportDifference(const std::string& label, const ImageDifference& difference, float maxBadPixels, bool enforced = true)
+{
+	int pixels = regressionResolution.x * regressionResolution.y;
+	bool passed = difference.badPixels <= int(maxBadPixels * pixels);
+
+	printf("%-36s max %.4f  bad %6.3f %%  PSNR %7.2f dB  SSIM %.5f  %s\n", label.c_str(), difference.maxError,
+		100.0 * difference.badPixels / pixels, difference.psnr, difference.ssim, passed ? "ok" : (enforced ? "FAILED" : "differs"));
+	fflush(stdout);
+
+	return passed;
+}
+
+/**
+ * @brief Saves image as new reference or compares it with the stored one
+ * @return TRUE if image was saved or matches the reference, else FALSE
+ */
+static bool checkImage(const RegressionSettings& settings, const std::string& name, const std::vector<glm::vec4>& image)
+{
+	std::string referencePath = settings.referenceDir + "/" + name + ".pfm";
+
+	if (settings.update)
+	{
+		if (!saveImage(referencePath, regressionResolution.x, regressionResolution.y, image))
+		{
+			std::cout << "Failed to save " << referencePath << std::endl;
+			return false;
+		}
+
+		std::cout << "Saved " << referencePath << std::endl;
+		return true;
+	}
+
+	int width = 0, height = 0;
+	std::vector<glm::vec4> reference;
+	if (!loadPFM(referencePath, width, height, reference) || width != regressionResolution.x || height != regressionResolution.y)
+	{
+		std::cout << name << ": missing reference " << referencePath << ", create it with --update" << std::endl;
+		return false;
+	}
+
+	ImageDifference difference = compareImages(image, reference, width, height, settings.tolerance);
+	if (reportDifference(name, difference, settings.maxBadPixels))
+		return true;
+
+	// rendered image is kept next to the reference for inspection
+	saveImage(settings.referenceDir + "/" + name + ".actual.pfm", width, height, image);
+	return false;
+}
+
+static void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+		<< "Renders canonical scenes with CPU and GPU raymarcher and compares them with reference images.\n"
+		<< "  --update               save rendered images as new references\n"
+		<< "  --references <dir>     directory with reference images (default Regression/references of the repository)\n"
+		<< "  --tolerance <value>    largest channel difference of a good pixel (default 0.008)\n"
+		<< "  --max-bad <fraction>   fraction of pixels that can exceed the tolerance (default 0.001)\n"
+		<< "  --parity               CPU and GPU images of scenes with integer power have to match each other too\n"
+		<< "  --parity-max-bad <fraction> fraction of pixels that can differ between CPU and GPU (default 0.005)\n"
+		<< "  --scalar               CPU raymarcher does not use SIMD packets\n"
+		<< "  --cpu-only             render only with CPU raymarcher\n"
+		<< "  --gpu-only             render only with compute shader\n"
+		<< "  --cone-prepass         compute shader starts rays from depth of the cone prepass, looser tolerance is needed\n"
+		<< "  --brick-map <bricks>   rays march brick map with given bricks along its edge (16, 32 or 64), looser tolerance is needed,\n"
+		<< "                         CPU raymarcher uses it only with --scalar\n"
+		<< "  --octree <leaves>      rays skip empty nodes of occupancy octree with given leaves along its edge (64, 128 or 256),\n"
+		<< "                         looser tolerance is needed, CPU raymarcher uses it only with --scalar\n"
+		<< "  --deep-zoom            rays are marched relative to the camera in double (CPU) and double-float (GPU),\n"
+		<< "                         looser tolerance is needed, CPU raymarcher does not use SIMD packets\n";
+}
+
+int main(int argc, char** argv)
+{
+	RegressionSettings settings;
+	settings.update = false;
+	settings.cpu = true;
+	settings.gpu = true;
+	settings.parity = false;
+	settings.scalar = false;
+	settings.coneMarching = false;
+	settings.brickMapResolution = 0;
+	settings.octreeResolution = 0;
+	settings.deepZoom = false;
+	settings.tolerance = 2.0f / 255.0f;
+	settings.maxBadPixels = 0.001f;
+	settings.parityMaxBadPixels = 0.005f;
+	settings.referenceDir = std::string(ROOT_DIR) + "Regression/references";
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string name = argv[i];
+
+		if (name == "--help" || name == "-h")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (name == "--update")
+			settings.update = true;
+		else if (name == "--parity")
+			settings.parity = true;
+		else if (name == "--scalar")
+			settings.scalar = true;
+		else if (name == "--cpu-only")
+			settings.gpu = false;
+		else if (name == "--gpu-only")
+			settings.cpu = false;
+		else if (name == "--cone-prepass")
+			settings.coneMarching = true;
+		else if (name == "--deep-zoom")
+			settings.deepZoom = true;
+		else if (i + 1 < argc && name == "--brick-map")
+			settings.brickMapResolution = atoi(argv[++i]);
+		else if (i + 1 < argc && name == "--octree")
+			settings.octreeResolution = atoi(argv[++i]);
+		else if (i + 1 < argc && name == "--references")
+			settings.referenceDir = argv[++i];
+		else if (i + 1 < argc && name == "--tolerance")
+			settings.tolerance = float(atof(argv[++i]));
+		else if (i + 1 < argc && name == "--max-bad")
+			settings.maxBadPixels = float(atof(argv[++i]));
+		else if (i + 1 < argc && name == "--parity-max-bad")
+			settings.parityMaxBadPixels = float(atof(argv[++i]));
+		else
+		{
+			std::cout << "Unknown argument " << name << std::endl;
+			printUsage(argv[0]);
+			return -1;
+		}
+	}
+
+	std::error_code error;
+	fs::create_directories(fs::u8path(settings.referenceDir), error);
+
+	GLFWwindow* window = NULL;
+	if (settings.gpu && !createContext(window))
+	{
+		std::cout << "OpenGL context is not available, GPU images can not be checked" << std::endl;
+		return skippedExitCode;
+	}
+
+	bool passed = true;
+
+	{
+		ThreadPool pool;
+		ShaderManager shaderManager;
+		ParameterBuffer parameterBuffer;
+
+		if (settings.gpu && !parameterBuffer.create())
+		{
+			std::cout << "Failed to create parameter buffer" << std::endl;
+			return 1;
+		}
+
+		for (const RegressionScene& scene : regressionScenes)
+		{
+			std::vector<glm::vec4> cpuImage;
+			std::vector<glm::vec4> gpuImage;
+
+			if (settings.cpu)
+			{
+				renderCPU(settings, pool, scene, cpuImage);
+				passed &= checkImage(settings, std::string(scene.name) + ".cpu", cpuImage);
+			}
+
+			if (settings.gpu)
+			{
+				if (!renderGPU(settings, shaderManager, parameterBuffer, pool, scene, gpuImage))
+				{
+					std::cout << scene.name << ": failed to create compute program" << std::endl;
+					passed = false;
+					continue;
+				}
+				passed &= checkImage(settings, std::string(scene.name) + ".gpu", gpuImage);
+			}
+
+			// drift between raymarchers is always reported, it fails the run only with --parity,
+			// fractional powers use pow, acos and atan whose precision differs between GL implementations
+			if (settings.cpu && settings.gpu)
+			{
+				bool enforced = settings.parity && getIntegerPower(scene.power) != 0;
+
+				ImageDifference difference = compareImages(cpuImage, gpuImage, regressionResolution.x, regressionResolution.y, settings.tolerance);
+				bool same = reportDifference(std::string(scene.name) + " cpu-gpu", difference, settings.parityMaxBadPixels, enforced);
+				if (enforced)
+					passed &= same;
+			}
+		}
+
+		if (settings.gpu)
+			parameterBuffer.destroy();
+	}
+
+	if (window != NULL)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	std::cout << (passed ? "All images match" : "Some images differ") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -13,7 +13,16 @@ in vec2 texPosition;
 out vec4 fragmentColor;
 layout (binding = 0) uniform sampler2D img;
 
+// frames rendered in lower resolution have one pixel per PixelScale x PixelScale block of the window,
+// they are stored in the RenderSize corner of the image and upsampled here
+layout (location = 0) uniform float PixelScale;
+layout (location = 1) uniform vec2 RenderSize;
+
 void main()
 {
-	fragmentColor = texture(img, texPosition);
+	vec2 size = vec2(textureSize(img, 0));
+
+	// filtering does not reach texels outside of the rendered corner
+	vec2 position = min(texPosition * size / PixelScale, RenderSize - 0.5);
+	fragmentColor = texture(img, position / size);
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	AdaptiveSampler.cpp
+ *
+ */
+
+#include "AdaptiveSampler.h"
+
+// work groups of the indirect dispatch and number of pixels in front of the pixels of the work list
+const GLsizeiptr workListHeaderSize = 4 * sizeof(GLuint);
+
+glm::vec2 getStratifiedSubframeOffset(int subframe, int antialiasing)
+{
+	int bits = 0;
+	while ((1 << bits) < antialiasing)
+		bits++;
+
+	if ((1 << bits) != antialiasing)
+		return glm::vec2(float(subframe / antialiasing), float(subframe % antialiasing)) / float(antialiasing);
+
+	// bits of the subframe are reversed, so consecutive subframes are far apart, and dealt alternately to y and x
+	int reversed = 0;
+	for (int bit = 0; bit < 2 * bits; bit++)
+	{
+		if (subframe & (1 << bit))
+			reversed |= 1 << (2 * bits - 1 - bit);
+	}
+
+	glm::ivec2 cell = glm::ivec2(0);
+	for (int bit = 0; bit < bits; bit++)
+	{
+		cell.x |= ((reversed >> (2 * bit)) & 1) << bit;
+		cell.y |= ((reversed >> (2 * bit + 1)) & 1) << bit;
+	}
+
+	return glm::vec2(cell) / float(antialiasing);
+}
+
+AdaptiveSampler::AdaptiveSampler()
+{
+	momentTexture = 0;
+	workList = 0;
+}
+
+void AdaptiveSampler::create(glm::ivec2 resolution)
+{
+	destroy();
+
+	glGenTextures(1, &momentTexture);
+	glActiveTexture(GL_TEXTURE0 + momentUnit);
+	glBindTexture(GL_TEXTURE_2D, momentTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, resolution.x, resolution.y, 0, GL_RGBA, GL_FLOAT, NULL);
+	glBindImageTexture(momentUnit, momentTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+	glActiveTexture(GL_TEXTURE0);
+
+	GLsizeiptr size = workListHeaderSize + GLsizeiptr(resolution.x) * resolution.y * sizeof(GLuint);
+
+	glGenBuffers(1, &workList);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, workList);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void AdaptiveSampler::destroy()
+{
+	glDeleteTextures(1, &momentTexture);
+	glDeleteBuffers(1, &workList);
+	momentTexture = 0;
+	workList = 0;
+}
+
+void AdaptiveSampler::compact(GLuint program, glm::ivec2 workGroups)
+{
+	// empty list is a dispatch of no work groups
+	const GLuint header[4] = { 0, 1, 1, 0 };
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, workList);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, workListHeaderSize, header);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, workListBinding, workList);
+
+	glUseProgram(program);
+	glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+
+	// list pass reads its work groups as a command and its pixels from the buffer
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void AdaptiveSampler::dispatchList(GLuint program)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, workListBinding, workList);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, workList);
+
+	glUseProgram(program);
+	glDispatchComputeIndirect(0);
+
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
+
+GLuint AdaptiveSampler::readPixelCount() const
+{
+	GLuint count = 0;
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, workList);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 3 * sizeof(GLuint), sizeof(GLuint), &count);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	return count;
+}
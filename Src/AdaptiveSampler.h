@@ -0,0 +1,86 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	AdaptiveSampler.h
+ *
+ */
+
+#pragma once
+
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// image unit of moment texture in compute shader
+const GLuint momentUnit = 6;
+
+// binding point of the WorkList storage block in compute shader
+const GLuint workListBinding = 0;
+
+// subframes sampled in every pixel before adaptive sampling samples only noisy pixels
+const int adaptiveStartSubframes = 4;
+
+// standard error of mean luminance below which pixels are not sampled anymore by default, about one step of 8-bit color
+const float noiseThresholdDefault = 0.004f;
+
+/**
+ * @brief Returns subframe offset of temporal antialiasing in stratified order
+ * Offsets are the same AA x AA grid as in sequential order, but every prefix of the subframes covers the pixel evenly,
+ * the first four subframes sample all four quadrants. Antialiasing which is not a power of two keeps sequential order.
+ * @param subframe Number of the subframe, 0 to AA*AA - 1
+ * @param antialiasing Number of samples along the side of the pixel
+ * @return Offset in [0, 1) in both axes
+ */
+glm::vec2 getStratifiedSubframeOffset(int subframe, int antialiasing);
+
+/**
+ * @brief Buffers of adaptive sampling of temporal antialiasing
+ * Full subframes sample every pixel and sum moments of the luminance of its samples to moment texture.
+ * Compaction pass then appends pixels whose mean is still noisy to the work list and counts work groups
+ * of the list pass in the same buffer, so the list pass is dispatched indirectly and CPU never waits for the list.
+ */
+class AdaptiveSampler
+{
+public:
+	AdaptiveSampler();
+
+	/**
+	 * @brief Creates moment texture bound to momentUnit and work list large enough for every pixel
+	 * Buffers of previous resolution are deleted.
+	 */
+	void create(glm::ivec2 resolution);
+
+	void destroy();
+
+	/**
+	 * @brief Clears the work list and appends noisy pixels to it
+	 * Moments written by previous dispatches have to be visible, compaction waits only for its own writes.
+	 * @param program Compaction variant of compute program
+	 * @param workGroups Work groups of the full pass
+	 */
+	void compact(GLuint program, glm::ivec2 workGroups);
+
+	/**
+	 * @brief Dispatches list pass over pixels of the work list, number of work groups is taken from the list
+	 * @param program List variant of compute program
+	 */
+	void dispatchList(GLuint program);
+
+	/**
+	 * @brief Returns number of pixels in the work list, waits for the last compaction
+	 */
+	GLuint readPixelCount() const;
+
+private:
+	// sum of luminances, sum of their squares and number of samples of every pixel
+	GLuint momentTexture;
+
+	// indirect dispatch of the list pass, number of pixels and the pixels
+	GLuint workList;
+};
+
+#endif // !ADAPTIVE_SAMPLER_H
@@ -0,0 +1,259 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	BrickMap.cpp
+ *
+ */
+
+#include "BrickMap.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// number of distance samples in one brick
+const size_t brickSampleCount = size_t(brickSamples) * brickSamples * brickSamples;
+
+// largest number of bricks along an axis of the atlas, 2048 is the smallest GL_MAX_3D_TEXTURE_SIZE of OpenGL 4.3
+const int atlasBricksMax = 2048 / brickSamples;
+
+// number of bricks with samples baked by one task
+const size_t bakeChunkBricks = 64;
+
+BrickMap::BrickMap()
+{
+	fractal = defaultFractal();
+	resolution = 0;
+	brickSize = 0.0f;
+	sampleSpacing = 0.0f;
+}
+
+void BrickMap::bake(const Fractal& fractal, int resolution, ThreadPool& pool)
+{
+	this->fractal = fractal;
+	this->resolution = resolution;
+	brickSize = 2.0f * brickMapExtent / float(resolution);
+	sampleSpacing = brickSize / float(brickSamples - 1);
+
+	int integerPower = getIntegerPower(fractal.power);
+	int cornersPerAxis = resolution + 1;
+
+	corners.assign(size_t(cornersPerAxis) * cornersPerAxis * cornersPerAxis, 0.0f);
+
+	// corners are sampled one slice per task
+	for (int z = 0; z < cornersPerAxis; z++)
+	{
+		pool.submit([this, z, integerPower, cornersPerAxis]()
+		{
+			for (int y = 0; y < cornersPerAxis; y++)
+			{
+				for (int x = 0; x < cornersPerAxis; x++)
+				{
+					glm::vec3 corner = glm::vec3(float(x), float(y), float(z)) * brickSize - brickMapExtent;
+					corners[(size_t(z) * cornersPerAxis + y) * cornersPerAxis + x] = mandelbulbDistance(this->fractal, integerPower, corner);
+				}
+			}
+		});
+	}
+	pool.wait();
+
+	// every point of a brick is at most half of the diagonal from the nearest corner,
+	// so surface can pass only through bricks with a corner closer than that
+	float halfDiagonal = 0.5f * sqrt(3.0f) * brickSize;
+
+	std::vector<size_t> slotCells;
+	index.assign(size_t(resolution) * resolution * resolution, -1);
+
+	for (int z = 0; z < resolution; z++)
+	{
+		for (int y = 0; y < resolution; y++)
+		{
+			for (int x = 0; x < resolution; x++)
+			{
+				float nearest = corners[(size_t(z) * cornersPerAxis + y) * cornersPerAxis + x];
+				for (int corner = 1; corner < 8; corner++)
+				{
+					size_t i = (size_t(z + (corner >> 2)) * cornersPerAxis + y + ((corner >> 1) & 1)) * cornersPerAxis + x + (corner & 1);
+					nearest = std::min(nearest, corners[i]);
+				}
+
+				if (nearest <= halfDiagonal)
+				{
+					size_t cell = (size_t(z) * resolution + y) * resolution + x;
+					index[cell] = int(slotCells.size());
+					slotCells.push_back(cell);
+				}
+			}
+		}
+	}
+
+	atlas.assign(slotCells.size() * brickSampleCount, 0.0f);
+
+	// neighbouring bricks share border samples, so interpolation is continuous across bricks
+	for (size_t first = 0; first < slotCells.size(); first += bakeChunkBricks)
+	{
+		pool.submit([this, first, integerPower, &slotCells]()
+		{
+			size_t last = std::min(first + bakeChunkBricks, slotCells.size());
+			size_t res = size_t(this->resolution);
+
+			for (size_t slot = first; slot < last; slot++)
+			{
+				size_t cell = slotCells[slot];
+				glm::vec3 brick = glm::vec3(float(cell % res), float((cell / res) % res), float(cell / (res * res)));
+				glm::vec3 corner = brick * brickSize - brickMapExtent;
+				float* samples = &atlas[slot * brickSampleCount];
+
+				for (int z = 0; z < brickSamples; z++)
+					for (int y = 0; y < brickSamples; y++)
+						for (int x = 0; x < brickSamples; x++)
+							*samples++ = mandelbulbDistance(this->fractal, integerPower, corner + glm::vec3(float(x), float(y), float(z)) * sampleSpacing);
+			}
+		});
+	}
+	pool.wait();
+}
+
+bool BrickMap::matches(const Fractal& fractal, int resolution) const
+{
+	return this->resolution == resolution && this->fractal.power == fractal.power && this->fractal.iterations == fractal.iterations;
+}
+
+/**
+ * @brief Trilinear interpolation in a grid of samples with x changing fastest
+ * @param position Position in the grid in units of sample spacing, it has to be inside the grid
+ */
+static float interpolate(const float* samples, int size, glm::vec3 position)
+{
+	glm::ivec3 s = glm::min(glm::ivec3(position), glm::ivec3(size - 2));
+	glm::vec3 t = position - glm::vec3(s);
+
+	size_t first = (size_t(s.z) * size + s.y) * size + s.x;
+	size_t dy = size_t(size);
+	size_t dz = size_t(size) * size;
+
+	float x00 = glm::mix(samples[first], samples[first + 1], t.x);
+	float x10 = glm::mix(samples[first + dy], samples[first + dy + 1], t.x);
+	float x01 = glm::mix(samples[first + dz], samples[first + dz + 1], t.x);
+	float x11 = glm::mix(samples[first + dz + dy], samples[first + dz + dy + 1], t.x);
+
+	return glm::mix(glm::mix(x00, x10, t.y), glm::mix(x01, x11, t.y), t.z);
+}
+
+float BrickMap::distance(glm::vec3 point) const
+{
+	glm::vec3 cell = (point + brickMapExtent) / brickSize;
+
+	// space outside the cube is outside the bounding sphere too
+	float lowest = glm::min(glm::min(cell.x, cell.y), cell.z);
+	float highest = glm::max(glm::max(cell.x, cell.y), cell.z);
+	if (lowest < 0.0f || highest >= float(resolution))
+		return glm::max(glm::length(point) - brickMapExtent, 0.0f);
+
+	glm::ivec3 brick = glm::ivec3(cell);
+	int slot = index[(size_t(brick.z) * resolution + brick.y) * resolution + brick.x];
+
+	// interpolated distance exceeds the exact one by at most half of the diagonal of the interpolation cell,
+	// it is lowered by that, so it stays a lower bound even in bricks with only corner samples
+	if (slot < 0)
+		return interpolate(corners.data(), resolution + 1, cell) - 0.5f * sqrt(3.0f) * brickSize;
+
+	glm::vec3 local = (cell - glm::vec3(brick)) * float(brickSamples - 1);
+	return interpolate(&atlas[size_t(slot) * brickSampleCount], brickSamples, local) - 0.5f * sqrt(3.0f) * sampleSpacing;
+}
+
+float BrickMap::getNearDistance() const
+{
+	return 2.0f * sampleSpacing;
+}
+
+int BrickMap::getResolution() const
+{
+	return resolution;
+}
+
+size_t BrickMap::getBrickCount() const
+{
+	return atlas.size() / brickSampleCount;
+}
+
+size_t BrickMap::getMemorySize() const
+{
+	return index.size() * sizeof(int) + (corners.size() + atlas.size()) * sizeof(float);
+}
+
+void BrickMap::upload(GLuint textures[3]) const
+{
+	glm::ivec3 atlasBricks = getAtlasBricks();
+	glm::ivec3 atlasSize = atlasBricks * brickSamples;
+
+	// bricks are placed in the atlas texture in the order of their slots
+	std::vector<float> texels(size_t(atlasSize.x) * atlasSize.y * atlasSize.z, 0.0f);
+	for (size_t slot = 0; slot < getBrickCount(); slot++)
+	{
+		glm::ivec3 brick = glm::ivec3(int(slot % atlasBricks.x), int((slot / atlasBricks.x) % atlasBricks.y), int(slot / (atlasBricks.x * atlasBricks.y)));
+		glm::ivec3 origin = brick * brickSamples;
+
+		for (int z = 0; z < brickSamples; z++)
+		{
+			for (int y = 0; y < brickSamples; y++)
+			{
+				const float* row = &atlas[slot * brickSampleCount + (size_t(z) * brickSamples + y) * brickSamples];
+				size_t texel = (size_t(origin.z + z) * atlasSize.y + origin.y + y) * atlasSize.x + origin.x;
+				std::copy(row, row + brickSamples, texels.begin() + texel);
+			}
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (textures[i] == 0)
+			glGenTextures(1, &textures[i]);
+	}
+
+	glActiveTexture(GL_TEXTURE0 + brickIndexUnit);
+	glBindTexture(GL_TEXTURE_3D, textures[0]);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R32I, resolution, resolution, resolution, 0, GL_RED_INTEGER, GL_INT, index.data());
+
+	// corners and bricks are interpolated by texture unit, bricks are sampled only between their border texels
+	int cornersPerAxis = resolution + 1;
+	GLuint units[2] = { brickCornerUnit, brickAtlasUnit };
+	glm::ivec3 sizes[2] = { glm::ivec3(cornersPerAxis), atlasSize };
+	const float* data[2] = { corners.data(), texels.data() };
+
+	for (int i = 0; i < 2; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_3D, textures[i + 1]);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_R32F, sizes[i].x, sizes[i].y, sizes[i].z, 0, GL_RED, GL_FLOAT, data[i]);
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void BrickMap::setParameters(ShaderParameters& parameters) const
+{
+	parameters.brickExtent = brickMapExtent;
+	parameters.brickResolution = resolution;
+	parameters.brickSize = brickSize;
+	parameters.brickNearDistance = getNearDistance();
+}
+
+glm::ivec3 BrickMap::getAtlasBricks() const
+{
+	int bricks = std::max(int(getBrickCount()), 1);
+
+	glm::ivec3 atlasBricks;
+	atlasBricks.x = std::min(bricks, atlasBricksMax);
+	atlasBricks.y = std::min((bricks + atlasBricks.x - 1) / atlasBricks.x, atlasBricksMax);
+	atlasBricks.z = (bricks + atlasBricks.x * atlasBricks.y - 1) / (atlasBricks.x * atlasBricks.y);
+	return atlasBricks;
+}
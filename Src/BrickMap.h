@@ -0,0 +1,121 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	BrickMap.h
+ *
+ */
+
+#pragma once
+
+#ifndef BRICK_MAP_H
+#define BRICK_MAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "ParameterBuffer.h"
+#include "Raymarcher.h"
+#include "ThreadPool.h"
+
+// number of distance samples along the edge of a brick, same as BRICK_SAMPLES in compute shader
+const int brickSamples = 8;
+
+// half of the edge of the cube covered by brick map, cube contains bounding sphere of the mandelbulb
+const float brickMapExtent = 1.2f;
+
+// numbers of bricks along the edge of the cube selectable in GUI
+const int brickMapResolutions[] = { 16, 32, 64 };
+
+// texture units of brick map textures in compute shader
+const GLuint brickIndexUnit = 1;
+const GLuint brickCornerUnit = 2;
+const GLuint brickAtlasUnit = 3;
+
+/**
+ * @brief Distance estimation of the mandelbulb sampled in a sparse grid of bricks
+ * Cube around the fractal is divided into bricks and distance is sampled in their corners.
+ * Only bricks that the surface can pass through store distances sampled in brickSamples^3 points.
+ * Distances are interpolated from the samples, so rays can march the map far from the surface,
+ * where the interpolation error is small compared to the distance, and switch to exact distance estimation near it.
+ */
+class BrickMap
+{
+public:
+	BrickMap();
+
+	/**
+	 * @brief Samples distance estimation of the fractal, previous content of the map is replaced
+	 * @param fractal Parameters of the mandelbulb
+	 * @param resolution Number of bricks along the edge of the cube
+	 * @param pool Threads that sample the bricks
+	 */
+	void bake(const Fractal& fractal, int resolution, ThreadPool& pool);
+
+	/**
+	 * @brief Returns TRUE if the map was baked for given fractal and resolution
+	 */
+	bool matches(const Fractal& fractal, int resolution) const;
+
+	/**
+	 * @brief Returns interpolated distance estimation in a point, same as cachedSDF in compute shader
+	 * Distance is lowered by the largest interpolation error, so it never exceeds the exact distance.
+	 * Distances smaller than getNearDistance() are not accurate enough and have to be computed exactly.
+	 */
+	float distance(glm::vec3 point) const;
+
+	/**
+	 * @brief Returns distance below which the map is not accurate enough for marching
+	 */
+	float getNearDistance() const;
+
+	int getResolution() const;
+
+	/**
+	 * @brief Returns number of bricks with sampled distances
+	 */
+	size_t getBrickCount() const;
+
+	/**
+	 * @brief Returns size of the map in bytes
+	 */
+	size_t getMemorySize() const;
+
+	/**
+	 * @brief Copies the map to 3D textures bound to brickIndexUnit, brickCornerUnit and brickAtlasUnit
+	 * Textures are created if they are 0, otherwise their content is replaced.
+	 * @param textures Index, corner and atlas texture
+	 */
+	void upload(GLuint textures[3]) const;
+
+	/**
+	 * @brief Sets parameters of the map used by compute shader
+	 */
+	void setParameters(ShaderParameters& parameters) const;
+
+private:
+	// fractal and resolution of the baked map
+	Fractal fractal;
+	int resolution;
+
+	// edge of a brick and distance between its samples
+	float brickSize;
+	float sampleSpacing;
+
+	// slot of every brick in the atlas, -1 for bricks without samples
+	std::vector<int> index;
+
+	// distances in the corners of the bricks, (resolution + 1)^3 samples with x changing fastest
+	std::vector<float> corners;
+
+	// samples of the bricks ordered by slots, brickSamples^3 samples per brick with x changing fastest
+	std::vector<float> atlas;
+
+	/**
+	 * @brief Returns number of bricks along every axis of the atlas texture
+	 */
+	glm::ivec3 getAtlasBricks() const;
+};
+
+#endif // !BRICK_MAP_H
@@ -12,12 +12,14 @@
 Camera::Camera(glm::vec3 initPosition, glm::vec3 lookAt, GLfloat vFov)
 {
 	position = initPosition;
+	precisePosition = glm::dvec3(initPosition);
 	frontVector = glm::normalize(lookAt - position);//glm::vec3(0.0f, 0.0f, -1.0f);
 	rightVector = glm::normalize(glm::cross(frontVector, worldUp));
 	upVector = glm::normalize(glm::cross(rightVector, frontVector));
 
 	yaw = glm::degrees(atan2(frontVector.x, frontVector.z));
 	pitch = glm::degrees(asin(frontVector.y));
+	speedScale = 1.0f;
 	cameraChanged = true;
 
 	this->vFov = tan(glm::radians(vFov) /2.0f);
@@ -25,30 +27,32 @@ Camera::Camera(glm::vec3 initPosition, glm::vec3 lookAt, GLfloat vFov)
 
 void Camera::updatePosition(Direction direction, float deltaTime)
 {
-	GLfloat cameraSpeed = speed * deltaTime;
+	// steps far below the precision of float accumulate in double
+	double cameraSpeed = double(speed * speedScale * deltaTime);
 
 	switch (direction)
 	{
 	case forward:
-		position += frontVector * cameraSpeed;
+		precisePosition += glm::dvec3(frontVector) * cameraSpeed;
 		break;
 	case backward:
-		position -= frontVector * cameraSpeed;
+		precisePosition -= glm::dvec3(frontVector) * cameraSpeed;
 		break;
 	case left:
-		position -= rightVector * cameraSpeed;
+		precisePosition -= glm::dvec3(rightVector) * cameraSpeed;
 		break;
 	case right:
-		position += rightVector * cameraSpeed;
+		precisePosition += glm::dvec3(rightVector) * cameraSpeed;
 		break;
 	case up:
-		position += upVector * cameraSpeed;
+		precisePosition += glm::dvec3(upVector) * cameraSpeed;
 		break;
 	case down:
-		position -= upVector * cameraSpeed;
+		precisePosition -= glm::dvec3(upVector) * cameraSpeed;
 		break;
 	}
 
+	position = glm::vec3(precisePosition);
 	cameraChanged = true;
 }
 
@@ -87,9 +91,15 @@ void Camera::setView(int id)
 
 	if ((id < 0) || (id > 3)) id = 0;
 
-	this->position = position[id];
-	this->pitch = pitch[id];
-	this->yaw = yaw[id];
+	setPose(position[id], yaw[id], pitch[id]);
+}
+
+void Camera::setPose(glm::vec3 position, GLfloat yaw, GLfloat pitch)
+{
+	this->position = position;
+	this->precisePosition = glm::dvec3(position);
+	this->pitch = pitch;
+	this->yaw = yaw;
 	updateVectors();
 	cameraChanged = true;
 }
@@ -64,8 +64,18 @@ public:
 	 */
 	void setView(int id);
 
+	/**
+	 * @brief Sets position and rotation of the camera
+	 * @param position Position of the camera in world coordinates
+	 * @param yaw Rotation around y axis in degrees
+	 * @param pitch Rotation around x axis in degrees
+	 */
+	void setPose(glm::vec3 position, GLfloat yaw, GLfloat pitch);
+
 	// position of the camera in world coordinates
 	glm::vec3 position;
+	// position of the camera in double precision, position is its rounded copy
+	glm::dvec3 precisePosition;
 	// vector pointing forward from camera
 	glm::vec3 frontVector;
 	// vector pointing to the right from camera
@@ -78,6 +88,9 @@ public:
 	// camera angles
 	GLfloat yaw, pitch;
 
+	// multiplier of the speed, deep zoom slows the camera down near the surface
+	GLfloat speedScale;
+
 	// indicates whether camera position or rotation changed 
 	bool cameraChanged;
 
@@ -0,0 +1,323 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	CameraPath.cpp
+ *
+ */
+
+#include "CameraPath.h"
+#include "ShaderManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+const char pathMagic[8] = { 'F', 'R', 'A', 'C', 'P', 'A', 'T', 'H' };
+const uint32_t pathVersion = 1;
+
+// number of preset views of the camera
+const int cameraViews = 4;
+
+typedef struct pathHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t frameCount;
+	uint32_t stateSize;
+	float timestep;
+} PathHeader;
+
+template <typename T>
+static void put(std::vector<uint8_t>& data, T value)
+{
+	const uint8_t* bytes = (const uint8_t*)&value;
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T get(const uint8_t*& data)
+{
+	T value;
+	memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+	return value;
+}
+
+CameraPath::CameraPath()
+{
+}
+
+void CameraPath::clear()
+{
+	frames.clear();
+	lastState.clear();
+}
+
+void CameraPath::addFrame(const Camera& camera, const SceneState& state)
+{
+	PathFrame frame;
+	frame.position = camera.position;
+	frame.yaw = camera.yaw;
+	frame.pitch = camera.pitch;
+	frame.state = state;
+
+	std::vector<uint8_t> serialized = serializeState(state);
+	frame.stateChanged = frames.empty() || serialized != lastState;
+	lastState = serialized;
+
+	frames.push_back(frame);
+}
+
+void CameraPath::createViewTour(const SceneState& state, float segmentTime)
+{
+	clear();
+
+	Camera camera(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 45.0f);
+	glm::vec3 positions[cameraViews];
+	float yaws[cameraViews];
+	float pitches[cameraViews];
+
+	for (int i = 0; i < cameraViews; i++)
+	{
+		camera.setView(i);
+		positions[i] = camera.position;
+		yaws[i] = camera.yaw;
+		pitches[i] = camera.pitch;
+	}
+
+	int segmentFrames = std::max(1, int(segmentTime / pathTimestep));
+
+	// last view is followed by the first one, so the tour can be looped
+	for (int i = 0; i < cameraViews; i++)
+	{
+		int next = (i + 1) % cameraViews;
+
+		// yaw is turned the shorter way
+		float yawDelta = std::remainder(yaws[next] - yaws[i], 360.0f);
+
+		for (int j = 0; j < segmentFrames; j++)
+		{
+			float t = float(j) / float(segmentFrames);
+			t = t * t * (3.0f - 2.0f * t);
+
+			camera.setPose(glm::mix(positions[i], positions[next], t), yaws[i] + yawDelta * t, glm::mix(pitches[i], pitches[next], t));
+			addFrame(camera, state);
+		}
+	}
+}
+
+size_t CameraPath::getFrameCount() const
+{
+	return frames.size();
+}
+
+const PathFrame& CameraPath::getFrame(size_t index) const
+{
+	return frames[index];
+}
+
+/**
+ * @brief Returns TRUE if value is in [min, max], NaN is out of every range
+ */
+template <typename T>
+static bool inRange(T value, T min, T max)
+{
+	return value >= min && value <= max;
+}
+
+/**
+ * @brief Returns TRUE if all parameters of the state are in ranges offered by GUI
+ * Path files are not trusted, antialiasing 0 would divide by zero and unknown fractal type would not compile.
+ */
+static bool isValidState(const SceneState& state)
+{
+	if (!inRange(state.fractal.power, fractalPowerMin, fractalPowerMax) ||
+		!inRange(state.fractal.iterations, fractalIterationsMin, fractalIterationsMax) ||
+		!inRange(state.rendering.maxSteps, maxStepsMin, maxStepsMax) ||
+		!inRange(state.rendering.detail, renderingDetailMin, deepZoomDetailMax) ||
+		!inRange(state.rendering.detailPower, detailPowerMin, detailPowerMax) ||
+		!inRange(state.rendering.shadowSoftness, shadowSoftnessMin, shadowSoftnessMax))
+		return false;
+
+	if (std::find(std::begin(antialiasingValues), std::end(antialiasingValues), state.rendering.antialiasing) == std::end(antialiasingValues))
+		return false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (!std::isfinite(state.rendering.lightPosition[i]) ||
+			!inRange(state.bgColor[i], 0.0f, 1.0f) || !inRange(state.fractalColor[i], 0.0f, 1.0f) ||
+			!inRange(state.oTrapColor[i], 0.0f, 1.0f) || !inRange(state.yTrapColor[i], 0.0f, 1.0f))
+			return false;
+	}
+
+	// GUI offers only the mandelbulb
+	return state.fractalType == fractalMandelbulb;
+}
+
+std::vector<uint8_t> CameraPath::serializeState(const SceneState& state)
+{
+	std::vector<uint8_t> data;
+
+	put(data, state.fractal.power);
+	put(data, int32_t(state.fractal.iterations));
+	put(data, int32_t(state.rendering.maxSteps));
+	put(data, state.rendering.detail);
+	put(data, state.rendering.detailPower);
+	put(data, uint8_t(state.rendering.shadows));
+	put(data, state.rendering.shadowSoftness);
+	put(data, uint8_t(state.rendering.ambientOcclusion));
+	put(data, int32_t(state.rendering.antialiasing));
+	put(data, state.rendering.lightPosition);
+
+	for (int i = 0; i < 3; i++)
+	{
+		put(data, state.bgColor[i]);
+		put(data, state.fractalColor[i]);
+		put(data, state.oTrapColor[i]);
+		put(data, state.yTrapColor[i]);
+	}
+
+	put(data, int32_t(state.fractalType));
+	put(data, uint8_t(state.fixedIterations));
+
+	return data;
+}
+
+bool CameraPath::deserializeState(const uint8_t* data, size_t size, SceneState& state)
+{
+	if (size != serializeState(state).size())
+		return false;
+
+	state.fractal.power = get<float>(data);
+	state.fractal.iterations = get<int32_t>(data);
+	state.rendering.maxSteps = get<int32_t>(data);
+	state.rendering.detail = get<float>(data);
+	state.rendering.detailPower = get<float>(data);
+	state.rendering.shadows = get<uint8_t>(data) != 0;
+	state.rendering.shadowSoftness = get<float>(data);
+	state.rendering.ambientOcclusion = get<uint8_t>(data) != 0;
+	state.rendering.antialiasing = get<int32_t>(data);
+	state.rendering.lightPosition = get<glm::vec3>(data);
+
+	for (int i = 0; i < 3; i++)
+	{
+		state.bgColor[i] = get<float>(data);
+		state.fractalColor[i] = get<float>(data);
+		state.oTrapColor[i] = get<float>(data);
+		state.yTrapColor[i] = get<float>(data);
+	}
+
+	state.fractalType = get<int32_t>(data);
+	state.fixedIterations = get<uint8_t>(data) != 0;
+
+	return isValidState(state);
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	SceneState empty = SceneState();
+
+	PathHeader header;
+	memcpy(header.magic, pathMagic, sizeof(header.magic));
+	header.version = pathVersion;
+	header.frameCount = uint32_t(frames.size());
+	header.stateSize = uint32_t(serializeState(empty).size());
+	header.timestep = pathTimestep;
+	file.write((const char*)&header, sizeof(header));
+
+	for (const PathFrame& frame : frames)
+	{
+		std::vector<uint8_t> data;
+		put(data, frame.position);
+		put(data, frame.yaw);
+		put(data, frame.pitch);
+		put(data, uint8_t(frame.stateChanged));
+
+		if (frame.stateChanged)
+		{
+			std::vector<uint8_t> state = serializeState(frame.state);
+			data.insert(data.end(), state.begin(), state.end());
+		}
+
+		file.write((const char*)data.data(), data.size());
+	}
+
+	return file.good();
+}
+
+bool CameraPath::load(const std::string& path)
+{
+	clear();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	SceneState state = SceneState();
+
+	PathHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, pathMagic, sizeof(header.magic)) != 0 ||
+		header.version != pathVersion || header.stateSize != serializeState(state).size())
+	{
+		std::cout << "Unsupported camera path file " << path << std::endl;
+		return false;
+	}
+
+	if (header.timestep != pathTimestep)
+		std::cout << "Camera path was recorded with timestep " << header.timestep << " s, it is played with " << pathTimestep << " s" << std::endl;
+
+	const size_t poseSize = sizeof(glm::vec3) + 2 * sizeof(float) + 1;
+	std::vector<uint8_t> data(std::max(poseSize, size_t(header.stateSize)));
+
+	for (uint32_t i = 0; i < header.frameCount; i++)
+	{
+		if (!file.read((char*)data.data(), poseSize))
+			break;
+
+		const uint8_t* pose = data.data();
+		PathFrame frame;
+		frame.position = get<glm::vec3>(pose);
+		frame.yaw = get<float>(pose);
+		frame.pitch = get<float>(pose);
+		frame.stateChanged = get<uint8_t>(pose) != 0;
+
+		// first frame always carries the state
+		if (frames.empty() && !frame.stateChanged)
+			break;
+
+		if (frame.stateChanged)
+		{
+			if (!file.read((char*)data.data(), header.stateSize))
+				break;
+
+			if (!deserializeState(data.data(), header.stateSize, state))
+			{
+				std::cout << "Camera path file " << path << " has parameters out of range" << std::endl;
+				clear();
+				return false;
+			}
+		}
+
+		frame.state = state;
+		frames.push_back(frame);
+	}
+
+	if (frames.size() != header.frameCount)
+	{
+		std::cout << "Camera path file " << path << " is truncated" << std::endl;
+		clear();
+		return false;
+	}
+
+	lastState = serializeState(state);
+
+	return true;
+}
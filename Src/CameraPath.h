@@ -0,0 +1,104 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	CameraPath.h
+ *
+ */
+
+#pragma once
+
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include "Camera.h"
+#include "Raymarcher.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// time between two frames of a camera path in seconds
+const float pathTimestep = 1.0f / 60.0f;
+
+/**
+ * @brief Parameters of the scene set in GUI
+ */
+typedef struct sceneState
+{
+	Fractal fractal;
+	Rendering rendering;
+	float bgColor[3];
+	float fractalColor[3];
+	float oTrapColor[3];
+	float yTrapColor[3];
+	int fractalType;
+	bool fixedIterations;
+} SceneState;
+
+/**
+ * @brief Camera pose and scene parameters of one frame of the path
+ */
+typedef struct pathFrame
+{
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+
+	// indicates whether state differs from the previous frame
+	bool stateChanged;
+	SceneState state;
+} PathFrame;
+
+/**
+ * @brief Sequence of frames sampled at fixed timestep
+ * Binary file starts with a header (magic, version, frame count, timestep), every frame stores camera pose
+ * and a flag, scene state follows only when it changed, so the file stays small.
+ */
+class CameraPath
+{
+public:
+	CameraPath();
+
+	void clear();
+
+	/**
+	 * @brief Appends frame with current camera pose and scene state
+	 */
+	void addFrame(const Camera& camera, const SceneState& state);
+
+	/**
+	 * @brief Creates path flying through all preset views of the camera
+	 * @param state Scene state of the whole path
+	 * @param segmentTime Time of the flight between two views in seconds
+	 */
+	void createViewTour(const SceneState& state, float segmentTime);
+
+	size_t getFrameCount() const;
+
+	const PathFrame& getFrame(size_t index) const;
+
+	/**
+	 * @brief Saves path to binary file
+	 * @return TRUE if path was saved, else FALSE
+	 */
+	bool save(const std::string& path) const;
+
+	/**
+	 * @brief Loads path from binary file
+	 * @return TRUE if path was loaded, else FALSE
+	 */
+	bool load(const std::string& path);
+
+private:
+	std::vector<PathFrame> frames;
+
+	// serialized state of the last added frame
+	std::vector<uint8_t> lastState;
+
+	static std::vector<uint8_t> serializeState(const SceneState& state);
+	static bool deserializeState(const uint8_t* data, size_t size, SceneState& state);
+};
+
+#endif // !CAMERA_PATH_H
@@ -0,0 +1,576 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Distributed.cpp
+ *
+ */
+
+#include "Distributed.h"
+#include "RenderJob.h"
+#include "Socket.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+typedef HANDLE ProcessHandle;
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+typedef pid_t ProcessHandle;
+extern char** environ;
+#endif
+
+const uint32_t protocolVersion = 2;
+
+// maximal number of tiles sent to a worker in advance per one of its threads
+const unsigned int tilesPerThread = 2;
+
+// largest valid payload is a result of one tile, larger lengths are rejected before anything is allocated
+const uint32_t maxPayloadSize = uint32_t(sizeof(uint32_t) + tileDimensions.x * tileDimensions.y * 4 * sizeof(float));
+
+// worker which stops sending in the middle of a message is disconnected after this many milliseconds
+const int workerTimeout = 10000;
+
+enum MessageType { msgHello = 1, msgJob, msgTile, msgResult, msgFinish };
+
+/**
+ * @brief Payload of a message, values are stored in little endian order
+ */
+class Message
+{
+public:
+	std::vector<uint8_t> data;
+
+	Message()
+	{
+		readPosition = 0;
+	}
+
+	void putUint(uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			data.push_back(uint8_t(value >> (i * 8)));
+	}
+
+	void putInt(int value)
+	{
+		putUint(uint32_t(value));
+	}
+
+	void putFloat(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		putUint(bits);
+	}
+
+	uint32_t getUint()
+	{
+		uint32_t value = 0;
+		if (readPosition + 4 <= data.size())
+		{
+			for (int i = 0; i < 4; i++)
+				value |= uint32_t(data[readPosition + i]) << (i * 8);
+		}
+		readPosition += 4;
+
+		return value;
+	}
+
+	int getInt()
+	{
+		return int(getUint());
+	}
+
+	float getFloat()
+	{
+		uint32_t bits = getUint();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	/**
+	 * @brief Returns TRUE if all read values were in the payload
+	 */
+	bool isValid() const
+	{
+		return readPosition <= data.size();
+	}
+
+private:
+	size_t readPosition;
+};
+
+static bool sendMessage(Socket& socket, MessageType type, const Message& message)
+{
+	Message header;
+	header.putUint(uint32_t(type));
+	header.putUint(uint32_t(message.data.size()));
+
+	return socket.send(header.data.data(), header.data.size()) &&
+		(message.data.empty() || socket.send(message.data.data(), message.data.size()));
+}
+
+static bool receiveMessage(Socket& socket, MessageType& type, Message& message)
+{
+	Message header;
+	header.data.resize(8);
+	if (!socket.receive(header.data.data(), header.data.size()))
+		return false;
+
+	type = MessageType(header.getUint());
+	uint32_t size = header.getUint();
+	if (size > maxPayloadSize)
+	{
+		std::cout << "Rejected message of " << size << " bytes" << std::endl;
+		return false;
+	}
+
+	message = Message();
+	message.data.resize(size);
+
+	return message.data.empty() || socket.receive(message.data.data(), message.data.size());
+}
+
+/**
+ * @brief Stores all options that affect the image, the worker gets the same values bit by bit
+ */
+static void putImageOptions(Message& message, const RenderOptions& options)
+{
+	message.putInt(options.resolution.x);
+	message.putInt(options.resolution.y);
+	message.putInt(options.view);
+	message.putFloat(options.cameraPosition.x);
+	message.putFloat(options.cameraPosition.y);
+	message.putFloat(options.cameraPosition.z);
+	message.putFloat(options.cameraYaw);
+	message.putFloat(options.cameraPitch);
+	message.putFloat(options.fov);
+	message.putFloat(options.fractal.power);
+	message.putInt(options.fractal.iterations);
+	message.putInt(options.rendering.maxSteps);
+	message.putFloat(options.rendering.detail);
+	message.putFloat(options.rendering.detailPower);
+	message.putUint(options.rendering.shadows ? 1 : 0);
+	message.putFloat(options.rendering.shadowSoftness);
+	message.putUint(options.rendering.ambientOcclusion ? 1 : 0);
+	message.putInt(options.rendering.antialiasing);
+	message.putFloat(options.rendering.lightPosition.x);
+	message.putFloat(options.rendering.lightPosition.y);
+	message.putFloat(options.rendering.lightPosition.z);
+
+	const glm::vec3* colors[] = { &options.coloring.bgColor, &options.coloring.fractalColor, &options.coloring.oTrapColor, &options.coloring.yTrapColor };
+	for (const glm::vec3* color : colors)
+	{
+		message.putFloat(color->x);
+		message.putFloat(color->y);
+		message.putFloat(color->z);
+	}
+
+	// all packet instruction sets give the same result, only scalar marching differs from them
+	message.putUint(options.simdLevel == simdScalar ? 0 : 1);
+}
+
+static void getImageOptions(Message& message, RenderOptions& options)
+{
+	options.resolution.x = message.getInt();
+	options.resolution.y = message.getInt();
+	options.view = message.getInt();
+	options.cameraPosition.x = message.getFloat();
+	options.cameraPosition.y = message.getFloat();
+	options.cameraPosition.z = message.getFloat();
+	options.cameraYaw = message.getFloat();
+	options.cameraPitch = message.getFloat();
+	options.fov = message.getFloat();
+	options.fractal.power = message.getFloat();
+	options.fractal.iterations = message.getInt();
+	options.rendering.maxSteps = message.getInt();
+	options.rendering.detail = message.getFloat();
+	options.rendering.detailPower = message.getFloat();
+	options.rendering.shadows = message.getUint() != 0;
+	options.rendering.shadowSoftness = message.getFloat();
+	options.rendering.ambientOcclusion = message.getUint() != 0;
+	options.rendering.antialiasing = message.getInt();
+	options.rendering.lightPosition.x = message.getFloat();
+	options.rendering.lightPosition.y = message.getFloat();
+	options.rendering.lightPosition.z = message.getFloat();
+
+	glm::vec3* colors[] = { &options.coloring.bgColor, &options.coloring.fractalColor, &options.coloring.oTrapColor, &options.coloring.yTrapColor };
+	for (glm::vec3* color : colors)
+	{
+		color->x = message.getFloat();
+		color->y = message.getFloat();
+		color->z = message.getFloat();
+	}
+
+	if (message.getUint() == 0)
+		options.simdLevel = simdScalar;
+	else
+		options.simdLevel = detectSimdLevel() == simdScalar ? simdSSE : detectSimdLevel();
+}
+
+/**
+ * @brief Starts local worker process connected to the coordinator
+ * @return TRUE if process was started, else FALSE
+ */
+static bool spawnWorker(const RenderOptions& options, uint16_t port, unsigned int threads, ProcessHandle& process)
+{
+	std::string address = "127.0.0.1:" + std::to_string(port);
+	std::string threadCount = std::to_string(threads);
+
+#ifdef _WIN32
+	std::string commandLine = "\"" + options.programPath + "\" --connect " + address + " --threads " + threadCount;
+
+	STARTUPINFOA startup;
+	PROCESS_INFORMATION info;
+	ZeroMemory(&startup, sizeof(startup));
+	startup.cb = sizeof(startup);
+
+	if (!CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+		return false;
+
+	CloseHandle(info.hThread);
+	process = info.hProcess;
+
+	return true;
+#else
+	std::vector<char*> arguments;
+	std::string program = options.programPath;
+	std::string connect = "--connect";
+	std::string threadsName = "--threads";
+	arguments.push_back(&program[0]);
+	arguments.push_back(&connect[0]);
+	arguments.push_back(&address[0]);
+	arguments.push_back(&threadsName[0]);
+	arguments.push_back(&threadCount[0]);
+	arguments.push_back(nullptr);
+
+	return posix_spawn(&process, program.c_str(), nullptr, nullptr, arguments.data(), environ) == 0;
+#endif
+}
+
+/**
+ * @brief Returns TRUE if process is still running
+ */
+static bool isRunning(ProcessHandle process)
+{
+#ifdef _WIN32
+	return WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+#else
+	return waitpid(process, nullptr, WNOHANG) == 0;
+#endif
+}
+
+static void waitForProcess(ProcessHandle process)
+{
+#ifdef _WIN32
+	WaitForSingleObject(process, INFINITE);
+	CloseHandle(process);
+#else
+	waitpid(process, nullptr, 0);
+#endif
+}
+
+/**
+ * @brief Worker connected to the coordinator
+ */
+struct WorkerConnection
+{
+	Socket socket;
+	bool ready;					// hello was received and job was sent
+	unsigned int threads;
+	std::deque<int> tiles;		// indices of tiles sent to the worker and not returned yet
+};
+
+bool renderDistributed(const RenderOptions& options)
+{
+	// the protocol is not authenticated, so without a given port only local workers can connect
+	Socket server;
+	if (!server.listen(uint16_t(options.listenPort < 0 ? 0 : options.listenPort), options.listenPort < 0))
+	{
+		std::cout << "Failed to listen on port " << options.listenPort << std::endl;
+		return false;
+	}
+
+	TileRenderer tileRenderer(nullptr);
+	std::vector<Tile> tiles = tileRenderer.createTiles(options.resolution);
+
+	RenderJob job;
+	if (!job.open(options.outputPath, options.resolution, tileDimensions, hashImageOptions(options)))
+		return false;
+
+	std::deque<int> pendingTiles;
+	for (int i = 0; i < int(tiles.size()); i++)
+		if (!job.isTileDone(i))
+			pendingTiles.push_back(i);
+
+	if (job.getResumedTiles() > 0)
+		std::cout << "Resuming job, " << job.getResumedTiles() << " of " << tiles.size() << " tiles are finished" << std::endl;
+
+	// local workers share the hardware threads of this machine
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int workerThreads = options.threads > 0 ? options.threads : std::max(1u, hardwareThreads / std::max(1u, options.workers));
+
+	std::vector<ProcessHandle> processes;
+	for (unsigned int i = 0; i < options.workers; i++)
+	{
+		ProcessHandle process;
+		if (!spawnWorker(options, server.getPort(), workerThreads, process))
+		{
+			std::cout << "Failed to start worker process " << options.programPath << std::endl;
+			break;
+		}
+		processes.push_back(process);
+	}
+
+	std::cout << "Rendering " << options.resolution.x << "x" << options.resolution.y << " on " << processes.size() << " local workers";
+	if (options.listenPort >= 0)
+		std::cout << ", listening for workers on port " << server.getPort();
+	std::cout << std::endl;
+
+	std::vector<std::unique_ptr<WorkerConnection>> workers;
+	std::vector<glm::vec4> tileData(size_t(tileDimensions.x) * tileDimensions.y);
+	int doneTiles = job.getResumedTiles();
+	int reportedProgress = -1;
+	Message jobMessage;
+	putImageOptions(jobMessage, options);
+
+	auto dispatchTiles = [&](WorkerConnection& worker)
+	{
+		while (worker.tiles.size() < worker.threads * tilesPerThread && !pendingTiles.empty())
+		{
+			int index = pendingTiles.front();
+			const Tile& tile = tiles[index];
+
+			Message message;
+			message.putInt(index);
+			message.putInt(tile.origin.x);
+			message.putInt(tile.origin.y);
+			message.putInt(tile.size.x);
+			message.putInt(tile.size.y);
+			if (!sendMessage(worker.socket, msgTile, message))
+				return false;
+
+			pendingTiles.pop_front();
+			worker.tiles.push_back(index);
+		}
+
+		return true;
+	};
+
+	// returns FALSE if the worker has to be disconnected
+	auto processMessage = [&](WorkerConnection& worker)
+	{
+		MessageType type;
+		Message message;
+		if (!receiveMessage(worker.socket, type, message))
+			return false;
+
+		if (type == msgHello)
+		{
+			uint32_t version = message.getUint();
+			worker.threads = std::max(1u, message.getUint());
+			if (!message.isValid() || version != protocolVersion)
+			{
+				std::cout << "Worker uses different protocol version" << std::endl;
+				return false;
+			}
+
+			worker.ready = true;
+			return sendMessage(worker.socket, msgJob, jobMessage) && dispatchTiles(worker);
+		}
+
+		if (type != msgResult || !worker.ready)
+			return false;
+
+		int index = message.getInt();
+		auto assigned = std::find(worker.tiles.begin(), worker.tiles.end(), index);
+		if (assigned == worker.tiles.end())
+			return false;
+
+		const Tile& tile = tiles[index];
+		for (int i = 0; i < tile.size.x * tile.size.y; i++)
+		{
+			tileData[i].x = message.getFloat();
+			tileData[i].y = message.getFloat();
+			tileData[i].z = message.getFloat();
+			tileData[i].w = 1.0f;
+		}
+		if (!message.isValid())
+			return false;
+
+		job.storeTile(index, tile, tileData.data());
+		worker.tiles.erase(assigned);
+		reportProgress(++doneTiles, int(tiles.size()), reportedProgress);
+
+		return dispatchTiles(worker);
+	};
+
+	installTerminationHandler();
+
+	bool success = true;
+	while (doneTiles < int(tiles.size()))
+	{
+		if (isTerminationRequested())
+		{
+			std::cout << "Terminated, job is kept for resuming" << std::endl;
+			success = false;
+			break;
+		}
+
+		std::vector<const Socket*> sockets;
+		sockets.push_back(&server);
+		for (const auto& worker : workers)
+			sockets.push_back(&worker->socket);
+
+		std::vector<size_t> ready = Socket::waitReadable(sockets, 1000);
+
+		// workers are removed from the back, so indices of the remaining ones do not change
+		for (auto it = ready.rbegin(); it != ready.rend(); ++it)
+		{
+			if (*it == 0)
+			{
+				std::unique_ptr<WorkerConnection> worker(new WorkerConnection());
+				worker->socket = server.accept();
+				worker->ready = false;
+				worker->threads = 1;
+				if (worker->socket.isValid() && worker->socket.setReceiveTimeout(workerTimeout))
+					workers.push_back(std::move(worker));
+				continue;
+			}
+
+			WorkerConnection& worker = *workers[*it - 1];
+			if (!processMessage(worker))
+			{
+				// unfinished tiles of a lost or stalled worker are given to the others
+				std::cout << "Worker disconnected, " << worker.tiles.size() << " tiles are rendered again" << std::endl;
+				pendingTiles.insert(pendingTiles.begin(), worker.tiles.begin(), worker.tiles.end());
+				workers.erase(workers.begin() + (*it - 1));
+			}
+		}
+
+		for (const auto& worker : workers)
+			if (worker->ready && worker->tiles.empty() && !pendingTiles.empty())
+				dispatchTiles(*worker);
+
+		// without remote workers the job cannot continue once all local workers have exited
+		if (workers.empty() && options.listenPort < 0)
+		{
+			bool running = false;
+			for (ProcessHandle process : processes)
+				running = running || isRunning(process);
+
+			if (!running)
+			{
+				std::cout << "All workers have exited, job is kept for resuming" << std::endl;
+				success = false;
+				break;
+			}
+		}
+	}
+
+	for (const auto& worker : workers)
+		sendMessage(worker->socket, msgFinish, Message());
+	workers.clear();
+
+	for (ProcessHandle process : processes)
+		waitForProcess(process);
+
+	if (!success)
+	{
+		// tiles stored since the last sync are kept for resuming
+		job.sync();
+		return false;
+	}
+
+	return job.finish();
+}
+
+int runWorker(const RenderOptions& options)
+{
+	Socket socket;
+	if (!socket.connect(options.connectAddress))
+	{
+		std::cout << "Failed to connect to coordinator " << options.connectAddress << std::endl;
+		return -1;
+	}
+
+	ThreadPool pool(options.threads);
+	std::mutex sendMutex;
+	bool connected = true;
+
+	Message hello;
+	hello.putUint(protocolVersion);
+	hello.putUint(pool.getThreadCount());
+	if (!sendMessage(socket, msgHello, hello))
+		return -1;
+
+	MessageType type;
+	Message message;
+	if (!receiveMessage(socket, type, message) || type != msgJob)
+	{
+		std::cout << "Failed to receive job from coordinator" << std::endl;
+		return -1;
+	}
+
+	RenderOptions jobOptions = options;
+	getImageOptions(message, jobOptions);
+	if (!message.isValid())
+		return -1;
+
+	Camera camera = createCamera(jobOptions);
+	Fractal fractal = jobOptions.fractal;
+	Rendering rendering = jobOptions.rendering;
+	Coloring coloring = jobOptions.coloring;
+
+	Raymarcher raymarcher(jobOptions.resolution, &camera, &fractal, &rendering, &coloring);
+	raymarcher.setSimdLevel(jobOptions.simdLevel);
+
+	while (receiveMessage(socket, type, message) && type == msgTile)
+	{
+		int index = message.getInt();
+		Tile tile;
+		tile.origin.x = message.getInt();
+		tile.origin.y = message.getInt();
+		tile.size.x = message.getInt();
+		tile.size.y = message.getInt();
+		if (!message.isValid())
+			break;
+
+		pool.submit([&, index, tile]()
+		{
+			std::vector<glm::vec4> data(size_t(tile.size.x) * tile.size.y);
+			TileRenderer::renderTile(raymarcher, tile, data.data(), tile.size.x);
+
+			Message result;
+			result.data.reserve(4 + data.size() * 12);
+			result.putInt(index);
+			for (const glm::vec4& pixel : data)
+			{
+				result.putFloat(pixel.x);
+				result.putFloat(pixel.y);
+				result.putFloat(pixel.z);
+			}
+
+			std::lock_guard<std::mutex> lock(sendMutex);
+			if (connected)
+				connected = sendMessage(socket, msgResult, result);
+		});
+	}
+
+	pool.wait();
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Distributed.h
+ *
+ */
+
+#pragma once
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "OfflineRenderer.h"
+
+/**
+ * Distributed rendering
+ * Coordinator splits the frame into tiles and sends them to worker processes over TCP,
+ * workers render them with the same Raymarcher and send back the pixels. All messages start
+ * with a header (type, payload size), numbers are sent as 32 bit little endian values and
+ * floats are sent bit by bit, so the workers get exactly the same parameters as the coordinator.
+ *
+ * Worker -> coordinator: hello (protocol version, number of threads), result (tile index, RGB floats)
+ * Coordinator -> worker: job (image options), tile (index, origin, size), finish
+ */
+
+/**
+ * @brief Renders image on worker processes and saves it
+ * Local workers are started as child processes, remote workers can connect to the listening port.
+ * Results are collected in a resumable RenderJob, so tiles of a lost worker are rendered again
+ * by another one and a killed coordinator continues where it stopped.
+ * @return TRUE if image was rendered and saved, else FALSE
+ */
+bool renderDistributed(const RenderOptions& options);
+
+/**
+ * @brief Connects to the coordinator and renders tiles it sends until the job is finished
+ * @return Exit code of the program
+ */
+int runWorker(const RenderOptions& options);
+
+#endif // !DISTRIBUTED_H
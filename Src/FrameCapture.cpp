@@ -0,0 +1,246 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	FrameCapture.cpp
+ *
+ */
+
+#include "FrameCapture.h"
+#include "ImageWriter.h"
+#include "ShaderManager.h"
+
+#include <cstdio>
+#include <cstring>
+
+FrameCapture::FrameCapture() : savedFrames(0), droppedFrames(0)
+{
+	for (int i = 0; i < captureBuffers; i++)
+	{
+		slots[i].buffer = 0;
+		slots[i].fence = nullptr;
+		slots[i].width = 0;
+		slots[i].height = 0;
+	}
+
+	nextSlot = 0;
+	oldestSlot = 0;
+	frameNumber = 0;
+	stopping = false;
+}
+
+FrameCapture::~FrameCapture()
+{
+	// buffers have to be deleted by destroy while context exists, only the thread is stopped here
+	if (encoder.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		encoder.join();
+	}
+}
+
+bool FrameCapture::start(const std::string& directory, const std::string& extension)
+{
+	std::error_code error;
+	fs::create_directories(fs::u8path(directory), error);
+	if (!fs::is_directory(fs::u8path(directory)))
+	{
+		std::cout << "Failed to create capture directory " << directory << std::endl;
+		return false;
+	}
+
+	this->directory = directory;
+	this->extension = extension;
+
+	if (!encoder.joinable())
+	{
+		stopping = false;
+		encoder = std::thread(&FrameCapture::encode, this);
+	}
+
+	return true;
+}
+
+void FrameCapture::capture(GLuint texture, int width, int height)
+{
+	CaptureSlot& slot = slots[nextSlot];
+
+	bool encoderBusy;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		encoderBusy = queue.size() >= captureQueueLimit;
+	}
+
+	// copy of this slot is still running or encoder can not keep up
+	if (slot.fence != nullptr || encoderBusy || !encoder.joinable())
+	{
+		droppedFrames++;
+		return;
+	}
+
+	if (slot.buffer == 0)
+		glGenBuffers(1, &slot.buffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+	if (slot.width != width || slot.height != height)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(width) * height * sizeof(glm::vec4), nullptr, GL_STREAM_READ);
+		slot.width = width;
+		slot.height = height;
+	}
+
+	// image stores of compute shader have to be visible to texture reads
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	// texture of the active unit is bound back, quad program samples it
+	GLint boundTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, nullptr);
+	glBindTexture(GL_TEXTURE_2D, GLuint(boundTexture));
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%06d.", frameNumber++);
+	slot.path = (fs::u8path(directory) / fs::u8path(name + extension)).u8string();
+
+	nextSlot = (nextSlot + 1) % captureBuffers;
+}
+
+void FrameCapture::update()
+{
+	// copies finish in the order they were started
+	while (slots[oldestSlot].fence != nullptr)
+	{
+		GLenum status = glClientWaitSync(slots[oldestSlot].fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		finishSlot(slots[oldestSlot]);
+		oldestSlot = (oldestSlot + 1) % captureBuffers;
+	}
+}
+
+void FrameCapture::finishSlot(CaptureSlot& slot)
+{
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	EncodedFrame frame;
+	frame.width = slot.width;
+	frame.height = slot.height;
+	frame.path = slot.path;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!freePixels.empty())
+		{
+			frame.pixels = std::move(freePixels.back());
+			freePixels.pop_back();
+		}
+	}
+
+	size_t size = size_t(slot.width) * slot.height;
+	frame.pixels.resize(size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(size * sizeof(glm::vec4)), GL_MAP_READ_BIT);
+	if (data != nullptr)
+	{
+		memcpy(frame.pixels.data(), data, size * sizeof(glm::vec4));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (data == nullptr)
+	{
+		droppedFrames++;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(frame));
+	}
+	condition.notify_one();
+}
+
+void FrameCapture::encode()
+{
+	while (true)
+	{
+		EncodedFrame frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			// queued frames are saved before the thread ends
+			if (queue.empty())
+				return;
+
+			frame = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		// texture rows start at the bottom, as saveImage expects
+		if (saveImage(frame.path, frame.width, frame.height, frame.pixels))
+			savedFrames++;
+		else
+			std::cout << "Failed to save captured frame " << frame.path << std::endl;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		freePixels.push_back(std::move(frame.pixels));
+	}
+}
+
+void FrameCapture::destroy()
+{
+	// pending copies are waited for, so no captured frame is lost
+	while (slots[oldestSlot].fence != nullptr)
+	{
+		glClientWaitSync(slots[oldestSlot].fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		finishSlot(slots[oldestSlot]);
+		oldestSlot = (oldestSlot + 1) % captureBuffers;
+	}
+
+	if (encoder.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		encoder.join();
+	}
+
+	for (int i = 0; i < captureBuffers; i++)
+	{
+		if (slots[i].buffer != 0)
+			glDeleteBuffers(1, &slots[i].buffer);
+
+		slots[i].buffer = 0;
+		slots[i].width = 0;
+		slots[i].height = 0;
+	}
+}
+
+int FrameCapture::getSavedFrames() const
+{
+	return savedFrames;
+}
+
+int FrameCapture::getDroppedFrames() const
+{
+	return droppedFrames;
+}
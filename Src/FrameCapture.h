@@ -0,0 +1,127 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	FrameCapture.h
+ *
+ */
+
+#pragma once
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// number of pixel buffers, readback of a frame has this many frames to finish
+const int captureBuffers = 3;
+
+// maximal number of frames waiting for the encoder, further frames are dropped
+const size_t captureQueueLimit = 4;
+
+/**
+ * @brief Saves rendered frames to files without stalling rendering
+ * Texture is copied to one of the pixel buffer objects, the copy runs on GPU while the next frames
+ * are rendered. When the fence of the copy is signaled, pixels are handed to the encoder thread
+ * that writes the image file. Frames are dropped instead of waiting when all buffers are busy.
+ */
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	/**
+	 * @brief Sets directory and file extension of captured frames and starts the encoder thread
+	 * @param extension Extension of saved images (png, exr, ...), see ImageWriter
+	 * @return TRUE if directory exists or was created, else FALSE
+	 */
+	bool start(const std::string& directory, const std::string& extension);
+
+	/**
+	 * @brief Starts copying of the texture to the next pixel buffer
+	 * @param texture RGBA32F texture with the frame
+	 */
+	void capture(GLuint texture, int width, int height);
+
+	/**
+	 * @brief Hands finished copies to the encoder thread, never waits for GPU
+	 */
+	void update();
+
+	/**
+	 * @brief Finishes pending copies, waits until all frames are saved and deletes buffers
+	 */
+	void destroy();
+
+	/**
+	 * @brief Returns number of saved frames
+	 */
+	int getSavedFrames() const;
+
+	/**
+	 * @brief Returns number of frames dropped because buffers or encoder were busy
+	 */
+	int getDroppedFrames() const;
+
+private:
+	typedef struct captureSlot
+	{
+		GLuint buffer;
+		GLsync fence;
+		int width;
+		int height;
+		std::string path;
+	} CaptureSlot;
+
+	typedef struct encodedFrame
+	{
+		std::vector<glm::vec4> pixels;
+		int width;
+		int height;
+		std::string path;
+	} EncodedFrame;
+
+	CaptureSlot slots[captureBuffers];
+
+	// slot of the next capture and the oldest pending copy
+	int nextSlot;
+	int oldestSlot;
+
+	std::string directory;
+	std::string extension;
+	int frameNumber;
+
+	std::thread encoder;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<EncodedFrame> queue;
+
+	// pixel vectors of saved frames, reused to avoid allocation of every frame
+	std::vector<std::vector<glm::vec4>> freePixels;
+	bool stopping;
+
+	std::atomic<int> savedFrames;
+	std::atomic<int> droppedFrames;
+
+	/**
+	 * @brief Reads finished copy of the slot and adds the frame to the encoder queue
+	 */
+	void finishSlot(CaptureSlot& slot);
+
+	void encode();
+};
+
+#endif // !FRAME_CAPTURE_H
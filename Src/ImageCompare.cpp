@@ -0,0 +1,159 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ImageCompare.cpp
+ *
+ */
+
+#include "ImageCompare.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// size and step of SSIM windows
+const int ssimWindow = 8;
+const int ssimStep = 4;
+
+// SSIM constants for dynamic range 1
+const double ssimC1 = 0.01 * 0.01;
+const double ssimC2 = 0.03 * 0.03;
+
+bool loadPFM(const std::string& path, int& width, int& height, std::vector<glm::vec4>& data)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::string magic;
+	float scale = 0.0f;
+	file >> magic >> width >> height >> scale;
+
+	// single whitespace separates header from pixels
+	file.get();
+
+	if (!file || magic != "PF" || width <= 0 || height <= 0)
+		return false;
+
+	std::vector<float> row(size_t(width) * 3);
+	data.resize(size_t(width) * height);
+
+	for (int y = 0; y < height; y++)
+	{
+		if (!file.read((char*)row.data(), row.size() * sizeof(float)))
+			return false;
+
+		for (int x = 0; x < width; x++)
+		{
+			glm::vec4 pixel(row[x * 3], row[x * 3 + 1], row[x * 3 + 2], 1.0f);
+
+			// positive scale means big endian
+			if (scale > 0.0f)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					uint32_t bits;
+					memcpy(&bits, &pixel[c], sizeof(bits));
+					bits = (bits >> 24) | ((bits >> 8) & 0xFF00) | ((bits << 8) & 0xFF0000) | (bits << 24);
+					memcpy(&pixel[c], &bits, sizeof(bits));
+				}
+			}
+
+			data[size_t(y) * width + x] = pixel;
+		}
+	}
+
+	return true;
+}
+
+static float luminance(const glm::vec4& pixel)
+{
+	glm::vec3 color = glm::clamp(glm::vec3(pixel), 0.0f, 1.0f);
+	return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+
+/**
+ * @brief Mean SSIM of luminance over overlapping square windows
+ */
+static double structuralSimilarity(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b, int width, int height)
+{
+	int window = std::min(ssimWindow, std::min(width, height));
+	double sum = 0.0;
+	int windows = 0;
+
+	for (int y0 = 0; y0 + window <= height; y0 += ssimStep)
+	{
+		for (int x0 = 0; x0 + window <= width; x0 += ssimStep)
+		{
+			double meanA = 0.0, meanB = 0.0;
+			for (int y = y0; y < y0 + window; y++)
+			{
+				for (int x = x0; x < x0 + window; x++)
+				{
+					meanA += luminance(a[size_t(y) * width + x]);
+					meanB += luminance(b[size_t(y) * width + x]);
+				}
+			}
+
+			double count = double(window * window);
+			meanA /= count;
+			meanB /= count;
+
+			double varianceA = 0.0, varianceB = 0.0, covariance = 0.0;
+			for (int y = y0; y < y0 + window; y++)
+			{
+				for (int x = x0; x < x0 + window; x++)
+				{
+					double da = luminance(a[size_t(y) * width + x]) - meanA;
+					double db = luminance(b[size_t(y) * width + x]) - meanB;
+					varianceA += da * da;
+					varianceB += db * db;
+					covariance += da * db;
+				}
+			}
+
+			varianceA /= count - 1.0;
+			varianceB /= count - 1.0;
+			covariance /= count - 1.0;
+
+			sum += ((2.0 * meanA * meanB + ssimC1) * (2.0 * covariance + ssimC2)) /
+				((meanA * meanA + meanB * meanB + ssimC1) * (varianceA + varianceB + ssimC2));
+			windows++;
+		}
+	}
+
+	return windows > 0 ? sum / windows : 1.0;
+}
+
+ImageDifference compareImages(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b, int width, int height, float tolerance)
+{
+	ImageDifference difference;
+	difference.maxError = 0.0f;
+	difference.badPixels = 0;
+
+	double squaredError = 0.0;
+	size_t pixels = size_t(width) * height;
+
+	for (size_t i = 0; i < pixels; i++)
+	{
+		glm::vec3 error = glm::abs(glm::clamp(glm::vec3(a[i]), 0.0f, 1.0f) - glm::clamp(glm::vec3(b[i]), 0.0f, 1.0f));
+		float pixelError = std::max(error.x, std::max(error.y, error.z));
+
+		difference.maxError = std::max(difference.maxError, pixelError);
+		if (pixelError > tolerance)
+			difference.badPixels++;
+
+		squaredError += double(error.x) * error.x + double(error.y) * error.y + double(error.z) * error.z;
+	}
+
+	double mse = squaredError / double(pixels * 3);
+	difference.psnr = mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : std::numeric_limits<double>::infinity();
+	difference.ssim = structuralSimilarity(a, b, width, height);
+
+	return difference;
+}
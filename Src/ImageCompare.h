@@ -0,0 +1,43 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ImageCompare.h
+ *
+ */
+
+#pragma once
+
+#ifndef IMAGE_COMPARE_H
+#define IMAGE_COMPARE_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Differences between two images of the same size
+ */
+typedef struct imageDifference
+{
+	float maxError;			// largest difference of one channel
+	int badPixels;			// pixels with a channel differing more than the tolerance
+	double psnr;			// peak signal to noise ratio in dB, infinity for identical images
+	double ssim;			// mean structural similarity of luminance, 1 for identical images
+} ImageDifference;
+
+/**
+ * @brief Loads PFM image written by ImageWriter
+ * @param data Pixels row by row, first row is the bottom row of the image (as in saveImage)
+ * @return TRUE if image was loaded, else FALSE
+ */
+bool loadPFM(const std::string& path, int& width, int& height, std::vector<glm::vec4>& data);
+
+/**
+ * @brief Compares RGB channels of two images, values are clamped to [0, 1] range
+ * @param tolerance Largest difference of a channel that is not counted as bad pixel
+ */
+ImageDifference compareImages(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b, int width, int height, float tolerance);
+
+#endif // !IMAGE_COMPARE_H
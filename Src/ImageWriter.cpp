@@ -0,0 +1,432 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ImageWriter.cpp
+ *
+ */
+
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+// maximal size of stored (uncompressed) deflate block
+const size_t deflateBlockMax = 65535;
+
+// amount of PNG scanline data collected before it is written as one IDAT chunk
+const size_t pngChunkSize = 1 << 20;
+
+struct CrcTable
+{
+	uint32_t values[256];
+
+	CrcTable()
+	{
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			values[n] = c;
+		}
+	}
+};
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const CrcTable table;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1)
+{
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+static void putBigEndian(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back(uint8_t(value >> 24));
+	buffer.push_back(uint8_t(value >> 16));
+	buffer.push_back(uint8_t(value >> 8));
+	buffer.push_back(uint8_t(value));
+}
+
+
+static void putLittleEndian(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back(uint8_t(value));
+	buffer.push_back(uint8_t(value >> 8));
+	buffer.push_back(uint8_t(value >> 16));
+	buffer.push_back(uint8_t(value >> 24));
+}
+
+static void putLittleEndian(std::vector<uint8_t>& buffer, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putLittleEndian(buffer, bits);
+}
+
+static void putString(std::vector<uint8_t>& buffer, const char* text)
+{
+	buffer.insert(buffer.end(), text, text + strlen(text) + 1);
+}
+
+/**
+ * @brief Appends attribute of OpenEXR header
+ */
+static void putEXRAttribute(std::vector<uint8_t>& buffer, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+	putString(buffer, name);
+	putString(buffer, type);
+	putLittleEndian(buffer, uint32_t(value.size()));
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+static void writePNGChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	putBigEndian(chunk, uint32_t(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+
+	// CRC is computed from chunk type and data
+	putBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+	file.write((const char*)chunk.data(), chunk.size());
+}
+
+static uint8_t toByte(float value)
+{
+	return uint8_t(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+ImageFormat imageFormatFromPath(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+		return imageUnknown;
+
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if (extension == "png")
+		return imagePNG;
+	if (extension == "ppm")
+		return imagePPM;
+	if (extension == "pfm")
+		return imagePFM;
+	if (extension == "exr")
+		return imageEXR;
+
+	return imageUnknown;
+}
+
+ImageWriter::ImageWriter()
+{
+	format = imageUnknown;
+	width = 0;
+	height = 0;
+	writtenRows = 0;
+	adler = 1;
+	dataOffset = 0;
+}
+
+ImageWriter::~ImageWriter()
+{
+	if (file.is_open())
+		file.close();
+}
+
+bool ImageWriter::open(const std::string& path, int width, int height)
+{
+	this->path = path;
+	this->width = width;
+	this->height = height;
+	writtenRows = 0;
+	adler = 1;
+	pending.clear();
+
+	format = imageFormatFromPath(path);
+	if (format == imageUnknown)
+	{
+		std::cout << "Unsupported image format: " << path << std::endl;
+		return false;
+	}
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open image file: " << path << std::endl;
+		return false;
+	}
+
+	if (!writeHeader())
+	{
+		std::cout << "Failed to write image file: " << path << std::endl;
+		file.close();
+		return false;
+	}
+
+	return true;
+}
+
+bool ImageWriter::writeHeader()
+{
+	switch (format)
+	{
+	case imagePNG:
+	{
+		const uint8_t signature[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+		file.write((const char*)signature, sizeof(signature));
+
+		// 8 bit RGB, no interlacing
+		std::vector<uint8_t> header;
+		putBigEndian(header, uint32_t(width));
+		putBigEndian(header, uint32_t(height));
+		header.push_back(8);
+		header.push_back(2);
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+		writePNGChunk(file, "IHDR", header);
+
+		// data of all IDAT chunks form one zlib stream, its header gets a chunk of its own
+		writePNGChunk(file, "IDAT", std::vector<uint8_t>{ 0x78, 0x01 });
+		break;
+	}
+	case imagePPM:
+		file << "P6\n" << width << " " << height << "\n255\n";
+		break;
+	case imagePFM:
+		// negative scale means little endian, rows go from bottom to top
+		file << "PF\n" << width << " " << height << "\n-1.0\n";
+		dataOffset = file.tellp();
+		break;
+	case imageEXR:
+	{
+		std::vector<uint8_t> header;
+		putLittleEndian(header, uint32_t(20000630));
+		putLittleEndian(header, uint32_t(2));
+
+		// channels have to be sorted by name
+		std::vector<uint8_t> channels;
+		for (const char* name : { "B", "G", "R" })
+		{
+			putString(channels, name);
+			putLittleEndian(channels, uint32_t(2));		// 32 bit float
+			putLittleEndian(channels, uint32_t(0));		// linear flag and reserved bytes
+			putLittleEndian(channels, uint32_t(1));		// x sampling
+			putLittleEndian(channels, uint32_t(1));		// y sampling
+		}
+		channels.push_back(0);
+		putEXRAttribute(header, "channels", "chlist", channels);
+
+		putEXRAttribute(header, "compression", "compression", std::vector<uint8_t>{ 0 });
+
+		std::vector<uint8_t> window;
+		putLittleEndian(window, uint32_t(0));
+		putLittleEndian(window, uint32_t(0));
+		putLittleEndian(window, uint32_t(width - 1));
+		putLittleEndian(window, uint32_t(height - 1));
+		putEXRAttribute(header, "dataWindow", "box2i", window);
+		putEXRAttribute(header, "displayWindow", "box2i", window);
+
+		putEXRAttribute(header, "lineOrder", "lineOrder", std::vector<uint8_t>{ 0 });
+
+		std::vector<uint8_t> value;
+		putLittleEndian(value, 1.0f);
+		putEXRAttribute(header, "pixelAspectRatio", "float", value);
+		putEXRAttribute(header, "screenWindowWidth", "float", value);
+
+		value.clear();
+		putLittleEndian(value, 0.0f);
+		putLittleEndian(value, 0.0f);
+		putEXRAttribute(header, "screenWindowCenter", "v2f", value);
+
+		header.push_back(0);
+
+		// without compression every block is one scanline of the same size,
+		// so the whole offset table is known in advance
+		uint64_t blockSize = 8 + uint64_t(width) * 3 * sizeof(float);
+		uint64_t offset = header.size() + uint64_t(height) * sizeof(uint64_t);
+		for (int y = 0; y < height; y++, offset += blockSize)
+		{
+			putLittleEndian(header, uint32_t(offset));
+			putLittleEndian(header, uint32_t(offset >> 32));
+		}
+
+		file.write((const char*)header.data(), header.size());
+		break;
+	}
+	default:
+		return false;
+	}
+
+	return file.good();
+}
+
+bool ImageWriter::writeRow(const glm::vec4* row)
+{
+	if (!file.is_open() || writtenRows >= height)
+		return false;
+
+	switch (format)
+	{
+	case imagePNG:
+	{
+		// every scanline starts with filter type 0
+		pending.push_back(0);
+		for (int x = 0; x < width; x++)
+		{
+			pending.push_back(toByte(row[x].x));
+			pending.push_back(toByte(row[x].y));
+			pending.push_back(toByte(row[x].z));
+		}
+
+		if (pending.size() >= pngChunkSize && !flushPNG(false))
+			return false;
+		break;
+	}
+	case imagePPM:
+	{
+		std::vector<uint8_t> bytes(size_t(width) * 3);
+		for (int x = 0; x < width; x++)
+		{
+			bytes[x * 3 + 0] = toByte(row[x].x);
+			bytes[x * 3 + 1] = toByte(row[x].y);
+			bytes[x * 3 + 2] = toByte(row[x].z);
+		}
+		file.write((const char*)bytes.data(), bytes.size());
+		break;
+	}
+	case imagePFM:
+	{
+		std::vector<float> values(size_t(width) * 3);
+		for (int x = 0; x < width; x++)
+		{
+			values[x * 3 + 0] = row[x].x;
+			values[x * 3 + 1] = row[x].y;
+			values[x * 3 + 2] = row[x].z;
+		}
+
+		// PFM stores the bottom row first, rows received from the top are placed from the end of the file
+		std::streamoff rowSize = std::streamoff(values.size() * sizeof(float));
+		file.seekp(dataOffset + std::streamoff(height - 1 - writtenRows) * rowSize);
+		file.write((const char*)values.data(), rowSize);
+		break;
+	}
+	case imageEXR:
+	{
+		std::vector<uint8_t> block;
+		block.reserve(8 + size_t(width) * 3 * sizeof(float));
+		putLittleEndian(block, uint32_t(writtenRows));
+		putLittleEndian(block, uint32_t(width * 3 * sizeof(float)));
+		for (int channel = 2; channel >= 0; channel--)
+			for (int x = 0; x < width; x++)
+				putLittleEndian(block, row[x][channel]);
+		file.write((const char*)block.data(), block.size());
+		break;
+	}
+	default:
+		return false;
+	}
+
+	writtenRows++;
+
+	return file.good();
+}
+
+bool ImageWriter::flushPNG(bool last)
+{
+	adler = adler32(pending.data(), pending.size(), adler);
+
+	// zlib data of stored deflate blocks, no compression library is needed
+	std::vector<uint8_t> zlib;
+	zlib.reserve(pending.size() + (pending.size() / deflateBlockMax + 2) * 5 + 4);
+
+	size_t offset = 0;
+	do
+	{
+		size_t size = std::min(deflateBlockMax, pending.size() - offset);
+		bool lastBlock = last && offset + size >= pending.size();
+
+		zlib.push_back(lastBlock ? 1 : 0);
+		zlib.push_back(uint8_t(size));
+		zlib.push_back(uint8_t(size >> 8));
+		zlib.push_back(uint8_t(~size));
+		zlib.push_back(uint8_t(~size >> 8));
+		zlib.insert(zlib.end(), pending.begin() + offset, pending.begin() + offset + size);
+
+		offset += size;
+	} while (offset < pending.size());
+
+	if (last)
+		putBigEndian(zlib, adler);
+
+	writePNGChunk(file, "IDAT", zlib);
+	pending.clear();
+
+	return file.good();
+}
+
+bool ImageWriter::close()
+{
+	if (!file.is_open())
+		return false;
+
+	bool success = writtenRows == height;
+	if (!success)
+		std::cout << "Image is not complete, " << writtenRows << " of " << height << " rows were written: " << path << std::endl;
+
+	if (format == imagePNG)
+	{
+		success = success && flushPNG(true);
+		writePNGChunk(file, "IEND", std::vector<uint8_t>());
+	}
+
+	success = success && file.good();
+	file.close();
+
+	if (!success)
+		std::cout << "Failed to write image file: " << path << std::endl;
+
+	return success;
+}
+
+int ImageWriter::getWrittenRows() const
+{
+	return writtenRows;
+}
+
+bool saveImage(const std::string& path, int width, int height, const std::vector<glm::vec4>& data)
+{
+	ImageWriter writer;
+
+	if (!writer.open(path, width, height))
+		return false;
+
+	// first row of the data is the bottom row of the image
+	for (int y = height - 1; y >= 0; y--)
+		writer.writeRow(&data[size_t(y) * width]);
+
+	return writer.close();
+}
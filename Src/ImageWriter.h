@@ -0,0 +1,93 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ImageWriter.h
+ *
+ */
+
+#pragma once
+
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum ImageFormat { imagePNG, imagePPM, imagePFM, imageEXR, imageUnknown };
+
+/**
+ * @brief Returns image format based on file extension
+ */
+ImageFormat imageFormatFromPath(const std::string& path);
+
+/**
+ * @brief Streaming image writer
+ * Image is written row by row from the top row to the bottom one, only a small buffer
+ * is kept in memory, so the size of the image is limited only by the disk.
+ * PNG and PPM store 8 bit RGB, PFM and EXR store 32 bit float RGB.
+ */
+class ImageWriter
+{
+public:
+	ImageWriter();
+	~ImageWriter();
+
+	ImageWriter(const ImageWriter&) = delete;
+	ImageWriter& operator=(const ImageWriter&) = delete;
+
+	/**
+	 * @brief Creates the file and writes image header, format is chosen by file extension
+	 * @return TRUE if file was created, else FALSE
+	 */
+	bool open(const std::string& path, int width, int height);
+
+	/**
+	 * @brief Writes next row of the image
+	 * @param row Pixels of the row from left to right
+	 * @return TRUE if row was written, else FALSE
+	 */
+	bool writeRow(const glm::vec4* row);
+
+	/**
+	 * @brief Writes end of the image and closes the file
+	 * @return TRUE if all rows were written and file was closed without error, else FALSE
+	 */
+	bool close();
+
+	/**
+	 * @brief Returns number of rows written so far
+	 */
+	int getWrittenRows() const;
+
+private:
+	std::ofstream file;
+	std::string path;
+	ImageFormat format;
+	int width;
+	int height;
+	int writtenRows;
+
+	// PNG scanlines waiting to be written in the next IDAT chunk
+	std::vector<uint8_t> pending;
+	uint32_t adler;
+
+	// position of the first row in PFM and EXR files
+	std::streamoff dataOffset;
+
+	bool writeHeader();
+	bool flushPNG(bool last);
+};
+
+/**
+ * @brief Saves image to a file, format is chosen by file extension (.png, .ppm, .pfm, .exr)
+ * @param data Pixels row by row, first row is the bottom row of the image (as in OpenGL textures)
+ * @return TRUE if image was saved, else FALSE
+ */
+bool saveImage(const std::string& path, int width, int height, const std::vector<glm::vec4>& data);
+
+#endif // !IMAGE_WRITER_H
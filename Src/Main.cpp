@@ -13,8 +13,28 @@ Camera mainCamera = Camera(glm::vec3(0.0f, 2.5f, 5.0f), glm::vec3(0.0f, -0.5f, -
 
 Renderer* renderer;
 
-int main()
+int main(int argc, char** argv)
 {
+	// headless mode, image is rendered on CPU without creating a window
+	if (argc > 1)
+	{
+		RenderOptions options;
+
+		if (!parseArguments(argc, argv, options))
+		{
+			printUsage(argv[0]);
+			return -1;
+		}
+
+		if (options.showHelp)
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+
+		return renderOffline(options);
+	}
+
 	try
 	{
 		renderer = new Renderer();
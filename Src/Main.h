@@ -13,6 +13,7 @@
 #define MAIN_H
 
 #include "Camera.h"
+#include "OfflineRenderer.h"
 #include "Renderer.h"
 #include "ShaderManager.h"
 
@@ -0,0 +1,172 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MappedFile.cpp
+ *
+ */
+
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+}
+
+bool MappedFile::open(const std::string& path, size_t size)
+{
+	close();
+
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Failed to open file: " << path << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = LONGLONG(size);
+	if (!SetFilePointerEx(file, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+	{
+		std::cout << "Failed to resize file: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size), nullptr);
+	if (mapping != nullptr)
+		data = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+	if (data == nullptr)
+	{
+		std::cout << "Failed to map file to memory: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	this->size = size;
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	data = nullptr;
+	size = 0;
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+}
+
+bool MappedFile::flush()
+{
+	if (data == nullptr)
+		return false;
+
+	return FlushViewOfFile(data, size) && FlushFileBuffers(file);
+}
+
+#else
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+	file = -1;
+}
+
+bool MappedFile::open(const std::string& path, size_t size)
+{
+	close();
+
+	file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+	{
+		std::cout << "Failed to open file: " << path << std::endl;
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || (size_t(status.st_size) != size && ftruncate(file, off_t(size)) != 0))
+	{
+		std::cout << "Failed to resize file: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (memory == MAP_FAILED)
+	{
+		std::cout << "Failed to map file to memory: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	data = (uint8_t*)memory;
+	this->size = size;
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr)
+		munmap(data, size);
+	if (file >= 0)
+		::close(file);
+
+	data = nullptr;
+	size = 0;
+	file = -1;
+}
+
+bool MappedFile::flush()
+{
+	if (data == nullptr)
+		return false;
+
+	return msync(data, size, MS_SYNC) == 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+uint8_t* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
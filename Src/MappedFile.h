@@ -0,0 +1,70 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MappedFile.h
+ *
+ */
+
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief File mapped to memory for reading and writing
+ * Changes are written to the file by the operating system, so they survive when the process is killed.
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Opens file and maps it to memory, file is created if it does not exist
+	 * Contents of an existing file are kept, file is resized if its size differs.
+	 * @param size Size of the file in bytes
+	 * @return TRUE if file was mapped, else FALSE
+	 */
+	bool open(const std::string& path, size_t size);
+
+	/**
+	 * @brief Unmaps and closes the file
+	 */
+	void close();
+
+	/**
+	 * @brief Writes changed pages to the disk
+	 * @return TRUE on success, else FALSE
+	 */
+	bool flush();
+
+	/**
+	 * @brief Returns pointer to the mapped memory, nullptr if no file is open
+	 */
+	uint8_t* getData() const;
+
+	size_t getSize() const;
+
+private:
+	uint8_t* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+};
+
+#endif // !MAPPED_FILE_H
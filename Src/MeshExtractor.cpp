@@ -0,0 +1,437 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MeshExtractor.cpp
+ *
+ */
+
+#include "MeshExtractor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+// number of distance samples along the edge of a block, neighbouring blocks sample their shared corners both
+const int blockSamples = meshBlockCells + 1;
+
+// nodes of this size in blocks are searched by separate tasks, bigger nodes are split without testing
+const int octreeTaskSize = 8;
+
+// key of an empty slot of the vertex hash, keys of cells never have the highest bit set
+const uint64_t emptyKey = ~0ull;
+
+/**
+ * @brief Packs coordinates of a cell into a key of the vertex hash
+ */
+static uint64_t cellKey(glm::ivec3 cell)
+{
+	return uint64_t(cell.x) | (uint64_t(cell.y) << 21) | (uint64_t(cell.z) << 42);
+}
+
+/**
+ * @brief Edge of the cells crossing the surface
+ */
+typedef struct crossing
+{
+	glm::ivec3 corner;		// first corner of the edge
+	int axis;				// direction of the edge from the first corner
+	bool inside;			// TRUE if the first corner is inside the fractal
+} Crossing;
+
+struct MeshExtractor::BlockMesh
+{
+	std::vector<uint64_t> cells;		// keys of cells with a vertex
+	std::vector<glm::vec3> vertices;	// vertices of the cells in the same order
+	std::vector<Crossing> crossings;
+	std::vector<glm::uvec3> triangles;
+	uint32_t firstVertex;				// index of the first vertex of the block in the mesh
+};
+
+/**
+ * @brief Hash table from keys of cells to indices of their vertices
+ * Slots are claimed by compare and swap of the key, so blocks insert their vertices in parallel without locks.
+ * Table is only filled during insertion and only read afterwards, so indices need no synchronization.
+ */
+class MeshExtractor::VertexHash
+{
+public:
+	/**
+	 * @param count Number of vertices that will be inserted
+	 */
+	explicit VertexHash(size_t count)
+	{
+		size_t capacity = 16;
+		while (capacity < 2 * count)
+			capacity *= 2;
+
+		mask = capacity - 1;
+		keys.reset(new std::atomic<uint64_t>[capacity]);
+		values.reset(new uint32_t[capacity]);
+
+		for (size_t i = 0; i < capacity; i++)
+			keys[i].store(emptyKey, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Inserts index of a vertex, every key is inserted only once
+	 */
+	void insert(uint64_t key, uint32_t value)
+	{
+		for (size_t slot = hash(key) & mask; ; slot = (slot + 1) & mask)
+		{
+			uint64_t expected = emptyKey;
+			if (keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed))
+			{
+				values[slot] = value;
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @brief Finds index of the vertex of a cell
+	 * @return TRUE if the cell has a vertex, else FALSE
+	 */
+	bool find(uint64_t key, uint32_t& value) const
+	{
+		for (size_t slot = hash(key) & mask; ; slot = (slot + 1) & mask)
+		{
+			uint64_t stored = keys[slot].load(std::memory_order_relaxed);
+			if (stored == key)
+			{
+				value = values[slot];
+				return true;
+			}
+			if (stored == emptyKey)
+				return false;
+		}
+	}
+
+private:
+	std::unique_ptr<std::atomic<uint64_t>[]> keys;
+	std::unique_ptr<uint32_t[]> values;
+	size_t mask;
+
+	/**
+	 * @brief splitmix64 finalizer, spreads neighbouring cells over the whole table
+	 */
+	static uint64_t hash(uint64_t key)
+	{
+		key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+		key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+		return key ^ (key >> 31);
+	}
+};
+
+MeshExtractor::MeshExtractor(ThreadPool* pool)
+{
+	this->pool = pool;
+	fractal = defaultFractal();
+	integerPower = getIntegerPower(fractal.power);
+	resolution = 0;
+	cellSize = 0.0f;
+}
+
+glm::vec3 MeshExtractor::cornerPosition(glm::ivec3 corner) const
+{
+	return glm::vec3(corner) * cellSize - meshExtent;
+}
+
+bool MeshExtractor::mayContainSurface(glm::ivec3 node, int size) const
+{
+	int cells = size * meshBlockCells;
+	glm::vec3 center = cornerPosition(node * meshBlockCells + glm::ivec3(cells / 2));
+	float halfDiagonal = 0.5f * sqrt(3.0f) * float(cells) * cellSize;
+
+	// only distance outside the fractal is a bound, inside it the estimation is negative, but its magnitude is not a distance,
+	// in the origin it is not a number
+	return !(mandelbulbDistance(fractal, integerPower, center) > halfDiagonal);
+}
+
+void MeshExtractor::findBlocks(glm::ivec3 node, int size, std::vector<glm::ivec3>& leaves) const
+{
+	int blocksPerAxis = resolution / meshBlockCells;
+	if (node.x >= blocksPerAxis || node.y >= blocksPerAxis || node.z >= blocksPerAxis)
+		return;
+
+	if (!mayContainSurface(node, size))
+		return;
+
+	if (size == 1)
+	{
+		leaves.push_back(node);
+		return;
+	}
+
+	int half = size / 2;
+	for (int child = 0; child < 8; child++)
+		findBlocks(node + half * glm::ivec3(child & 1, (child >> 1) & 1, child >> 2), half, leaves);
+}
+
+void MeshExtractor::buildOctree()
+{
+	int blocksPerAxis = resolution / meshBlockCells;
+
+	int rootSize = 1;
+	while (rootSize < blocksPerAxis)
+		rootSize *= 2;
+
+	// top of the tree is split into nodes searched in parallel
+	int taskSize = std::min(rootSize, octreeTaskSize);
+	int tasksPerAxis = (blocksPerAxis + taskSize - 1) / taskSize;
+	std::vector<std::vector<glm::ivec3>> taskLeaves(size_t(tasksPerAxis) * tasksPerAxis * tasksPerAxis);
+
+	for (size_t task = 0; task < taskLeaves.size(); task++)
+	{
+		pool->submit([this, task, taskSize, tasksPerAxis, &taskLeaves]()
+		{
+			glm::ivec3 node = glm::ivec3(int(task % tasksPerAxis), int((task / tasksPerAxis) % tasksPerAxis), int(task / (size_t(tasksPerAxis) * tasksPerAxis)));
+			findBlocks(node * taskSize, taskSize, taskLeaves[task]);
+		});
+	}
+	pool->wait();
+
+	blocks.clear();
+	for (const std::vector<glm::ivec3>& leaves : taskLeaves)
+		blocks.insert(blocks.end(), leaves.begin(), leaves.end());
+
+	std::sort(blocks.begin(), blocks.end(), [](glm::ivec3 a, glm::ivec3 b)
+	{
+		if (a.z != b.z)
+			return a.z < b.z;
+		if (a.y != b.y)
+			return a.y < b.y;
+		return a.x < b.x;
+	});
+}
+
+void MeshExtractor::sampleBlock(glm::ivec3 block, BlockMesh& mesh) const
+{
+	glm::ivec3 origin = block * meshBlockCells;
+
+	std::vector<float> samples(size_t(blockSamples) * blockSamples * blockSamples);
+	for (int z = 0, i = 0; z < blockSamples; z++)
+		for (int y = 0; y < blockSamples; y++)
+			for (int x = 0; x < blockSamples; x++, i++)
+			{
+				samples[i] = mandelbulbDistance(fractal, integerPower, cornerPosition(origin + glm::ivec3(x, y, z)));
+
+				// origin stays in the origin during iteration, so it is inside, but its estimation is not a number
+				if (std::isnan(samples[i]))
+					samples[i] = -cellSize;
+			}
+
+	auto sample = [&samples](int x, int y, int z)
+	{
+		return samples[(size_t(z) * blockSamples + y) * blockSamples + x];
+	};
+
+	// vertex of a cell is the average of the points where its edges cross the surface
+	const glm::ivec3 axes[3] = { glm::ivec3(1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, 0, 1) };
+
+	for (int z = 0; z < meshBlockCells; z++)
+	{
+		for (int y = 0; y < meshBlockCells; y++)
+		{
+			for (int x = 0; x < meshBlockCells; x++)
+			{
+				int insideCorners = 0;
+				for (int corner = 0; corner < 8; corner++)
+					insideCorners += sample(x + (corner & 1), y + ((corner >> 1) & 1), z + (corner >> 2)) < 0.0f;
+
+				if (insideCorners == 0 || insideCorners == 8)
+					continue;
+
+				glm::vec3 sum = glm::vec3(0.0f);
+				int crossings = 0;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					// four edges of the cell along the axis start in the corners of its lower face
+					glm::ivec3 u = axes[(axis + 1) % 3];
+					glm::ivec3 v = axes[(axis + 2) % 3];
+
+					for (int edge = 0; edge < 4; edge++)
+					{
+						glm::ivec3 first = glm::ivec3(x, y, z) + (edge & 1) * u + (edge >> 1) * v;
+						glm::ivec3 second = first + axes[axis];
+						float a = sample(first.x, first.y, first.z);
+						float b = sample(second.x, second.y, second.z);
+
+						if ((a < 0.0f) == (b < 0.0f))
+							continue;
+
+						sum += glm::vec3(first - glm::ivec3(x, y, z)) + (a / (a - b)) * glm::vec3(axes[axis]);
+						crossings++;
+					}
+				}
+
+				glm::ivec3 cell = origin + glm::ivec3(x, y, z);
+				mesh.cells.push_back(cellKey(cell));
+				mesh.vertices.push_back((glm::vec3(cell) + sum / float(crossings)) * cellSize - meshExtent);
+			}
+		}
+	}
+
+	// every edge belongs to the block of its first corner, edges on the faces of the cube have no cells on one side
+	for (int z = 0; z < meshBlockCells; z++)
+	{
+		for (int y = 0; y < meshBlockCells; y++)
+		{
+			for (int x = 0; x < meshBlockCells; x++)
+			{
+				glm::ivec3 corner = origin + glm::ivec3(x, y, z);
+				bool inside = sample(x, y, z) < 0.0f;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					glm::ivec3 second = glm::ivec3(x, y, z) + axes[axis];
+					if ((sample(second.x, second.y, second.z) < 0.0f) == inside)
+						continue;
+
+					if (corner[(axis + 1) % 3] == 0 || corner[(axis + 2) % 3] == 0)
+						continue;
+
+					Crossing crossing;
+					crossing.corner = corner;
+					crossing.axis = axis;
+					crossing.inside = inside;
+					mesh.crossings.push_back(crossing);
+				}
+			}
+		}
+	}
+}
+
+void MeshExtractor::connectBlock(glm::ivec3 block, BlockMesh& mesh, const VertexHash& current, const VertexHash& previous) const
+{
+	const glm::ivec3 axes[3] = { glm::ivec3(1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, 0, 1) };
+	int slabStart = block.z * meshBlockCells;
+
+	for (const Crossing& crossing : mesh.crossings)
+	{
+		glm::ivec3 u = axes[(crossing.axis + 1) % 3];
+		glm::ivec3 v = axes[(crossing.axis + 2) % 3];
+
+		// four cells around the edge in counterclockwise order when looking against the axis
+		glm::ivec3 cells[4] = { crossing.corner - u - v, crossing.corner - v, crossing.corner, crossing.corner - u };
+		uint32_t quad[4];
+		bool complete = true;
+
+		for (int i = 0; i < 4; i++)
+		{
+			const VertexHash& vertices = cells[i].z < slabStart ? previous : current;
+			complete = complete && vertices.find(cellKey(cells[i]), quad[i]);
+		}
+
+		// cell without a vertex is in a block that the octree skipped
+		if (!complete)
+			continue;
+
+		// triangles face away from the inside of the fractal
+		if (crossing.inside)
+		{
+			mesh.triangles.push_back(glm::uvec3(quad[0], quad[1], quad[2]));
+			mesh.triangles.push_back(glm::uvec3(quad[0], quad[2], quad[3]));
+		}
+		else
+		{
+			mesh.triangles.push_back(glm::uvec3(quad[0], quad[2], quad[1]));
+			mesh.triangles.push_back(glm::uvec3(quad[0], quad[3], quad[2]));
+		}
+	}
+}
+
+bool MeshExtractor::extract(const Fractal& fractal, int resolution, MeshWriter& writer, MeshProgressFunc progress)
+{
+	this->fractal = fractal;
+	this->resolution = resolution;
+	integerPower = getIntegerPower(fractal.power);
+	cellSize = 2.0f * meshExtent / float(resolution);
+
+	buildOctree();
+
+	// vertices of the slab below the extracted one, its top cells are shared with the extracted slab
+	std::unique_ptr<VertexHash> previous(new VertexHash(0));
+	uint64_t firstVertex = 0;
+
+	for (size_t first = 0; first < blocks.size(); )
+	{
+		size_t last = first;
+		while (last < blocks.size() && blocks[last].z == blocks[first].z)
+			last++;
+
+		std::vector<BlockMesh> meshes(last - first);
+
+		for (size_t i = 0; i < meshes.size(); i++)
+			pool->submit([this, &meshes, i, first]() { sampleBlock(blocks[first + i], meshes[i]); });
+		pool->wait();
+
+		// vertices are numbered in the order of the blocks, so the mesh does not depend on the number of threads
+		size_t slabVertices = 0;
+		for (BlockMesh& mesh : meshes)
+		{
+			mesh.firstVertex = uint32_t(firstVertex + slabVertices);
+			slabVertices += mesh.vertices.size();
+		}
+
+		if (firstVertex + slabVertices > std::numeric_limits<uint32_t>::max())
+		{
+			std::cout << "Mesh has too many vertices for 32 bit indices, use lower resolution" << std::endl;
+			return false;
+		}
+
+		std::unique_ptr<VertexHash> current(new VertexHash(slabVertices));
+		VertexHash* currentHash = current.get();
+
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			pool->submit([&meshes, i, currentHash]()
+			{
+				const BlockMesh& mesh = meshes[i];
+				for (size_t v = 0; v < mesh.cells.size(); v++)
+					currentHash->insert(mesh.cells[v], mesh.firstVertex + uint32_t(v));
+			});
+		}
+		pool->wait();
+
+		const VertexHash* previousHash = previous.get();
+		for (size_t i = 0; i < meshes.size(); i++)
+			pool->submit([this, &meshes, i, first, currentHash, previousHash]() { connectBlock(blocks[first + i], meshes[i], *currentHash, *previousHash); });
+		pool->wait();
+
+		// vertices of the slab are written before its triangles, which can refer to them
+		for (const BlockMesh& mesh : meshes)
+			if (!writer.writeVertices(mesh.vertices))
+				return false;
+
+		for (const BlockMesh& mesh : meshes)
+			if (!writer.writeTriangles(mesh.triangles))
+				return false;
+
+		firstVertex += slabVertices;
+		previous = std::move(current);
+		first = last;
+
+		if (progress)
+			progress(int(last), int(blocks.size()));
+	}
+
+	return true;
+}
+
+size_t MeshExtractor::getBlockCount() const
+{
+	return blocks.size();
+}
+
+size_t MeshExtractor::getFullBlockCount() const
+{
+	size_t blocksPerAxis = size_t(resolution / meshBlockCells);
+	return blocksPerAxis * blocksPerAxis * blocksPerAxis;
+}
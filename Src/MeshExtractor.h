@@ -0,0 +1,118 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MeshExtractor.h
+ *
+ */
+
+#pragma once
+
+#ifndef MESH_EXTRACTOR_H
+#define MESH_EXTRACTOR_H
+
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+#include "MeshWriter.h"
+#include "Raymarcher.h"
+#include "ThreadPool.h"
+
+// number of cells along the edge of a leaf block of the octree
+const int meshBlockCells = 16;
+
+// half of the edge of the cube in which the surface is extracted, cube contains bounding sphere of the mandelbulb
+const float meshExtent = 1.2f;
+
+// largest number of cells along the edge of the cube, coordinates of cells are packed into 21 bits
+const int meshResolutionMax = 1 << 20;
+
+/**
+ * @brief Called after every slab of blocks with number of finished blocks and number of all blocks
+ */
+typedef std::function<void(int done, int total)> MeshProgressFunc;
+
+/**
+ * @brief Extracts surface of the mandelbulb as a triangle mesh
+ * Cube around the fractal is divided into an octree of blocks and only blocks that the distance estimation
+ * does not rule out are sampled. Surface is extracted from the samples by surface nets, every cell with
+ * the surface gets one vertex and every edge crossing the surface one quad between the cells around it.
+ * Blocks are extracted in parallel one slab (blocks with the same z) at a time and the slab is written before
+ * the next one starts, so only two slabs are kept in memory.
+ */
+class MeshExtractor
+{
+public:
+	explicit MeshExtractor(ThreadPool* pool);
+
+	/**
+	 * @brief Extracts surface of the fractal and streams it to the writer
+	 * @param resolution Number of cells along the edge of the cube, multiple of meshBlockCells
+	 * @param writer Opened writer, it is not closed
+	 * @param progress Reports finished blocks, can be empty
+	 * @return TRUE if the whole mesh was written, else FALSE
+	 */
+	bool extract(const Fractal& fractal, int resolution, MeshWriter& writer, MeshProgressFunc progress = nullptr);
+
+	/**
+	 * @brief Returns number of blocks sampled by the last extraction
+	 */
+	size_t getBlockCount() const;
+
+	/**
+	 * @brief Returns number of blocks the cube would have without the octree
+	 */
+	size_t getFullBlockCount() const;
+
+private:
+	struct BlockMesh;
+	class VertexHash;
+
+	ThreadPool* pool;
+
+	Fractal fractal;
+	int integerPower;
+	int resolution;
+	float cellSize;
+
+	// leaf blocks of the octree in units of blocks, sorted by z, y and x
+	std::vector<glm::ivec3> blocks;
+
+	/**
+	 * @brief Returns world position of a corner of the cells
+	 */
+	glm::vec3 cornerPosition(glm::ivec3 corner) const;
+
+	/**
+	 * @brief Returns FALSE if distance estimation in the center of the node shows that the surface is not in it
+	 * @param node First block of the node
+	 * @param size Number of blocks along the edge of the node
+	 */
+	bool mayContainSurface(glm::ivec3 node, int size) const;
+
+	/**
+	 * @brief Appends leaf blocks of a node that may contain the surface
+	 */
+	void findBlocks(glm::ivec3 node, int size, std::vector<glm::ivec3>& leaves) const;
+
+	/**
+	 * @brief Builds the octree and fills the list of blocks
+	 */
+	void buildOctree();
+
+	/**
+	 * @brief Samples distance estimation in the corners of the cells of a block, computes vertices of its cells
+	 * and finds edges crossing the surface whose first corner is in the block
+	 */
+	void sampleBlock(glm::ivec3 block, BlockMesh& mesh) const;
+
+	/**
+	 * @brief Creates triangles of the edges of a block crossing the surface
+	 * @param current Vertices of the slab of the block
+	 * @param previous Vertices of the slab below it
+	 */
+	void connectBlock(glm::ivec3 block, BlockMesh& mesh, const VertexHash& current, const VertexHash& previous) const;
+};
+
+#endif // !MESH_EXTRACTOR_H
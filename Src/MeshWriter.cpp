@@ -0,0 +1,241 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MeshWriter.cpp
+ *
+ */
+
+#include "MeshWriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// width of zero padded counts in PLY header, they are overwritten in place when the mesh is closed
+const int plyCountDigits = 12;
+
+// size of the buffer in which triangles are copied from the temporary file
+const size_t copyBufferSize = 1 << 20;
+
+static void putLittleEndian(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back(uint8_t(value));
+	buffer.push_back(uint8_t(value >> 8));
+	buffer.push_back(uint8_t(value >> 16));
+	buffer.push_back(uint8_t(value >> 24));
+}
+
+static void putLittleEndian(std::vector<uint8_t>& buffer, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putLittleEndian(buffer, bits);
+}
+
+MeshFormat meshFormatFromPath(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+		return meshUnknown;
+
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if (extension == "ply")
+		return meshPLY;
+	if (extension == "obj")
+		return meshOBJ;
+
+	return meshUnknown;
+}
+
+MeshWriter::MeshWriter()
+{
+	format = meshUnknown;
+	vertexCount = 0;
+	triangleCount = 0;
+	vertexCountOffset = 0;
+	triangleCountOffset = 0;
+}
+
+MeshWriter::~MeshWriter()
+{
+	if (file.is_open())
+		file.close();
+
+	if (triangleFile.is_open())
+	{
+		triangleFile.close();
+		std::remove(trianglePath.c_str());
+	}
+}
+
+bool MeshWriter::open(const std::string& path)
+{
+	this->path = path;
+	vertexCount = 0;
+	triangleCount = 0;
+
+	format = meshFormatFromPath(path);
+	if (format == meshUnknown)
+	{
+		std::cout << "Unsupported mesh format: " << path << std::endl;
+		return false;
+	}
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open mesh file: " << path << std::endl;
+		return false;
+	}
+
+	if (format == meshOBJ)
+	{
+		file << "# Mandelbulb surface, Visualization of 3D fractals\n";
+		return bool(file);
+	}
+
+	trianglePath = path + ".triangles";
+	triangleFile.open(trianglePath, std::ios::binary | std::ios::trunc);
+	if (!triangleFile.is_open())
+	{
+		std::cout << "Failed to open temporary file: " << trianglePath << std::endl;
+		file.close();
+		return false;
+	}
+
+	file << "ply\nformat binary_little_endian 1.0\ncomment Mandelbulb surface, Visualization of 3D fractals\nelement vertex ";
+	vertexCountOffset = file.tellp();
+	file << std::string(plyCountDigits, '0') << "\nproperty float x\nproperty float y\nproperty float z\nelement face ";
+	triangleCountOffset = file.tellp();
+	file << std::string(plyCountDigits, '0') << "\nproperty list uchar uint vertex_indices\nend_header\n";
+
+	return bool(file);
+}
+
+bool MeshWriter::writeVertices(const std::vector<glm::vec3>& vertices)
+{
+	if (format == meshOBJ)
+	{
+		char line[64];
+		for (const glm::vec3& vertex : vertices)
+		{
+			snprintf(line, sizeof(line), "v %.7g %.7g %.7g\n", vertex.x, vertex.y, vertex.z);
+			file << line;
+		}
+	}
+	else
+	{
+		std::vector<uint8_t> buffer;
+		buffer.reserve(vertices.size() * 3 * sizeof(float));
+		for (const glm::vec3& vertex : vertices)
+		{
+			putLittleEndian(buffer, vertex.x);
+			putLittleEndian(buffer, vertex.y);
+			putLittleEndian(buffer, vertex.z);
+		}
+		file.write((const char*)buffer.data(), buffer.size());
+	}
+
+	vertexCount += vertices.size();
+	return bool(file);
+}
+
+bool MeshWriter::writeTriangles(const std::vector<glm::uvec3>& triangles)
+{
+	if (format == meshOBJ)
+	{
+		// OBJ indices start at 1
+		char line[64];
+		for (const glm::uvec3& triangle : triangles)
+		{
+			snprintf(line, sizeof(line), "f %u %u %u\n", triangle.x + 1, triangle.y + 1, triangle.z + 1);
+			file << line;
+		}
+
+		triangleCount += triangles.size();
+		return bool(file);
+	}
+
+	std::vector<uint8_t> buffer;
+	buffer.reserve(triangles.size() * (1 + 3 * sizeof(uint32_t)));
+	for (const glm::uvec3& triangle : triangles)
+	{
+		buffer.push_back(3);
+		putLittleEndian(buffer, uint32_t(triangle.x));
+		putLittleEndian(buffer, uint32_t(triangle.y));
+		putLittleEndian(buffer, uint32_t(triangle.z));
+	}
+	triangleFile.write((const char*)buffer.data(), buffer.size());
+
+	triangleCount += triangles.size();
+	return bool(triangleFile);
+}
+
+void MeshWriter::writePLYCounts()
+{
+	char count[plyCountDigits + 1];
+
+	snprintf(count, sizeof(count), "%0*llu", plyCountDigits, (unsigned long long)vertexCount);
+	file.seekp(vertexCountOffset);
+	file.write(count, plyCountDigits);
+
+	snprintf(count, sizeof(count), "%0*llu", plyCountDigits, (unsigned long long)triangleCount);
+	file.seekp(triangleCountOffset);
+	file.write(count, plyCountDigits);
+}
+
+bool MeshWriter::appendTriangles()
+{
+	triangleFile.close();
+	if (triangleFile.fail())
+		return false;
+
+	std::ifstream triangles(trianglePath, std::ios::binary);
+	std::vector<char> buffer(copyBufferSize);
+
+	while (triangles.read(buffer.data(), buffer.size()) || triangles.gcount() > 0)
+		file.write(buffer.data(), triangles.gcount());
+
+	triangles.close();
+	std::remove(trianglePath.c_str());
+
+	return bool(file);
+}
+
+bool MeshWriter::close()
+{
+	if (!file.is_open())
+		return false;
+
+	bool success = bool(file);
+
+	if (format == meshPLY)
+	{
+		success = appendTriangles() && success;
+		writePLYCounts();
+	}
+
+	file.close();
+	success = success && !file.fail();
+
+	if (!success)
+		std::cout << "Failed to write mesh file: " << path << std::endl;
+
+	return success;
+}
+
+uint64_t MeshWriter::getVertexCount() const
+{
+	return vertexCount;
+}
+
+uint64_t MeshWriter::getTriangleCount() const
+{
+	return triangleCount;
+}
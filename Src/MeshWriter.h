@@ -0,0 +1,88 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	MeshWriter.h
+ *
+ */
+
+#pragma once
+
+#ifndef MESH_WRITER_H
+#define MESH_WRITER_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum MeshFormat { meshPLY, meshOBJ, meshUnknown };
+
+/**
+ * @brief Returns mesh format based on file extension
+ */
+MeshFormat meshFormatFromPath(const std::string& path);
+
+/**
+ * @brief Streaming triangle mesh writer
+ * Vertices and triangles are written in batches as they are extracted, so the size of the mesh is limited only by the disk.
+ * PLY is binary, its triangles are kept in a temporary file next to the mesh and appended after the last vertex.
+ * OBJ is text, triangles can only refer to vertices written before them.
+ */
+class MeshWriter
+{
+public:
+	MeshWriter();
+	~MeshWriter();
+
+	MeshWriter(const MeshWriter&) = delete;
+	MeshWriter& operator=(const MeshWriter&) = delete;
+
+	/**
+	 * @brief Creates the file and writes mesh header, format is chosen by file extension
+	 * @return TRUE if file was created, else FALSE
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * @brief Appends vertices, they are indexed in the order in which they were written
+	 * @return TRUE if vertices were written, else FALSE
+	 */
+	bool writeVertices(const std::vector<glm::vec3>& vertices);
+
+	/**
+	 * @brief Appends triangles given by indices of their vertices in counterclockwise order
+	 * @return TRUE if triangles were written, else FALSE
+	 */
+	bool writeTriangles(const std::vector<glm::uvec3>& triangles);
+
+	/**
+	 * @brief Writes end of the mesh and closes the file
+	 * @return TRUE if the mesh was completed and file was closed without error, else FALSE
+	 */
+	bool close();
+
+	uint64_t getVertexCount() const;
+
+	uint64_t getTriangleCount() const;
+
+private:
+	std::ofstream file;
+	std::ofstream triangleFile;
+	std::string path;
+	std::string trianglePath;
+	MeshFormat format;
+	uint64_t vertexCount;
+	uint64_t triangleCount;
+
+	// positions of vertex and triangle counts in PLY header, counts are known only when the mesh is closed
+	std::streamoff vertexCountOffset;
+	std::streamoff triangleCountOffset;
+
+	void writePLYCounts();
+	bool appendTriangles();
+};
+
+#endif // !MESH_WRITER_H
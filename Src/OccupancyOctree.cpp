@@ -0,0 +1,213 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	OccupancyOctree.cpp
+ *
+ */
+
+#include "OccupancyOctree.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// nodes of this size in leaves are classified by separate tasks
+const int buildTaskSize = 16;
+
+// rays are moved this part of a leaf past the exit of an empty node, so the next sample is in the next node
+const float exitOffset = 1e-3f;
+
+// largest number of empty nodes crossed by one call of emptySpan
+const int emptyNodesMax = 64;
+
+OccupancyOctree::OccupancyOctree()
+{
+	fractal = defaultFractal();
+	integerPower = getIntegerPower(fractal.power);
+	resolution = 0;
+	leafSize = 0.0f;
+}
+
+bool OccupancyOctree::mayContainSurface(glm::ivec3 node, int size) const
+{
+	glm::vec3 center = (glm::vec3(node) + 0.5f * float(size)) * leafSize - occupancyExtent;
+	float halfDiagonal = 0.5f * sqrt(3.0f) * float(size) * leafSize;
+
+	// negative estimation inside the fractal is not a distance, in the origin it is not a number
+	return !(mandelbulbDistance(fractal, integerPower, center) > halfDiagonal);
+}
+
+void OccupancyOctree::markLeaves(glm::ivec3 node, int size)
+{
+	if (!mayContainSurface(node, size))
+		return;
+
+	if (size == 1)
+	{
+		levels[0][(size_t(node.z) * resolution + node.y) * resolution + node.x] = 1;
+		return;
+	}
+
+	int half = size / 2;
+	for (int child = 0; child < 8; child++)
+		markLeaves(node + half * glm::ivec3(child & 1, (child >> 1) & 1, child >> 2), half);
+}
+
+void OccupancyOctree::build(const Fractal& fractal, int resolution, ThreadPool& pool)
+{
+	this->fractal = fractal;
+	this->resolution = resolution;
+	integerPower = getIntegerPower(fractal.power);
+	leafSize = 2.0f * occupancyExtent / float(resolution);
+
+	levels.clear();
+	for (int size = resolution; size >= 1; size /= 2)
+		levels.push_back(std::vector<uint8_t>(size_t(size) * size * size, 0));
+
+	// tasks mark disjoint leaves
+	int taskSize = std::min(resolution, buildTaskSize);
+	int tasksPerAxis = resolution / taskSize;
+
+	for (int z = 0; z < tasksPerAxis; z++)
+		for (int y = 0; y < tasksPerAxis; y++)
+			for (int x = 0; x < tasksPerAxis; x++)
+				pool.submit([this, x, y, z, taskSize]() { markLeaves(glm::ivec3(x, y, z) * taskSize, taskSize); });
+	pool.wait();
+
+	// node is occupied if any of its children is
+	for (size_t level = 1; level < levels.size(); level++)
+	{
+		int size = resolution >> level;
+		const std::vector<uint8_t>& children = levels[level - 1];
+
+		for (int z = 0; z < size; z++)
+		{
+			for (int y = 0; y < size; y++)
+			{
+				for (int x = 0; x < size; x++)
+				{
+					uint8_t occupied = 0;
+					for (int child = 0; child < 8; child++)
+					{
+						glm::ivec3 c = 2 * glm::ivec3(x, y, z) + glm::ivec3(child & 1, (child >> 1) & 1, child >> 2);
+						occupied |= children[(size_t(c.z) * 2 * size + c.y) * 2 * size + c.x];
+					}
+					levels[level][(size_t(z) * size + y) * size + x] = occupied;
+				}
+			}
+		}
+	}
+}
+
+bool OccupancyOctree::matches(const Fractal& fractal, int resolution) const
+{
+	return this->resolution == resolution && this->fractal.power == fractal.power && this->fractal.iterations == fractal.iterations;
+}
+
+float OccupancyOctree::emptySpan(glm::vec3 point, glm::vec3 dir) const
+{
+	glm::vec3 start = (point + occupancyExtent) / leafSize;
+	float span = 0.0f;
+
+	// ray walks through consecutive empty nodes until it gets to an occupied leaf or leaves the cube
+	for (int node = 0; node < emptyNodesMax; node++)
+	{
+		glm::vec3 position = start + span * dir;
+
+		float lowest = glm::min(glm::min(position.x, position.y), position.z);
+		float highest = glm::max(glm::max(position.x, position.y), position.z);
+		if (lowest < 0.0f || highest >= float(resolution))
+			break;
+
+		glm::ivec3 leaf = glm::ivec3(position);
+		if (levels[0][(size_t(leaf.z) * resolution + leaf.y) * resolution + leaf.x] != 0)
+			break;
+
+		// the largest empty ancestor of the leaf
+		int level = 0;
+		while (level + 1 < int(levels.size()))
+		{
+			int size = resolution >> (level + 1);
+			glm::ivec3 parent = glm::ivec3(leaf.x >> (level + 1), leaf.y >> (level + 1), leaf.z >> (level + 1));
+			if (levels[level + 1][(size_t(parent.z) * size + parent.y) * size + parent.x] != 0)
+				break;
+			level++;
+		}
+
+		float nodeSize = float(1 << level);
+		glm::vec3 nodeMin = glm::vec3(float(leaf.x >> level), float(leaf.y >> level), float(leaf.z >> level)) * nodeSize;
+
+		float exit = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (dir[axis] > 0.0f)
+				exit = std::min(exit, (nodeMin[axis] + nodeSize - position[axis]) / dir[axis]);
+			else if (dir[axis] < 0.0f)
+				exit = std::min(exit, (nodeMin[axis] - position[axis]) / dir[axis]);
+		}
+
+		span += exit + exitOffset;
+	}
+
+	return span * leafSize;
+}
+
+int OccupancyOctree::getResolution() const
+{
+	return resolution;
+}
+
+int OccupancyOctree::getLevelCount() const
+{
+	return int(levels.size());
+}
+
+float OccupancyOctree::getEmptyFraction() const
+{
+	if (levels.empty())
+		return 0.0f;
+
+	size_t occupied = std::count(levels[0].begin(), levels[0].end(), uint8_t(1));
+	return 1.0f - float(occupied) / float(levels[0].size());
+}
+
+size_t OccupancyOctree::getMemorySize() const
+{
+	size_t size = 0;
+	for (const std::vector<uint8_t>& level : levels)
+		size += level.size();
+	return size;
+}
+
+void OccupancyOctree::upload(GLuint& texture) const
+{
+	if (texture == 0)
+		glGenTextures(1, &texture);
+
+	glActiveTexture(GL_TEXTURE0 + occupancyUnit);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, int(levels.size()) - 1);
+
+	// rows of the coarse levels are shorter than default alignment
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		int size = resolution >> level;
+		glTexImage3D(GL_TEXTURE_3D, GLint(level), GL_R8UI, size, size, size, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, levels[level].data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void OccupancyOctree::setParameters(ShaderParameters& parameters) const
+{
+	parameters.octreeExtent = occupancyExtent;
+	parameters.octreeResolution = resolution;
+	parameters.octreeLevels = int(levels.size());
+	parameters.octreeLeafSize = leafSize;
+}
@@ -0,0 +1,113 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	OccupancyOctree.h
+ *
+ */
+
+#pragma once
+
+#ifndef OCCUPANCY_OCTREE_H
+#define OCCUPANCY_OCTREE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "ParameterBuffer.h"
+#include "Raymarcher.h"
+#include "ThreadPool.h"
+
+// half of the edge of the cube covered by the octree, cube contains bounding sphere of the mandelbulb
+const float occupancyExtent = 1.2f;
+
+// numbers of leaves along the edge of the cube selectable in GUI
+const int occupancyResolutions[] = { 64, 128, 256 };
+
+// texture unit of occupancy texture in compute shader
+const GLuint occupancyUnit = 4;
+
+/**
+ * @brief Conservative occupancy of the cube around the mandelbulb, stored as a full octree of bits
+ * Level 0 has one value per leaf, every next level halves the resolution and its node is occupied if any of its
+ * children is. Node is empty only if distance estimation in its center is larger than half of its diagonal,
+ * so the surface can not pass through it. Rays in an empty node jump to its exit instead of marching it.
+ */
+class OccupancyOctree
+{
+public:
+	OccupancyOctree();
+
+	/**
+	 * @brief Classifies nodes of the octree for the fractal, previous content is replaced
+	 * @param resolution Number of leaves along the edge of the cube, power of two
+	 * @param pool Threads that classify the nodes
+	 */
+	void build(const Fractal& fractal, int resolution, ThreadPool& pool);
+
+	/**
+	 * @brief Returns TRUE if the octree was built for given fractal and resolution
+	 */
+	bool matches(const Fractal& fractal, int resolution) const;
+
+	/**
+	 * @brief Returns distance along the ray to the exit of the largest empty node that contains the point,
+	 * same as emptySpan in compute shader
+	 * @param dir Normalized direction of the ray
+	 * @return 0 if the leaf of the point is occupied or the point is outside the cube
+	 */
+	float emptySpan(glm::vec3 point, glm::vec3 dir) const;
+
+	int getResolution() const;
+
+	int getLevelCount() const;
+
+	/**
+	 * @brief Returns part of the leaves that are empty
+	 */
+	float getEmptyFraction() const;
+
+	/**
+	 * @brief Returns size of all levels in bytes
+	 */
+	size_t getMemorySize() const;
+
+	/**
+	 * @brief Copies the levels to mipmaps of 3D texture bound to occupancyUnit
+	 * Texture is created if it is 0, otherwise it is replaced.
+	 */
+	void upload(GLuint& texture) const;
+
+	/**
+	 * @brief Sets parameters of the octree used by compute shader
+	 */
+	void setParameters(ShaderParameters& parameters) const;
+
+private:
+	// fractal and resolution of the built octree
+	Fractal fractal;
+	int integerPower;
+	int resolution;
+
+	// edge of a leaf
+	float leafSize;
+
+	// 1 for occupied and 0 for empty nodes of every level with x changing fastest, level 0 are leaves
+	std::vector<std::vector<uint8_t>> levels;
+
+	/**
+	 * @brief Returns TRUE if the surface can pass through the node
+	 * @param node Coordinates of the first leaf of the node
+	 * @param size Number of leaves along the edge of the node
+	 */
+	bool mayContainSurface(glm::ivec3 node, int size) const;
+
+	/**
+	 * @brief Marks leaves of the node that may contain the surface, empty nodes are not split
+	 */
+	void markLeaves(glm::ivec3 node, int size);
+};
+
+#endif // !OCCUPANCY_OCTREE_H
@@ -0,0 +1,560 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	OfflineRenderer.cpp
+ *
+ */
+
+#include "OfflineRenderer.h"
+#include "Distributed.h"
+#include "ImageWriter.h"
+#include "MeshExtractor.h"
+#include "RenderJob.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+// number of tile rows held in memory during rendering, the writer consumes them in order while the next ones are rendered
+const int bandsInFlight = 4;
+
+/**
+ * @brief Parses list of comma separated floats
+ * @return TRUE if list has expected number of values, else FALSE
+ */
+static bool parseFloatList(const std::string& text, float* values, int count)
+{
+	std::stringstream stream(text);
+	std::string item;
+	int i = 0;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (i >= count)
+			return false;
+		values[i++] = std::stof(item);
+	}
+
+	return i == count;
+}
+
+static bool parseSimdLevel(const std::string& text, SimdLevel& level)
+{
+	const SimdLevel levels[] = { simdScalar, simdSSE, simdAVX2, simdAVX512 };
+	const char* names[] = { "scalar", "sse", "avx2", "avx512" };
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (text == names[i])
+		{
+			level = levels[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool parseArguments(int argc, char** argv, RenderOptions& options)
+{
+	options.showHelp = false;
+	options.resumable = false;
+	options.workers = 0;
+	options.listenPort = -1;
+	options.programPath = argv[0];
+	options.meshResolution = 512;
+	options.resolution = glm::ivec2(1920, 1080);
+	options.view = 0;
+	options.cameraPosition = glm::vec3(0.0f);
+	options.cameraYaw = 0.0f;
+	options.cameraPitch = 0.0f;
+	options.fov = 45.0f;
+	options.threads = 0;
+	options.simdLevel = detectSimdLevel();
+	options.fractal = defaultFractal();
+	options.rendering = defaultRendering();
+	options.coloring = defaultColoring();
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string name = argv[i];
+
+		if (name == "--help" || name == "-h")
+		{
+			options.showHelp = true;
+			return true;
+		}
+
+		if (name == "--resumable")
+		{
+			options.resumable = true;
+			continue;
+		}
+
+		if (name == "--shadows")
+		{
+			options.rendering.shadows = true;
+			continue;
+		}
+
+		if (name == "--no-ao")
+		{
+			options.rendering.ambientOcclusion = false;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			std::cout << "Missing value of argument " << name << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+
+		try
+		{
+			if (name == "--render")
+				options.outputPath = value;
+			else if (name == "--mesh")
+				options.meshPath = value;
+			else if (name == "--mesh-resolution")
+				options.meshResolution = std::stoi(value);
+			else if (name == "--width")
+				options.resolution.x = std::stoi(value);
+			else if (name == "--height")
+				options.resolution.y = std::stoi(value);
+			else if (name == "--view")
+			{
+				// -1 is not a view, it marks the pose given by --camera
+				int view = std::stoi(value);
+				if (view < 1 || view > 4)
+				{
+					std::cout << "View has to be in range 1-4" << std::endl;
+					return false;
+				}
+				options.view = view - 1;
+			}
+			else if (name == "--camera")
+			{
+				float pose[5];
+				if (!parseFloatList(value, pose, 5))
+				{
+					std::cout << "Camera has to be given as x,y,z,yaw,pitch" << std::endl;
+					return false;
+				}
+				options.cameraPosition = glm::vec3(pose[0], pose[1], pose[2]);
+				options.cameraYaw = pose[3];
+				options.cameraPitch = pose[4];
+				options.view = -1;
+			}
+			else if (name == "--fov")
+				options.fov = std::stof(value);
+			else if (name == "--threads")
+				options.threads = (unsigned int)std::stoul(value);
+			else if (name == "--simd")
+			{
+				if (!parseSimdLevel(value, options.simdLevel))
+				{
+					std::cout << "Unknown instruction set: " << value << std::endl;
+					return false;
+				}
+			}
+			else if (name == "--workers")
+				options.workers = (unsigned int)std::stoul(value);
+			else if (name == "--listen")
+				options.listenPort = std::stoi(value);
+			else if (name == "--connect")
+				options.connectAddress = value;
+			else if (name == "--power")
+				options.fractal.power = std::stof(value);
+			else if (name == "--iterations")
+				options.fractal.iterations = std::stoi(value);
+			else if (name == "--steps")
+				options.rendering.maxSteps = std::stoi(value);
+			else if (name == "--detail")
+				options.rendering.detail = std::stof(value);
+			else if (name == "--detail-power")
+				options.rendering.detailPower = std::stof(value);
+			else if (name == "--shadow-softness")
+				options.rendering.shadowSoftness = std::stof(value);
+			else if (name == "--antialiasing")
+				options.rendering.antialiasing = std::stoi(value);
+			else if (name == "--light")
+			{
+				float light[3];
+				if (!parseFloatList(value, light, 3) || glm::length(glm::vec3(light[0], light[1], light[2])) == 0.0f)
+				{
+					std::cout << "Light direction has to be given as nonzero x,y,z" << std::endl;
+					return false;
+				}
+				options.rendering.lightPosition = glm::normalize(glm::vec3(light[0], light[1], light[2]));
+			}
+			else if (name == "--bg-color" || name == "--color" || name == "--o-trap-color" || name == "--y-trap-color")
+			{
+				glm::vec3* colors[] = { &options.coloring.bgColor, &options.coloring.fractalColor, &options.coloring.oTrapColor, &options.coloring.yTrapColor };
+				const char* names[] = { "--bg-color", "--color", "--o-trap-color", "--y-trap-color" };
+
+				float color[3];
+				if (!parseFloatList(value, color, 3))
+				{
+					std::cout << "Color has to be given as r,g,b" << std::endl;
+					return false;
+				}
+
+				for (int c = 0; c < 4; c++)
+					if (name == names[c])
+						*colors[c] = glm::vec3(color[0], color[1], color[2]);
+			}
+			else
+			{
+				std::cout << "Unknown argument: " << name << std::endl;
+				return false;
+			}
+		}
+		catch (std::logic_error e)
+		{
+			std::cout << "Invalid value of argument " << name << ": " << value << std::endl;
+			return false;
+		}
+	}
+
+	// worker gets all image options from the coordinator
+	if (!options.connectAddress.empty())
+		return true;
+
+	if (options.listenPort > 65535)
+	{
+		std::cout << "Port has to be in range 0-65535" << std::endl;
+		return false;
+	}
+
+	if (options.outputPath.empty() && options.meshPath.empty())
+	{
+		std::cout << "Output file has to be given with --render or --mesh" << std::endl;
+		return false;
+	}
+
+	if (options.meshResolution < meshBlockCells || options.meshResolution > meshResolutionMax || options.meshResolution % meshBlockCells != 0)
+	{
+		std::cout << "Mesh resolution has to be a multiple of " << meshBlockCells << " up to " << meshResolutionMax << std::endl;
+		return false;
+	}
+
+	if (options.resolution.x < 1 || options.resolution.y < 1)
+	{
+		std::cout << "Resolution has to be positive" << std::endl;
+		return false;
+	}
+
+	if (options.fractal.iterations < 1 || options.rendering.maxSteps < 1)
+	{
+		std::cout << "Iterations and marching steps have to be positive" << std::endl;
+		return false;
+	}
+
+	if (options.rendering.antialiasing < 1 || options.rendering.antialiasing > 16)
+	{
+		std::cout << "Antialiasing has to be in range 1-16" << std::endl;
+		return false;
+	}
+
+	if (options.simdLevel > detectSimdLevel())
+	{
+		std::cout << "Instruction set " << simdLevelToString(options.simdLevel) << " is not supported by this CPU" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " --render <file> [options]\n"
+		"       " << program << " --mesh <file> [options]\n"
+		"Renders fractal on CPU and saves it without opening a window.\n"
+		"Image is streamed to the file, so it can be larger than available memory.\n"
+		"Supported formats: .png, .ppm (8 bit), .pfm, .exr (32 bit float)\n"
+		"Mesh of the fractal surface is streamed to a .ply (binary) or .obj file.\n\n"
+		"Options:\n"
+		"  --width <pixels>          image width (1920)\n"
+		"  --height <pixels>         image height (1080)\n"
+		"  --view <1-4>              preset camera view (1)\n"
+		"  --camera <x,y,z,yaw,pitch> camera position and rotation in degrees\n"
+		"  --fov <degrees>           vertical field of view (45)\n"
+		"  --power <value>           fractal power (8)\n"
+		"  --iterations <count>      fractal iterations (6)\n"
+		"  --steps <count>           maximal number of marching steps (80)\n"
+		"  --detail <value>          rendering detail (4)\n"
+		"  --detail-power <value>    change of detail with distance (1.5)\n"
+		"  --shadows                 renders soft shadows\n"
+		"  --shadow-softness <value> softness of shadows, lower is softer (16)\n"
+		"  --no-ao                   disables ambient occlusion\n"
+		"  --light <x,y,z>           direction to the light (0,1.4,1.7)\n"
+		"  --antialiasing <1-16>     samples per pixel side (1)\n"
+		"  --bg-color <r,g,b>        background color (0.53,0.8,0.8)\n"
+		"  --color <r,g,b>           fractal color (0.334,0.42,0.184)\n"
+		"  --o-trap-color <r,g,b>    color near the origin trap (0.741,0.718,0.42)\n"
+		"  --y-trap-color <r,g,b>    color near the y plane trap (0.58,0.313,0)\n"
+		"  --mesh-resolution <cells> mesh cells along the edge of the cube around the fractal,\n"
+		"                            multiple of 16 (512)\n"
+		"  --threads <count>         number of rendering threads (all hardware threads)\n"
+		"  --simd <scalar|sse|avx2|avx512> instruction set of ray packets (best supported)\n"
+		"  --resumable               renders to a checkpointed partial image, killed render continues\n"
+		"                            where it stopped when started again with the same options\n"
+		"  --workers <count>         renders on a given number of local worker processes\n"
+		"  --listen <port>           accepts remote workers on a given port (0 chooses free port)\n"
+		"  --connect <host:port>     runs as a worker of the coordinator at a given address\n"
+		"  --help                    shows this help" << std::endl;
+}
+
+/**
+ * @brief Adds value to FNV-1a hash
+ */
+template <typename T>
+static void hashValue(uint64_t& hash, const T& value)
+{
+	const uint8_t* bytes = (const uint8_t*)&value;
+	for (size_t i = 0; i < sizeof(T); i++)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+}
+
+uint64_t hashImageOptions(const RenderOptions& options)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	hashValue(hash, options.resolution.x);
+	hashValue(hash, options.resolution.y);
+	hashValue(hash, options.view);
+	if (options.view < 0)
+	{
+		hashValue(hash, options.cameraPosition.x);
+		hashValue(hash, options.cameraPosition.y);
+		hashValue(hash, options.cameraPosition.z);
+		hashValue(hash, options.cameraYaw);
+		hashValue(hash, options.cameraPitch);
+	}
+	hashValue(hash, options.fov);
+	hashValue(hash, options.fractal.power);
+	hashValue(hash, options.fractal.iterations);
+	hashValue(hash, options.rendering.maxSteps);
+	hashValue(hash, options.rendering.detail);
+	hashValue(hash, options.rendering.detailPower);
+	hashValue(hash, options.rendering.shadows);
+	hashValue(hash, options.rendering.shadowSoftness);
+	hashValue(hash, options.rendering.ambientOcclusion);
+	hashValue(hash, options.rendering.antialiasing);
+	hashValue(hash, options.rendering.lightPosition.x);
+	hashValue(hash, options.rendering.lightPosition.y);
+	hashValue(hash, options.rendering.lightPosition.z);
+
+	const glm::vec3* colors[] = { &options.coloring.bgColor, &options.coloring.fractalColor, &options.coloring.oTrapColor, &options.coloring.yTrapColor };
+	for (const glm::vec3* color : colors)
+	{
+		hashValue(hash, color->x);
+		hashValue(hash, color->y);
+		hashValue(hash, color->z);
+	}
+
+	// tiles marched by scalar and packet kernels differ slightly, packet instruction sets give the same result
+	hashValue(hash, uint8_t(options.simdLevel == simdScalar ? 0 : 1));
+
+	return hash;
+}
+
+void reportProgress(int done, int total, int& reported)
+{
+	int progress = int(100.0 * done / total);
+	if (progress / 10 != reported / 10)
+	{
+		reported = progress;
+		std::cout << progress << " %" << std::endl;
+	}
+}
+
+/**
+ * @brief Renders image by bands and streams it directly to the output file
+ */
+static bool renderStreamed(const RenderOptions& options, const Raymarcher& raymarcher, TileRenderer& tileRenderer)
+{
+	ImageWriter writer;
+	if (!writer.open(options.outputPath, options.resolution.x, options.resolution.y))
+		return false;
+
+	// whole frame is never held in memory, only a few bands of tiles are, so the size of the image is limited only by the disk
+	size_t bandMemory = size_t(options.resolution.x) * tileDimensions.y * sizeof(glm::vec4) * bandsInFlight;
+	std::cout << (bandMemory >> 20) + 1 << " MB of image buffers" << std::endl;
+
+	int reportedProgress = -1;
+
+	bool success = tileRenderer.renderBands(raymarcher, options.resolution, bandsInFlight,
+		[&](const glm::vec4* data, int firstRow, int rowCount)
+		{
+			// band is stored from the bottom row, image is written from the top row
+			for (int y = rowCount - 1; y >= 0; y--)
+				if (!writer.writeRow(data + size_t(y) * options.resolution.x))
+					return false;
+
+			reportProgress(options.resolution.y - firstRow, options.resolution.y, reportedProgress);
+
+			return true;
+		});
+
+	return writer.close() && success;
+}
+
+/**
+ * @brief Renders tiles that are not finished in the checkpoint of the job, saves the image once all tiles are finished
+ */
+static bool renderResumable(const RenderOptions& options, const Raymarcher& raymarcher, TileRenderer& tileRenderer)
+{
+	RenderJob job;
+	if (!job.open(options.outputPath, options.resolution, tileDimensions, hashImageOptions(options)))
+		return false;
+
+	std::vector<Tile> allTiles = tileRenderer.createTiles(options.resolution);
+	std::vector<Tile> tiles;
+	std::vector<int> indices;
+
+	for (int i = 0; i < int(allTiles.size()); i++)
+	{
+		if (!job.isTileDone(i))
+		{
+			tiles.push_back(allTiles[i]);
+			indices.push_back(i);
+		}
+	}
+
+	if (job.getResumedTiles() > 0)
+		std::cout << "Resuming job, " << job.getResumedTiles() << " of " << allTiles.size() << " tiles are finished" << std::endl;
+
+	std::mutex progressMutex;
+	int doneTiles = job.getResumedTiles();
+	int reportedProgress = -1;
+
+	installTerminationHandler();
+
+	tileRenderer.renderTiles(raymarcher, tiles, [&](int index, const glm::vec4* data)
+	{
+		job.storeTile(indices[index], tiles[index], data);
+
+		std::lock_guard<std::mutex> lock(progressMutex);
+		reportProgress(++doneTiles, int(allTiles.size()), reportedProgress);
+
+		// tiles being rendered by the other threads are lost, the rest is resumed
+		if (isTerminationRequested())
+		{
+			job.sync();
+			std::cout << std::endl << "Terminated, job is kept for resuming" << std::endl;
+			std::_Exit(EXIT_FAILURE);
+		}
+	});
+
+	return job.finish();
+}
+
+Camera createCamera(const RenderOptions& options)
+{
+	Camera camera = Camera(glm::vec3(0.0f, 2.5f, 5.0f), glm::vec3(0.0f, -0.5f, -1.0f), options.fov);
+
+	if (options.view >= 0)
+		camera.setView(options.view);
+	else
+		camera.setPose(options.cameraPosition, options.cameraYaw, options.cameraPitch);
+
+	return camera;
+}
+
+bool exportMesh(const RenderOptions& options)
+{
+	MeshWriter writer;
+	if (!writer.open(options.meshPath))
+		return false;
+
+	ThreadPool pool(options.threads);
+	MeshExtractor extractor(&pool);
+
+	std::cout << "Extracting mesh with " << options.meshResolution << "^3 cells on " << pool.getThreadCount() << " threads" << std::endl;
+
+	auto startT = std::chrono::steady_clock::now();
+
+	int reportedProgress = -1;
+	bool success = extractor.extract(options.fractal, options.meshResolution, writer, [&](int done, int total)
+	{
+		reportProgress(done, total, reportedProgress);
+	});
+
+	success = writer.close() && success;
+
+	auto endT = std::chrono::steady_clock::now();
+
+	if (!success)
+		return false;
+
+	std::cout << "Octree sampled " << extractor.getBlockCount() << " of " << extractor.getFullBlockCount() << " blocks" << std::endl;
+	std::cout << "Extracted in " << std::chrono::duration<double>(endT - startT).count() << " seconds" << std::endl;
+	std::cout << "Mesh with " << writer.getVertexCount() << " vertices and " << writer.getTriangleCount() << " triangles saved to " << options.meshPath << std::endl;
+
+	return true;
+}
+
+int renderOffline(const RenderOptions& options)
+{
+	if (!options.connectAddress.empty())
+		return runWorker(options);
+
+	if (!options.meshPath.empty())
+	{
+		if (!exportMesh(options))
+			return -1;
+
+		if (options.outputPath.empty())
+			return 0;
+	}
+
+	if (options.workers > 0 || options.listenPort >= 0)
+	{
+		auto startT = std::chrono::steady_clock::now();
+		if (!renderDistributed(options))
+			return -1;
+
+		auto endT = std::chrono::steady_clock::now();
+		std::cout << "Rendered in " << std::chrono::duration<double>(endT - startT).count() << " seconds" << std::endl;
+		std::cout << "Image saved to " << options.outputPath << std::endl;
+
+		return 0;
+	}
+
+	Camera camera = createCamera(options);
+
+	Fractal fractal = options.fractal;
+	Rendering rendering = options.rendering;
+	Coloring coloring = options.coloring;
+
+	Raymarcher raymarcher(options.resolution, &camera, &fractal, &rendering, &coloring);
+	raymarcher.setSimdLevel(options.simdLevel);
+
+	ThreadPool pool(options.threads);
+	TileRenderer tileRenderer(&pool);
+
+	std::cout << "Rendering " << options.resolution.x << "x" << options.resolution.y << " on "
+		<< pool.getThreadCount() << " threads (" << simdLevelToString(options.simdLevel) << ")" << std::endl;
+
+	auto startT = std::chrono::steady_clock::now();
+
+	bool success = options.resumable ?
+		renderResumable(options, raymarcher, tileRenderer) :
+		renderStreamed(options, raymarcher, tileRenderer);
+
+	auto endT = std::chrono::steady_clock::now();
+
+	if (!success)
+		return -1;
+
+	std::cout << "Rendered in " << std::chrono::duration<double>(endT - startT).count() << " seconds" << std::endl;
+	std::cout << "Image saved to " << options.outputPath << std::endl;
+
+	return 0;
+}
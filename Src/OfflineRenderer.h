@@ -0,0 +1,87 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	OfflineRenderer.h
+ *
+ */
+
+#pragma once
+
+#ifndef OFFLINE_RENDERER_H
+#define OFFLINE_RENDERER_H
+
+#include <cstdint>
+#include <string>
+#include "TileRenderer.h"
+
+/**
+ * @brief Parameters of headless rendering given on command line
+ */
+typedef struct renderOptions
+{
+	bool showHelp;
+	bool resumable;				// tiles are checkpointed, so the render can be resumed after it is killed
+	std::string outputPath;
+	std::string meshPath;		// mesh of the surface is exported if it is not empty
+	int meshResolution;			// number of cells of the mesh along the edge of the cube around the fractal
+	glm::ivec2 resolution;
+	int view;					// preset view of the camera, -1 if pose is given explicitly
+	glm::vec3 cameraPosition;
+	float cameraYaw;
+	float cameraPitch;
+	float fov;					// vertical field of view in degrees
+	unsigned int threads;		// 0 means one thread per hardware thread
+	SimdLevel simdLevel;
+	Fractal fractal;
+	Rendering rendering;
+	Coloring coloring;
+	unsigned int workers;		// number of local worker processes of distributed rendering
+	int listenPort;				// port on which coordinator accepts remote workers, -1 if they are not expected
+	std::string connectAddress;	// address of the coordinator if this process is a worker
+	std::string programPath;	// path of this program, used for starting local workers
+} RenderOptions;
+
+/**
+ * @brief Parses command line arguments of headless mode
+ * @param options Parsed options, unspecified options have default values
+ * @return TRUE if arguments are valid, else FALSE
+ */
+bool parseArguments(int argc, char** argv, RenderOptions& options);
+
+/**
+ * @brief Prints description of command line arguments
+ */
+void printUsage(const char* program);
+
+/**
+ * @brief Creates camera described by the options
+ */
+Camera createCamera(const RenderOptions& options);
+
+/**
+ * @brief Returns hash of all options that affect rendered image
+ */
+uint64_t hashImageOptions(const RenderOptions& options);
+
+/**
+ * @brief Prints progress of rendering in steps of 10 %
+ * @param reported Last printed progress in percent, -1 if nothing was printed yet
+ */
+void reportProgress(int done, int total, int& reported);
+
+/**
+ * @brief Extracts surface of the fractal and streams it to a mesh file
+ * @return TRUE if the mesh was saved, else FALSE
+ */
+bool exportMesh(const RenderOptions& options);
+
+/**
+ * @brief Renders image with CPU raymarcher and streams it to a file, no window or OpenGL context is created
+ * Mesh is exported before rendering, if it was requested.
+ * @return Exit code of the program
+ */
+int renderOffline(const RenderOptions& options);
+
+#endif // !OFFLINE_RENDERER_H
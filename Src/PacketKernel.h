@@ -0,0 +1,440 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	PacketKernel.h
+ *
+ */
+
+#pragma once
+
+#ifndef PACKET_KERNEL_H
+#define PACKET_KERNEL_H
+
+#include "RayPacket.h"
+
+/**
+ * Generic packet raymarcher written on top of a SIMD vector type V.
+ * It is included by every PacketKernel*.cpp file, which defines V for its instruction set.
+ * Everything here has to be a template on V, otherwise the linker could mix up functions
+ * compiled for different instruction sets.
+ *
+ * V has to provide:
+ *	V::width, V::Mask, V::Int, V(float), V::load(const float*), V::laneMask(int count)
+ *	operators + - * / and unary -, comparisons < <= > >= returning V::Mask
+ *	vmin, vmax, vabs, vsqrt, select(mask, ifTrue, ifFalse), store(float*, V)
+ *	V::Mask: operators & | ^, andNot(a, b) = a & ~b, any(mask)
+ *	V::Int: V::Int(int), operators + - &, shiftLeft23, shiftRight23, intEqual returning V::Mask
+ *	toIntRound, toIntTrunc, toFloat, asInt, asFloat
+ *
+ * Kernels don't use fused multiply-add, so all instruction sets produce identical results.
+ * Math functions are polynomial approximations from Cephes library (http://www.netlib.org/cephes/).
+ */
+
+namespace packet
+{
+	const float pi = 3.14159265358979f;
+	const float halfPi = 1.57079632679490f;
+	const float quarterPi = 0.78539816339745f;
+
+	/**
+	 * @brief Natural logarithm, x has to be positive and normal
+	 */
+	template<typename V>
+	V vlog(V x)
+	{
+		typedef typename V::Int I;
+
+		// x = m * 2^e, m in [0.5, 1)
+		I bits = asInt(x);
+		V e = toFloat(shiftRight23(bits) - I(126));
+		V m = asFloat((bits & I(0x007fffff)) | I(0x3f000000));
+
+		// m in [sqrt(0.5), sqrt(2))
+		typename V::Mask small = m < V(0.707106781186547524f);
+		e = select(small, e - V(1.0f), e);
+		m = select(small, m + m - V(1.0f), m - V(1.0f));
+
+		V z = m * m;
+		V y = V(7.0376836292E-2f);
+		y = y * m + V(-1.1514610310E-1f);
+		y = y * m + V(1.1676998740E-1f);
+		y = y * m + V(-1.2420140846E-1f);
+		y = y * m + V(1.4249322787E-1f);
+		y = y * m + V(-1.6668057665E-1f);
+		y = y * m + V(2.0000714765E-1f);
+		y = y * m + V(-2.4999993993E-1f);
+		y = y * m + V(3.3333331174E-1f);
+		y = y * m * z;
+
+		y = y + e * V(-2.12194440e-4f);
+		y = y - V(0.5f) * z;
+		return m + y + e * V(0.693359375f);
+	}
+
+	template<typename V>
+	V vexp(V x)
+	{
+		typedef typename V::Int I;
+
+		x = vmin(vmax(x, V(-87.3365f)), V(88.3762f));
+
+		// x = n * ln(2) + r
+		I n = toIntRound(x * V(1.44269504088896341f));
+		V fn = toFloat(n);
+		x = x - fn * V(0.693359375f);
+		x = x - fn * V(-2.12194440e-4f);
+
+		V z = x * x;
+		V y = V(1.9875691500E-4f);
+		y = y * x + V(1.3981999507E-3f);
+		y = y * x + V(8.3334519073E-3f);
+		y = y * x + V(4.1665795894E-2f);
+		y = y * x + V(1.6666665459E-1f);
+		y = y * x + V(5.0000001201E-1f);
+		y = y * z + x + V(1.0f);
+
+		// multiply by 2^n
+		return y * asFloat(shiftLeft23(n + I(127)));
+	}
+
+	/**
+	 * @brief x^y for x >= 0
+	 */
+	template<typename V>
+	V vpow(V x, V y)
+	{
+		return select(x > V(0.0f), vexp(y * vlog(x)), V(0.0f));
+	}
+
+	template<typename V>
+	void vsincos(V x, V& s, V& c)
+	{
+		typedef typename V::Int I;
+		typedef typename V::Mask M;
+
+		M negative = x < V(0.0f);
+		x = vabs(x);
+
+		// octant of the angle, rounded to even
+		I j = toIntTrunc(x * V(1.27323954473516f));
+		j = (j + I(1)) & I(~1);
+		V y = toFloat(j);
+
+		// extended precision modular arithmetic
+		x = x - y * V(0.78515625f);
+		x = x - y * V(2.4187564849853515625e-4f);
+		x = x - y * V(3.77489497744594108e-8f);
+
+		V z = x * x;
+
+		V polyCos = V(2.443315711809948E-005f);
+		polyCos = polyCos * z + V(-1.388731625493765E-003f);
+		polyCos = polyCos * z + V(4.166664568298827E-002f);
+		polyCos = polyCos * z * z - V(0.5f) * z + V(1.0f);
+
+		V polySin = V(-1.9515295891E-4f);
+		polySin = polySin * z + V(8.3321608736E-3f);
+		polySin = polySin * z + V(-1.6666654611E-1f);
+		polySin = polySin * z * x + x;
+
+		M useSinPoly = intEqual(j & I(2), I(0));
+		M flipSin = intEqual(j & I(4), I(4)) ^ negative;
+		M flipCos = intEqual((j - I(2)) & I(4), I(0));
+
+		s = select(useSinPoly, polySin, polyCos);
+		c = select(useSinPoly, polyCos, polySin);
+		s = select(flipSin, -s, s);
+		c = select(flipCos, -c, c);
+	}
+
+	template<typename V>
+	V vacos(V x)
+	{
+		typedef typename V::Mask M;
+
+		x = vmin(vmax(x, V(-1.0f)), V(1.0f));
+		V a = vabs(x);
+
+		// asin(a) = asin(sqrt(z)) for a > 0.5
+		M big = a > V(0.5f);
+		V z = select(big, V(0.5f) * (V(1.0f) - a), a * a);
+		V s = select(big, vsqrt(z), a);
+
+		V p = V(4.2163199048E-2f);
+		p = p * z + V(2.4181311049E-2f);
+		p = p * z + V(4.5470025998E-2f);
+		p = p * z + V(7.4953002686E-2f);
+		p = p * z + V(1.6666752422E-1f);
+		p = p * z * s + s;
+
+		// a > 0.5: acos(x) = 2 * asin(sqrt((1 - x) / 2)), else acos(x) = pi / 2 - asin(x)
+		M negative = x < V(0.0f);
+		V bigResult = select(negative, V(pi) - (p + p), p + p);
+		V smallResult = V(halfPi) - select(negative, -p, p);
+		return select(big, bigResult, smallResult);
+	}
+
+	template<typename V>
+	V vatan2(V y, V x)
+	{
+		typedef typename V::Mask M;
+
+		V ax = vabs(x);
+		V ay = vabs(y);
+		V minimum = vmin(ax, ay);
+		V maximum = vmax(ax, ay);
+
+		// a in [0, 1]
+		V a = select(maximum > V(0.0f), minimum / maximum, V(0.0f));
+
+		M big = a > V(0.4142135623730950f);
+		V t = select(big, (a - V(1.0f)) / (a + V(1.0f)), a);
+		V z = t * t;
+
+		V r = V(8.05374449538e-2f);
+		r = r * z + V(-1.38776856032e-1f);
+		r = r * z + V(1.99777106478e-1f);
+		r = r * z + V(-3.33329491539e-1f);
+		r = r * z * t + t + select(big, V(quarterPi), V(0.0f));
+
+		r = select(ay > ax, V(halfPi) - r, r);
+		r = select(x < V(0.0f), V(pi) - r, r);
+		return select(y < V(0.0f), -r, r);
+	}
+
+	/**
+	 * @brief Integer power of complex number (re, im) by binary exponentiation
+	 */
+	template<typename V>
+	void complexPow(V& re, V& im, int n)
+	{
+		V resultRe = V(1.0f), resultIm = V(0.0f);
+
+		for (; n > 0; n >>= 1)
+		{
+			if (n & 1)
+			{
+				V t = resultRe * re - resultIm * im;
+				resultIm = resultRe * im + resultIm * re;
+				resultRe = t;
+			}
+			V t = re * re - im * im;
+			im = V(2.0f) * re * im;
+			re = t;
+		}
+
+		re = resultRe;
+		im = resultIm;
+	}
+
+	template<typename V>
+	V realPow(V x, int n)
+	{
+		V result = V(1.0f);
+
+		for (; n > 0; n >>= 1)
+		{
+			if (n & 1)
+				result = result * x;
+			x = x * x;
+		}
+
+		return result;
+	}
+
+	/**
+	 * @brief Mandelbulb of integer power in triplex algebra, same as mandelbulbTriplexSDF in Raymarcher
+	 */
+	template<typename V>
+	V mandelbulbTriplexSDF(V px, V py, V pz, const MarchParams& params)
+	{
+		typedef typename V::Mask M;
+
+		int n = params.integerPower;
+		V power = V(float(n));
+
+		V wx = px, wy = py, wz = pz;
+		V m = wx * wx + wy * wy + wz * wz;
+		V dz = V(1.0f);
+
+		M active = V::laneMask(V::width);
+
+		for (int i = 0; i < params.iterations; i++)
+		{
+			V newDz = power * realPow(vsqrt(m), n - 1) * dz + V(1.0f);
+
+			V rho = vsqrt(wx * wx + wz * wz);
+			V thetaRe = wy, thetaIm = rho;
+			complexPow(thetaRe, thetaIm, n);
+
+			M onAxis = rho <= V(0.0f);
+			V safeRho = select(onAxis, V(1.0f), rho);
+			V phiRe = select(onAxis, V(1.0f), wz / safeRho);
+			V phiIm = select(onAxis, V(0.0f), wx / safeRho);
+			complexPow(phiRe, phiIm, n);
+
+			V newX = px + thetaIm * phiIm;
+			V newY = py + thetaRe;
+			V newZ = pz + thetaIm * phiRe;
+
+			dz = select(active, newDz, dz);
+			wx = select(active, newX, wx);
+			wy = select(active, newY, wy);
+			wz = select(active, newZ, wz);
+			m = select(active, wx * wx + wy * wy + wz * wz, m);
+
+			active = andNot(active, m > V(256.0f));
+			if (!any(active))
+				break;
+		}
+
+		return V(0.25f) * vlog(m) * vsqrt(m) / dz;
+	}
+
+	/**
+	 * @brief Distance estimation of Mandelbulb, same as Raymarcher::mandelbulbSDF
+	 */
+	template<typename V>
+	V mandelbulbSDF(V px, V py, V pz, const MarchParams& params)
+	{
+		typedef typename V::Mask M;
+
+		if (params.integerPower != 0)
+			return mandelbulbTriplexSDF(px, py, pz, params);
+
+		V power = V(params.power);
+		V powerMinusOne = V(params.power - 1.0f);
+
+		V wx = px, wy = py, wz = pz;
+		V m = wx * wx + wy * wy + wz * wz;
+		V dz = V(1.0f);
+
+		// lanes which didn't escape yet
+		M active = V::laneMask(V::width);
+
+		for (int i = 0; i < params.iterations; i++)
+		{
+			V r = vsqrt(m);
+
+			// r^(power-1) is shared by derivative and the next point
+			V rPow = vpow(r, powerMinusOne);
+			V newDz = power * rPow * dz + V(1.0f);
+
+			V b = power * vacos(wy / r);
+			V a = power * vatan2(wx, wz);
+			rPow = rPow * r;
+
+			V sinB, cosB, sinA, cosA;
+			vsincos(b, sinB, cosB);
+			vsincos(a, sinA, cosA);
+
+			V newX = px + rPow * (sinB * sinA);
+			V newY = py + rPow * cosB;
+			V newZ = pz + rPow * (sinB * cosA);
+
+			dz = select(active, newDz, dz);
+			wx = select(active, newX, wx);
+			wy = select(active, newY, wy);
+			wz = select(active, newZ, wz);
+			m = select(active, wx * wx + wy * wy + wz * wz, m);
+
+			active = andNot(active, m > V(256.0f));
+			if (!any(active))
+				break;
+		}
+
+		return V(0.25f) * vlog(m) * vsqrt(m) / dz;
+	}
+
+	/**
+	 * @brief Marches one chunk of V::width rays starting at a given lane of the packet
+	 */
+	template<typename V>
+	void marchChunk(const MarchParams& params, const RayPacket& packet, PacketResult& result, int offset)
+	{
+		typedef typename V::Mask M;
+
+		V ox = V(packet.origin[0]);
+		V oy = V(packet.origin[1]);
+		V oz = V(packet.origin[2]);
+		V dx = V::load(packet.dirX + offset);
+		V dy = V::load(packet.dirY + offset);
+		V dz = V::load(packet.dirZ + offset);
+
+		V minDist = V(params.minDist);
+		V detailPower = V(params.detailPower);
+		V farPlane = V(params.farPlane);
+
+		V totalDist = V(params.startDist);
+		V sampleDist = V(0.0f), lastDist = V(0.0f), epsilon = V(0.0f), steps = V(0.0f);
+
+		// rays which are still marching
+		M active = V::laneMask(packet.count - offset);
+		M hit = V::laneMask(0);
+		M missed = V::laneMask(0);
+
+		for (int step = 0; step < params.maxSteps; step++)
+		{
+			V t = totalDist;
+			V dist = mandelbulbSDF(ox + t * dx, oy + t * dy, oz + t * dz, params);
+
+			// Move along the view ray
+			totalDist = select(active, t + dist, t);
+
+			V eps = vmin(vmax(minDist * vpow(totalDist, detailPower), minDist), farPlane);
+
+			// Ray is inside the scene surface
+			M hitNow = active & (dist < eps);
+			sampleDist = select(hitNow, t, sampleDist);
+			lastDist = select(hitNow, dist, lastDist);
+			epsilon = select(hitNow, eps, epsilon);
+			steps = select(hitNow, V(float(step)), steps);
+			hit = hit | hitNow;
+			active = andNot(active, hitNow);
+
+			// Ray reached far plane
+			M missedNow = active & (totalDist >= farPlane);
+			missed = missed | missedNow;
+			active = andNot(active, missedNow);
+
+			if (!any(active))
+				break;
+		}
+
+		V hitLanes = select(hit, V(1.0f), V(0.0f));
+		V missedLanes = select(missed, V(1.0f), V(0.0f));
+
+		float hitValues[maxPacketWidth], missedValues[maxPacketWidth], stepValues[maxPacketWidth];
+		store(result.sampleDist + offset, sampleDist);
+		store(result.lastDist + offset, lastDist);
+		store(result.epsilon + offset, epsilon);
+		store(stepValues, steps);
+		store(hitValues, hitLanes);
+		store(missedValues, missedLanes);
+
+		for (int i = 0; i < V::width; i++)
+		{
+			if (hitValues[i] != 0.0f)
+			{
+				result.status[offset + i] = marchHit;
+				result.steps[offset + i] = int(stepValues[i]);
+			}
+			else
+			{
+				result.status[offset + i] = (missedValues[i] != 0.0f) ? marchMissed : marchExhausted;
+				result.steps[offset + i] = params.maxSteps;
+			}
+		}
+	}
+
+	template<typename V>
+	void marchPacket(const MarchParams& params, const RayPacket& packet, PacketResult& result)
+	{
+		for (int offset = 0; offset < packet.count; offset += V::width)
+			marchChunk<V>(params, packet, result, offset);
+	}
+}
+
+#endif // !PACKET_KERNEL_H
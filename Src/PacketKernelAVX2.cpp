@@ -0,0 +1,101 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	PacketKernelAVX2.cpp
+ *
+ */
+
+#include "RayPacket.h"
+
+#ifdef PACKET_KERNELS_X86
+
+// compiled with AVX2 enabled, called only if the CPU supports it
+#include <immintrin.h>
+
+namespace
+{
+	struct MaskAVX2
+	{
+		__m256 v;
+	};
+
+	struct IntAVX2
+	{
+		__m256i v;
+		IntAVX2() {}
+		explicit IntAVX2(__m256i value) : v(value) {}
+		explicit IntAVX2(int value) : v(_mm256_set1_epi32(value)) {}
+	};
+
+	// 8 lanes of AVX2
+	struct FloatAVX2
+	{
+		typedef MaskAVX2 Mask;
+		typedef IntAVX2 Int;
+		static const int width = 8;
+
+		__m256 v;
+		FloatAVX2() {}
+		explicit FloatAVX2(__m256 value) : v(value) {}
+		explicit FloatAVX2(float value) : v(_mm256_set1_ps(value)) {}
+
+		static FloatAVX2 load(const float* p) { return FloatAVX2(_mm256_loadu_ps(p)); }
+
+		static Mask laneMask(int count)
+		{
+			Mask m;
+			m.v = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+			return m;
+		}
+	};
+
+	typedef FloatAVX2 V;
+	typedef MaskAVX2 M;
+	typedef IntAVX2 I;
+
+	inline V operator+(V a, V b) { return V(_mm256_add_ps(a.v, b.v)); }
+	inline V operator-(V a, V b) { return V(_mm256_sub_ps(a.v, b.v)); }
+	inline V operator*(V a, V b) { return V(_mm256_mul_ps(a.v, b.v)); }
+	inline V operator/(V a, V b) { return V(_mm256_div_ps(a.v, b.v)); }
+	inline V operator-(V a) { return V(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+	inline M operator<(V a, V b) { M m; m.v = _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); return m; }
+	inline M operator<=(V a, V b) { M m; m.v = _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); return m; }
+	inline M operator>(V a, V b) { M m; m.v = _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); return m; }
+	inline M operator>=(V a, V b) { M m; m.v = _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); return m; }
+	inline V vmin(V a, V b) { return V(_mm256_min_ps(a.v, b.v)); }
+	inline V vmax(V a, V b) { return V(_mm256_max_ps(a.v, b.v)); }
+	inline V vabs(V a) { return V(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+	inline V vsqrt(V a) { return V(_mm256_sqrt_ps(a.v)); }
+	inline V select(M m, V a, V b) { return V(_mm256_blendv_ps(b.v, a.v, m.v)); }
+	inline void store(float* p, V a) { _mm256_storeu_ps(p, a.v); }
+
+	inline M operator&(M a, M b) { M m; m.v = _mm256_and_ps(a.v, b.v); return m; }
+	inline M operator|(M a, M b) { M m; m.v = _mm256_or_ps(a.v, b.v); return m; }
+	inline M operator^(M a, M b) { M m; m.v = _mm256_xor_ps(a.v, b.v); return m; }
+	inline M andNot(M a, M b) { M m; m.v = _mm256_andnot_ps(b.v, a.v); return m; }
+	inline bool any(M a) { return _mm256_movemask_ps(a.v) != 0; }
+
+	inline I operator+(I a, I b) { return I(_mm256_add_epi32(a.v, b.v)); }
+	inline I operator-(I a, I b) { return I(_mm256_sub_epi32(a.v, b.v)); }
+	inline I operator&(I a, I b) { return I(_mm256_and_si256(a.v, b.v)); }
+	inline I operator|(I a, I b) { return I(_mm256_or_si256(a.v, b.v)); }
+	inline I shiftLeft23(I a) { return I(_mm256_slli_epi32(a.v, 23)); }
+	inline I shiftRight23(I a) { return I(_mm256_srli_epi32(a.v, 23)); }
+	inline M intEqual(I a, I b) { M m; m.v = _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v)); return m; }
+	inline I toIntRound(V a) { return I(_mm256_cvtps_epi32(a.v)); }
+	inline I toIntTrunc(V a) { return I(_mm256_cvttps_epi32(a.v)); }
+	inline V toFloat(I a) { return V(_mm256_cvtepi32_ps(a.v)); }
+	inline I asInt(V a) { return I(_mm256_castps_si256(a.v)); }
+	inline V asFloat(I a) { return V(_mm256_castsi256_ps(a.v)); }
+}
+
+#include "PacketKernel.h"
+
+void marchPacketAVX2(const MarchParams& params, const RayPacket& packet, PacketResult& result)
+{
+	packet::marchPacket<FloatAVX2>(params, packet, result);
+}
+
+#endif // PACKET_KERNELS_X86
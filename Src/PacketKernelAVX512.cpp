@@ -0,0 +1,103 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	PacketKernelAVX512.cpp
+ *
+ */
+
+#include "RayPacket.h"
+
+#ifdef PACKET_KERNELS_X86
+
+// compiled with AVX-512F enabled, called only if the CPU supports it
+#include <immintrin.h>
+
+namespace
+{
+	struct MaskAVX512
+	{
+		__mmask16 v;
+	};
+
+	struct IntAVX512
+	{
+		__m512i v;
+		IntAVX512() {}
+		explicit IntAVX512(__m512i value) : v(value) {}
+		explicit IntAVX512(int value) : v(_mm512_set1_epi32(value)) {}
+	};
+
+	// 16 lanes of AVX-512, lanes are masked with k registers
+	struct FloatAVX512
+	{
+		typedef MaskAVX512 Mask;
+		typedef IntAVX512 Int;
+		static const int width = 16;
+
+		__m512 v;
+		FloatAVX512() {}
+		explicit FloatAVX512(__m512 value) : v(value) {}
+		explicit FloatAVX512(float value) : v(_mm512_set1_ps(value)) {}
+
+		static FloatAVX512 load(const float* p) { return FloatAVX512(_mm512_loadu_ps(p)); }
+
+		static Mask laneMask(int count)
+		{
+			Mask m;
+			m.v = (count >= 16) ? __mmask16(0xFFFF) : (count <= 0) ? __mmask16(0) : __mmask16((1u << count) - 1u);
+			return m;
+		}
+	};
+
+	typedef FloatAVX512 V;
+	typedef MaskAVX512 M;
+	typedef IntAVX512 I;
+
+	inline M mask(__mmask16 value) { M m; m.v = value; return m; }
+
+	inline V operator+(V a, V b) { return V(_mm512_add_ps(a.v, b.v)); }
+	inline V operator-(V a, V b) { return V(_mm512_sub_ps(a.v, b.v)); }
+	inline V operator*(V a, V b) { return V(_mm512_mul_ps(a.v, b.v)); }
+	inline V operator/(V a, V b) { return V(_mm512_div_ps(a.v, b.v)); }
+	inline V operator-(V a) { return V(_mm512_castsi512_ps(_mm512_xor_epi32(_mm512_castps_si512(a.v), _mm512_set1_epi32(int(0x80000000))))); }
+	inline M operator<(V a, V b) { return mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)); }
+	inline M operator<=(V a, V b) { return mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)); }
+	inline M operator>(V a, V b) { return mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)); }
+	inline M operator>=(V a, V b) { return mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)); }
+	inline V vmin(V a, V b) { return V(_mm512_min_ps(a.v, b.v)); }
+	inline V vmax(V a, V b) { return V(_mm512_max_ps(a.v, b.v)); }
+	inline V vabs(V a) { return V(_mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x7fffffff)))); }
+	inline V vsqrt(V a) { return V(_mm512_sqrt_ps(a.v)); }
+	inline V select(M m, V a, V b) { return V(_mm512_mask_blend_ps(m.v, b.v, a.v)); }
+	inline void store(float* p, V a) { _mm512_storeu_ps(p, a.v); }
+
+	inline M operator&(M a, M b) { return mask(__mmask16(a.v & b.v)); }
+	inline M operator|(M a, M b) { return mask(__mmask16(a.v | b.v)); }
+	inline M operator^(M a, M b) { return mask(__mmask16(a.v ^ b.v)); }
+	inline M andNot(M a, M b) { return mask(__mmask16(a.v & ~b.v)); }
+	inline bool any(M a) { return a.v != 0; }
+
+	inline I operator+(I a, I b) { return I(_mm512_add_epi32(a.v, b.v)); }
+	inline I operator-(I a, I b) { return I(_mm512_sub_epi32(a.v, b.v)); }
+	inline I operator&(I a, I b) { return I(_mm512_and_epi32(a.v, b.v)); }
+	inline I operator|(I a, I b) { return I(_mm512_or_epi32(a.v, b.v)); }
+	inline I shiftLeft23(I a) { return I(_mm512_slli_epi32(a.v, 23)); }
+	inline I shiftRight23(I a) { return I(_mm512_srli_epi32(a.v, 23)); }
+	inline M intEqual(I a, I b) { return mask(_mm512_cmpeq_epi32_mask(a.v, b.v)); }
+	inline I toIntRound(V a) { return I(_mm512_cvtps_epi32(a.v)); }
+	inline I toIntTrunc(V a) { return I(_mm512_cvttps_epi32(a.v)); }
+	inline V toFloat(I a) { return V(_mm512_cvtepi32_ps(a.v)); }
+	inline I asInt(V a) { return I(_mm512_castps_si512(a.v)); }
+	inline V asFloat(I a) { return V(_mm512_castsi512_ps(a.v)); }
+}
+
+#include "PacketKernel.h"
+
+void marchPacketAVX512(const MarchParams& params, const RayPacket& packet, PacketResult& result)
+{
+	packet::marchPacket<FloatAVX512>(params, packet, result);
+}
+
+#endif // PACKET_KERNELS_X86
@@ -0,0 +1,100 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	PacketKernelSSE.cpp
+ *
+ */
+
+#include "RayPacket.h"
+
+#ifdef PACKET_KERNELS_X86
+
+#include <emmintrin.h>
+
+namespace
+{
+	struct MaskSSE
+	{
+		__m128 v;
+	};
+
+	struct IntSSE
+	{
+		__m128i v;
+		IntSSE() {}
+		explicit IntSSE(__m128i value) : v(value) {}
+		explicit IntSSE(int value) : v(_mm_set1_epi32(value)) {}
+	};
+
+	// 4 lanes of SSE2, which is supported by every x86-64 CPU
+	struct FloatSSE
+	{
+		typedef MaskSSE Mask;
+		typedef IntSSE Int;
+		static const int width = 4;
+
+		__m128 v;
+		FloatSSE() {}
+		explicit FloatSSE(__m128 value) : v(value) {}
+		explicit FloatSSE(float value) : v(_mm_set1_ps(value)) {}
+
+		static FloatSSE load(const float* p) { return FloatSSE(_mm_loadu_ps(p)); }
+
+		static Mask laneMask(int count)
+		{
+			Mask m;
+			m.v = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(count)));
+			return m;
+		}
+	};
+
+	typedef FloatSSE V;
+	typedef MaskSSE M;
+	typedef IntSSE I;
+
+	inline V operator+(V a, V b) { return V(_mm_add_ps(a.v, b.v)); }
+	inline V operator-(V a, V b) { return V(_mm_sub_ps(a.v, b.v)); }
+	inline V operator*(V a, V b) { return V(_mm_mul_ps(a.v, b.v)); }
+	inline V operator/(V a, V b) { return V(_mm_div_ps(a.v, b.v)); }
+	inline V operator-(V a) { return V(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+	inline M operator<(V a, V b) { M m; m.v = _mm_cmplt_ps(a.v, b.v); return m; }
+	inline M operator<=(V a, V b) { M m; m.v = _mm_cmple_ps(a.v, b.v); return m; }
+	inline M operator>(V a, V b) { M m; m.v = _mm_cmpgt_ps(a.v, b.v); return m; }
+	inline M operator>=(V a, V b) { M m; m.v = _mm_cmpge_ps(a.v, b.v); return m; }
+	inline V vmin(V a, V b) { return V(_mm_min_ps(a.v, b.v)); }
+	inline V vmax(V a, V b) { return V(_mm_max_ps(a.v, b.v)); }
+	inline V vabs(V a) { return V(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+	inline V vsqrt(V a) { return V(_mm_sqrt_ps(a.v)); }
+	inline V select(M m, V a, V b) { return V(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))); }
+	inline void store(float* p, V a) { _mm_storeu_ps(p, a.v); }
+
+	inline M operator&(M a, M b) { M m; m.v = _mm_and_ps(a.v, b.v); return m; }
+	inline M operator|(M a, M b) { M m; m.v = _mm_or_ps(a.v, b.v); return m; }
+	inline M operator^(M a, M b) { M m; m.v = _mm_xor_ps(a.v, b.v); return m; }
+	inline M andNot(M a, M b) { M m; m.v = _mm_andnot_ps(b.v, a.v); return m; }
+	inline bool any(M a) { return _mm_movemask_ps(a.v) != 0; }
+
+	inline I operator+(I a, I b) { return I(_mm_add_epi32(a.v, b.v)); }
+	inline I operator-(I a, I b) { return I(_mm_sub_epi32(a.v, b.v)); }
+	inline I operator&(I a, I b) { return I(_mm_and_si128(a.v, b.v)); }
+	inline I operator|(I a, I b) { return I(_mm_or_si128(a.v, b.v)); }
+	inline I shiftLeft23(I a) { return I(_mm_slli_epi32(a.v, 23)); }
+	inline I shiftRight23(I a) { return I(_mm_srli_epi32(a.v, 23)); }
+	inline M intEqual(I a, I b) { M m; m.v = _mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v)); return m; }
+	inline I toIntRound(V a) { return I(_mm_cvtps_epi32(a.v)); }
+	inline I toIntTrunc(V a) { return I(_mm_cvttps_epi32(a.v)); }
+	inline V toFloat(I a) { return V(_mm_cvtepi32_ps(a.v)); }
+	inline I asInt(V a) { return I(_mm_castps_si128(a.v)); }
+	inline V asFloat(I a) { return V(_mm_castsi128_ps(a.v)); }
+}
+
+#include "PacketKernel.h"
+
+void marchPacketSSE(const MarchParams& params, const RayPacket& packet, PacketResult& result)
+{
+	packet::marchPacket<FloatSSE>(params, packet, result);
+}
+
+#endif // PACKET_KERNELS_X86
@@ -0,0 +1,157 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ParameterBuffer.cpp
+ *
+ */
+
+#include "ParameterBuffer.h"
+
+#include <cstring>
+
+ShaderParameters createShaderParameters(Camera& camera, const Fractal& fractal, const Rendering& rendering, const Coloring& coloring, glm::ivec2 resolution)
+{
+	ShaderParameters parameters = ShaderParameters();
+
+	parameters.viewMatrix = camera.getViewMatrix();
+	parameters.origin = camera.position;
+	parameters.originLow = glm::vec3(camera.precisePosition - glm::dvec3(camera.position));
+	parameters.vFov = camera.vFov;
+
+	parameters.light = rendering.lightPosition;
+	parameters.minDist = 1.0f / powf(10, rendering.detail);
+	parameters.detailPower = rendering.detailPower;
+	parameters.shadowSoftness = rendering.shadowSoftness;
+	parameters.maxSteps = rendering.maxSteps;
+	parameters.pixelScale = 1.0f;
+	parameters.renderSize = resolution;
+
+	parameters.previousView = glm::inverse(parameters.viewMatrix);
+	parameters.previousOrigin = camera.position;
+	parameters.historyLimit = 0.0f;
+
+	parameters.brickExtent = 0.0f;
+	parameters.brickResolution = 0;
+	parameters.brickSize = 0.0f;
+	parameters.brickNearDistance = 0.0f;
+	parameters.octreeExtent = 0.0f;
+	parameters.octreeResolution = 0;
+	parameters.octreeLevels = 0;
+	parameters.octreeLeafSize = 0.0f;
+	parameters.noiseThreshold = 0.0f;
+
+	parameters.power = fractal.power;
+	parameters.integerPower = getIntegerPower(fractal.power);
+	parameters.iterations = fractal.iterations;
+
+	parameters.bgColor = coloring.bgColor;
+	parameters.fractalColor = coloring.fractalColor;
+	parameters.oTrapColor = coloring.oTrapColor;
+	parameters.yTrapColor = coloring.yTrapColor;
+
+	return parameters;
+}
+
+glm::ivec2 getRenderSize(glm::ivec2 resolution, float pixelScale)
+{
+	glm::ivec2 renderSize = glm::ivec2(glm::ceil(glm::vec2(resolution) / pixelScale));
+	return glm::clamp(renderSize, glm::ivec2(1), resolution);
+}
+
+ParameterBuffer::ParameterBuffer()
+{
+	buffer = 0;
+	frameSize = 0;
+	frame = 0;
+	mapped = nullptr;
+
+	for (int i = 0; i < parameterBufferFrames; i++)
+		fences[i] = nullptr;
+}
+
+bool ParameterBuffer::create()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	frameSize = ((GLsizeiptr(sizeof(ShaderParameters)) + alignment - 1) / alignment) * alignment;
+	GLsizeiptr size = frameSize * parameterBufferFrames;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+	if (GLAD_GL_VERSION_4_4)
+	{
+		// mapping stays valid while GPU reads the buffer, writes are visible without flushing
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+		mapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+	}
+	else
+	{
+		glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	return buffer != 0 && (mapped != nullptr || !GLAD_GL_VERSION_4_4);
+}
+
+void ParameterBuffer::upload(const ShaderParameters& parameters)
+{
+	frame = (frame + 1) % parameterBufferFrames;
+	GLintptr offset = frame * frameSize;
+
+	// GPU may still read parameters written parameterBufferFrames uploads ago
+	if (fences[frame] != nullptr)
+	{
+		glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		glDeleteSync(fences[frame]);
+		fences[frame] = nullptr;
+	}
+
+	if (mapped != nullptr)
+	{
+		memcpy(mapped + offset, &parameters, sizeof(ShaderParameters));
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(ShaderParameters), &parameters);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, parameterBlockBinding, buffer, offset, sizeof(ShaderParameters));
+}
+
+void ParameterBuffer::frameSubmitted()
+{
+	if (fences[frame] != nullptr)
+		glDeleteSync(fences[frame]);
+
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void ParameterBuffer::destroy()
+{
+	for (int i = 0; i < parameterBufferFrames; i++)
+	{
+		if (fences[i] != nullptr)
+			glDeleteSync(fences[i]);
+		fences[i] = nullptr;
+	}
+
+	if (mapped != nullptr)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		mapped = nullptr;
+	}
+
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ParameterBuffer.h
+ *
+ */
+
+#pragma once
+
+#ifndef PARAMETER_BUFFER_H
+#define PARAMETER_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "Camera.h"
+#include "Raymarcher.h"
+
+// binding point of the Parameters uniform block in compute shader
+const GLuint parameterBlockBinding = 0;
+
+// number of frames whose parameters can be used by GPU at once
+const int parameterBufferFrames = 3;
+
+/**
+ * @brief All parameters of compute shader, layout matches std140 uniform block Parameters
+ * Every vec3 is followed by a scalar, so no padding is needed between members.
+ */
+typedef struct shaderParameters
+{
+	glm::mat4 viewMatrix;
+
+	glm::vec3 origin;
+	float vFov;
+
+	glm::vec3 light;
+	float minDist;
+
+	glm::vec3 bgColor;
+	float detailPower;
+
+	glm::vec3 fractalColor;
+	float shadowSoftness;
+
+	glm::vec3 oTrapColor;
+	float power;
+
+	glm::vec3 yTrapColor;
+	int integerPower;
+
+	glm::vec2 subframeOffset;
+	int subframeID;
+	int iterations;
+
+	int maxSteps;
+	float pixelScale;		// one ray is marched per pixelScale x pixelScale block of pixels
+	glm::ivec2 renderSize;	// number of marched rays, see getRenderSize
+
+	glm::mat4 previousView;	// world to camera space of the previous frame
+	glm::vec3 previousOrigin;
+	float historyLimit;		// largest number of samples reprojected from the previous frame, 0 disables reprojection
+
+	float brickExtent;		// half of the edge of the cube covered by brick map
+	int brickResolution;	// number of bricks along the edge of the cube, 0 if brick map is not used
+	float brickSize;		// edge of one brick
+	float brickNearDistance;	// cached distances below this are replaced by exact distance estimation
+
+	float octreeExtent;		// half of the edge of the cube covered by occupancy octree
+	int octreeResolution;	// number of leaves along the edge of the cube, 0 if octree is not used
+	int octreeLevels;		// number of levels including leaves
+	float octreeLeafSize;	// edge of one leaf
+
+	glm::vec3 originLow;	// rounding error of origin, origin + originLow is the camera position in double-float precision
+	float noiseThreshold;	// pixels whose mean luminance has larger standard error get more samples in adaptive sampling
+
+} ShaderParameters;
+
+static_assert(sizeof(ShaderParameters) == 320, "ShaderParameters does not match std140 layout");
+
+/**
+ * @brief Returns parameters of compute shader for given camera, fractal, rendering and coloring
+ * Subframe offset and ID are zero, every pixel is marched, previous frame is not reprojected, brick map and occupancy octree are not used,
+ * noise threshold is zero.
+ * @param resolution Resolution of the image
+ */
+ShaderParameters createShaderParameters(Camera& camera, const Fractal& fractal, const Rendering& rendering, const Coloring& coloring, glm::ivec2 resolution);
+
+/**
+ * @brief Returns number of rays marched in the image when one ray is marched per pixelScale x pixelScale pixels
+ * Rays are stored in the corner of the image, so render size is computed on CPU only and both shaders get the same value.
+ */
+glm::ivec2 getRenderSize(glm::ivec2 resolution, float pixelScale);
+
+/**
+ * @brief Uniform buffer with parameters of compute shader
+ * Buffer holds parameters of several frames, every upload writes the next part of the buffer,
+ * so CPU does not overwrite parameters that GPU still uses. Buffer is persistently mapped
+ * when OpenGL 4.4 is available, otherwise it is updated by glBufferSubData.
+ */
+class ParameterBuffer
+{
+public:
+	ParameterBuffer();
+
+	/**
+	 * @brief Creates buffer, it is bound to parameterBlockBinding by upload
+	 * @return TRUE if buffer was created, else FALSE
+	 */
+	bool create();
+
+	/**
+	 * @brief Writes parameters to the buffer and binds them to the uniform block
+	 */
+	void upload(const ShaderParameters& parameters);
+
+	/**
+	 * @brief Marks that commands using last uploaded parameters were issued
+	 */
+	void frameSubmitted();
+
+	void destroy();
+
+private:
+	GLuint buffer;
+
+	// size of parameters of one frame, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	GLsizeiptr frameSize;
+
+	// part of the buffer written by the last upload
+	int frame;
+
+	// persistently mapped memory of the buffer, nullptr if buffer is not mapped
+	uint8_t* mapped;
+
+	// signaled when GPU finishes commands using parameters of the frame
+	GLsync fences[parameterBufferFrames];
+};
+
+#endif // !PARAMETER_BUFFER_H
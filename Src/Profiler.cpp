@@ -0,0 +1,291 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Profiler.cpp
+ *
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+Profiler::Profiler()
+{
+	slot = 0;
+	frameNumber = 0;
+	created = false;
+	frameStart = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < profilerFrames; i++)
+	{
+		for (int j = 0; j < profilerPasses * 2; j++)
+			slots[i].queries[j] = 0;
+
+		for (int j = 0; j < profilerPasses; j++)
+		{
+			slots[i].issued[j] = false;
+			slots[i].cpuTime[j] = 0.0;
+			slots[i].cpuMeasured[j] = false;
+		}
+
+		slots[i].frameNumber = 0;
+		slots[i].used = false;
+	}
+
+	for (int i = 0; i < profilerPasses; i++)
+	{
+		cpuHistory[i].next = 0;
+		gpuHistory[i].next = 0;
+
+		lastGPUTime[i] = 0.0f;
+		lastGPUFrame[i] = 0;
+		lastGPUMeasured[i] = false;
+	}
+}
+
+void Profiler::create()
+{
+	for (int i = 0; i < profilerFrames; i++)
+		glGenQueries(profilerPasses * 2, slots[i].queries);
+
+	created = true;
+}
+
+void Profiler::beginFrame()
+{
+	auto now = std::chrono::steady_clock::now();
+
+	// whole frame of the current slot ends here, first call only starts measuring
+	if (slots[slot].used)
+		addCPU(passFrame, std::chrono::duration<double, std::milli>(now - frameStart).count());
+	frameStart = now;
+
+	slot = (slot + 1) % profilerFrames;
+	collectSlot(slots[slot]);
+
+	slots[slot].frameNumber = frameNumber++;
+	slots[slot].used = true;
+}
+
+void Profiler::beginGPU(ProfilerPass pass)
+{
+	if (created)
+		glQueryCounter(slots[slot].queries[pass * 2], GL_TIMESTAMP);
+}
+
+void Profiler::endGPU(ProfilerPass pass)
+{
+	if (!created)
+		return;
+
+	glQueryCounter(slots[slot].queries[pass * 2 + 1], GL_TIMESTAMP);
+	slots[slot].issued[pass] = true;
+}
+
+void Profiler::addCPU(ProfilerPass pass, double milliseconds)
+{
+	// pass can run several times in a frame
+	slots[slot].cpuTime[pass] += milliseconds;
+	slots[slot].cpuMeasured[pass] = true;
+}
+
+void Profiler::collectSlot(FrameSlot& frame)
+{
+	if (!frame.used)
+		return;
+
+	double gpuTime[profilerPasses];
+	bool gpuMeasured[profilerPasses];
+
+	for (int i = 0; i < profilerPasses; i++)
+	{
+		gpuMeasured[i] = false;
+
+		if (!frame.issued[i])
+			continue;
+
+		// end timestamp is the last one written, so begin is available too
+		GLint available = 0;
+		glGetQueryObjectiv(frame.queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available)
+		{
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+			gpuTime[i] = double(end - begin) / 1000000.0;
+			gpuMeasured[i] = true;
+			addSample(gpuHistory[i], float(gpuTime[i]));
+
+			lastGPUTime[i] = float(gpuTime[i]);
+			lastGPUFrame[i] = frame.frameNumber;
+			lastGPUMeasured[i] = true;
+		}
+
+		frame.issued[i] = false;
+	}
+
+	for (int i = 0; i < profilerPasses; i++)
+		if (frame.cpuMeasured[i])
+			addSample(cpuHistory[i], float(frame.cpuTime[i]));
+
+	if (csv.is_open())
+	{
+		csv << frame.frameNumber;
+
+		for (int i = 0; i < profilerPasses; i++)
+		{
+			// passes that did not run in the frame have empty values
+			csv << ",";
+			if (frame.cpuMeasured[i])
+				csv << frame.cpuTime[i];
+
+			csv << ",";
+			if (gpuMeasured[i])
+				csv << gpuTime[i];
+		}
+
+		csv << "\n";
+	}
+
+	for (int i = 0; i < profilerPasses; i++)
+	{
+		frame.cpuTime[i] = 0.0;
+		frame.cpuMeasured[i] = false;
+	}
+
+	frame.used = false;
+}
+
+void Profiler::addSample(SampleHistory& history, float sample)
+{
+	if (int(history.samples.size()) < profilerHistory)
+		history.samples.push_back(sample);
+	else
+		history.samples[history.next] = sample;
+
+	history.next = (history.next + 1) % profilerHistory;
+}
+
+PassStatistics computeStatistics(std::vector<float> samples)
+{
+	PassStatistics statistics;
+	statistics.min = statistics.avg = statistics.p95 = statistics.p99 = 0.0f;
+	statistics.count = int(samples.size());
+
+	if (statistics.count == 0)
+		return statistics;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (float sample : samples)
+		sum += sample;
+
+	// nearest rank percentiles
+	auto percentile = [&](double p) {
+		int rank = int(std::ceil(p * samples.size()));
+		return samples[std::max(rank, 1) - 1];
+	};
+
+	statistics.min = samples.front();
+	statistics.avg = float(sum / samples.size());
+	statistics.p95 = percentile(0.95);
+	statistics.p99 = percentile(0.99);
+
+	return statistics;
+}
+
+PassStatistics Profiler::getStatistics(ProfilerPass pass, bool gpu) const
+{
+	const SampleHistory& history = gpu ? gpuHistory[pass] : cpuHistory[pass];
+	return computeStatistics(history.samples);
+}
+
+bool Profiler::getLastGPUTime(ProfilerPass pass, float& milliseconds, uint64_t& frame) const
+{
+	milliseconds = lastGPUTime[pass];
+	frame = lastGPUFrame[pass];
+	return lastGPUMeasured[pass];
+}
+
+uint64_t Profiler::getFrameNumber() const
+{
+	return slots[slot].frameNumber;
+}
+
+bool Profiler::startCSV(const std::string& path)
+{
+	stopCSV();
+
+	csv.open(path, std::ios::trunc);
+	if (!csv.is_open())
+		return false;
+
+	csv << "frame";
+	for (int i = 0; i < profilerPasses; i++)
+	{
+		std::string name = getPassName(ProfilerPass(i));
+		csv << "," << name << "_cpu_ms," << name << "_gpu_ms";
+	}
+	csv << "\n";
+
+	return true;
+}
+
+void Profiler::stopCSV()
+{
+	if (csv.is_open())
+		csv.close();
+}
+
+bool Profiler::isWritingCSV() const
+{
+	return csv.is_open();
+}
+
+const char* Profiler::getPassName(ProfilerPass pass)
+{
+	switch (pass)
+	{
+	case passDispatch:
+		return "dispatch";
+	case passQuad:
+		return "quad";
+	case passGUI:
+		return "imgui";
+	case passFrame:
+		return "frame";
+	default:
+		return "unknown";
+	}
+}
+
+void Profiler::destroy()
+{
+	stopCSV();
+
+	if (!created)
+		return;
+
+	for (int i = 0; i < profilerFrames; i++)
+		glDeleteQueries(profilerPasses * 2, slots[i].queries);
+
+	created = false;
+}
+
+ScopedTimer::ScopedTimer(Profiler& profiler, ProfilerPass pass) : profiler(profiler), pass(pass)
+{
+	start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	auto end = std::chrono::steady_clock::now();
+	profiler.addCPU(pass, std::chrono::duration<double, std::milli>(end - start).count());
+}
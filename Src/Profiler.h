@@ -0,0 +1,191 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Profiler.h
+ *
+ */
+
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// measured parts of the frame, frame pass measures whole frame on CPU only
+enum ProfilerPass
+{
+	passDispatch,
+	passQuad,
+	passGUI,
+	passFrame,
+	profilerPasses
+};
+
+// number of frames whose timer queries can be in flight, results are read this many frames later
+const int profilerFrames = 4;
+
+// number of last samples statistics are computed from
+const int profilerHistory = 256;
+
+/**
+ * @brief Statistics of one pass in milliseconds
+ */
+typedef struct passStatistics
+{
+	float min;
+	float avg;
+	float p95;
+	float p99;
+	int count;
+} PassStatistics;
+
+/**
+ * @brief Computes min, average and nearest rank percentiles of the samples
+ */
+PassStatistics computeStatistics(std::vector<float> samples);
+
+/**
+ * @brief Measures CPU and GPU time of the passes of a frame
+ * GPU time is measured by timestamp queries. Queries of every frame have their own slot in a ring,
+ * a slot is read when it is used again, so reading results never waits for GPU.
+ * Samples whose results are still not available are dropped.
+ */
+class Profiler
+{
+public:
+	Profiler();
+
+	/**
+	 * @brief Creates timer queries
+	 */
+	void create();
+
+	/**
+	 * @brief Finishes measuring of the previous frame and starts the next one
+	 * Collects GPU results of the frame that used the slot profilerFrames frames ago.
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Records GPU timestamp of the beginning of the pass
+	 */
+	void beginGPU(ProfilerPass pass);
+
+	/**
+	 * @brief Records GPU timestamp of the end of the pass
+	 */
+	void endGPU(ProfilerPass pass);
+
+	/**
+	 * @brief Adds CPU time of the pass in the current frame
+	 */
+	void addCPU(ProfilerPass pass, double milliseconds);
+
+	/**
+	 * @brief Computes statistics from the last profilerHistory samples of the pass
+	 * @param gpu TRUE for GPU times, FALSE for CPU times
+	 */
+	PassStatistics getStatistics(ProfilerPass pass, bool gpu) const;
+
+	/**
+	 * @brief Returns GPU time of the pass from the last frame in which it was measured
+	 * @param frame Number of the frame the time belongs to, see getFrameNumber
+	 * @return TRUE if the pass was measured at least once, else FALSE
+	 */
+	bool getLastGPUTime(ProfilerPass pass, float& milliseconds, uint64_t& frame) const;
+
+	/**
+	 * @brief Returns number of the current frame, frames are numbered by beginFrame from 0
+	 */
+	uint64_t getFrameNumber() const;
+
+	/**
+	 * @brief Starts writing times of every finished frame to CSV file
+	 * @return TRUE if file was opened, else FALSE
+	 */
+	bool startCSV(const std::string& path);
+
+	void stopCSV();
+
+	bool isWritingCSV() const;
+
+	static const char* getPassName(ProfilerPass pass);
+
+	void destroy();
+
+private:
+	typedef struct frameSlot
+	{
+		// begin and end timestamp query of every pass
+		GLuint queries[profilerPasses * 2];
+		bool issued[profilerPasses];
+		double cpuTime[profilerPasses];
+		bool cpuMeasured[profilerPasses];
+		uint64_t frameNumber;
+		bool used;
+	} FrameSlot;
+
+	typedef struct sampleHistory
+	{
+		std::vector<float> samples;
+		// index of the next written sample
+		int next;
+	} SampleHistory;
+
+	FrameSlot slots[profilerFrames];
+
+	// slot of the current frame
+	int slot;
+
+	uint64_t frameNumber;
+
+	std::chrono::steady_clock::time_point frameStart;
+
+	SampleHistory cpuHistory[profilerPasses];
+	SampleHistory gpuHistory[profilerPasses];
+
+	// last collected GPU time of every pass and the frame it was measured in
+	float lastGPUTime[profilerPasses];
+	uint64_t lastGPUFrame[profilerPasses];
+	bool lastGPUMeasured[profilerPasses];
+
+	bool created;
+
+	std::ofstream csv;
+
+	/**
+	 * @brief Moves results of the slot to history and CSV file and clears the slot
+	 */
+	void collectSlot(FrameSlot& frame);
+
+	static void addSample(SampleHistory& history, float sample);
+};
+
+/**
+ * @brief Adds CPU time from its construction to its destruction to the pass
+ */
+class ScopedTimer
+{
+public:
+	ScopedTimer(Profiler& profiler, ProfilerPass pass);
+
+	~ScopedTimer();
+
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+	Profiler& profiler;
+	ProfilerPass pass;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif // !PROFILER_H
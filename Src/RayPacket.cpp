@@ -0,0 +1,101 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	RayPacket.cpp
+ *
+ */
+
+#include "RayPacket.h"
+
+#if defined(PACKET_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+SimdLevel detectSimdLevel()
+{
+#if defined(PACKET_KERNELS_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	if (!osxsave || !avx || maxLeaf < 7)
+		return simdSSE;
+
+	// OS has to save YMM (and ZMM) registers on context switch
+	unsigned long long xcr0 = _xgetbv(0);
+
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	bool avx512 = (info[1] & (1 << 16)) != 0;
+
+	if (avx512 && (xcr0 & 0xE6) == 0xE6)
+		return simdAVX512;
+	if (avx2 && (xcr0 & 0x6) == 0x6)
+		return simdAVX2;
+	return simdSSE;
+#elif defined(PACKET_KERNELS_X86)
+	// also checks whether OS supports the registers
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return simdAVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return simdAVX2;
+	return simdSSE;
+#else
+	return simdScalar;
+#endif
+}
+
+MarchPacketFunc getMarchPacketFunc(SimdLevel level)
+{
+	switch (level)
+	{
+#ifdef PACKET_KERNELS_X86
+	case simdSSE:
+		return marchPacketSSE;
+	case simdAVX2:
+		return marchPacketAVX2;
+	case simdAVX512:
+		return marchPacketAVX512;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+int getSimdWidth(SimdLevel level)
+{
+	switch (level)
+	{
+	case simdSSE:
+		return 4;
+	case simdAVX2:
+		return 8;
+	case simdAVX512:
+		return 16;
+	default:
+		return 1;
+	}
+}
+
+const char* simdLevelToString(SimdLevel level)
+{
+	switch (level)
+	{
+	case simdSSE:
+		return "SSE";
+	case simdAVX2:
+		return "AVX2";
+	case simdAVX512:
+		return "AVX-512";
+	default:
+		return "Scalar";
+	}
+}
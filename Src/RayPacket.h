@@ -0,0 +1,96 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	RayPacket.h
+ *
+ */
+
+#pragma once
+
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+// This header is included by packet kernels which are compiled with different instruction sets,
+// so it must not include any library with inline functions (glm, std algorithms...).
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PACKET_KERNELS_X86
+#endif
+
+// maximal number of rays marched at once (AVX-512)
+const int maxPacketWidth = 16;
+
+// number of rays in a packet built by the raymarcher, kernels march it in chunks of their width
+const int rayPacketSize = maxPacketWidth;
+
+enum SimdLevel { simdScalar, simdSSE, simdAVX2, simdAVX512 };
+
+enum MarchStatus { marchMissed, marchHit, marchExhausted };
+
+/**
+ * @brief Rays with common origin in SoA layout
+ */
+typedef struct rayPacket
+{
+	float origin[3];
+	float dirX[rayPacketSize];
+	float dirY[rayPacketSize];
+	float dirZ[rayPacketSize];
+	int count;		// number of valid rays, remaining lanes are masked
+} RayPacket;
+
+/**
+ * @brief Result of marching of every ray in a packet
+ */
+typedef struct packetResult
+{
+	float sampleDist[rayPacketSize];	// distance along the ray of the last sample
+	float lastDist[rayPacketSize];		// distance estimation in the last sample
+	float epsilon[rayPacketSize];		// minimal distance in the last sample
+	int steps[rayPacketSize];
+	int status[rayPacketSize];			// MarchStatus
+} PacketResult;
+
+/**
+ * @brief Parameters of the fractal and marching shared by all rays
+ */
+typedef struct marchParams
+{
+	float power;
+	int integerPower;	// 0 if power is fractional
+	int iterations;
+	float minDist;
+	float detailPower;
+	int maxSteps;
+	float farPlane;
+	float startDist;	// distance at which marching starts (bounding sphere)
+} MarchParams;
+
+typedef void (*MarchPacketFunc)(const MarchParams& params, const RayPacket& packet, PacketResult& result);
+
+/**
+ * @brief Returns best instruction set supported by CPU and OS
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Returns packet kernel for given instruction set or nullptr for simdScalar
+ */
+MarchPacketFunc getMarchPacketFunc(SimdLevel level);
+
+/**
+ * @brief Returns number of rays marched at once by a given instruction set
+ */
+int getSimdWidth(SimdLevel level);
+
+const char* simdLevelToString(SimdLevel level);
+
+#ifdef PACKET_KERNELS_X86
+void marchPacketSSE(const MarchParams& params, const RayPacket& packet, PacketResult& result);
+void marchPacketAVX2(const MarchParams& params, const RayPacket& packet, PacketResult& result);
+void marchPacketAVX512(const MarchParams& params, const RayPacket& packet, PacketResult& result);
+#endif
+
+#endif // !RAY_PACKET_H
@@ -8,31 +8,165 @@
  */
 
 #include "Raymarcher.h"
+#include "BrickMap.h"
+#include "OccupancyOctree.h"
 
+#include <cstdint>
 
-Raymarcher::Raymarcher(glm::vec2 screenSize, Camera* camera, Fractal* fractalInfo, Rendering* renderingInfo)
+/**
+ * @brief Computes integer power of a complex number by binary exponentiation
+ * Loop is unrolled by compiler, because N is known at compile time.
+ */
+template<int N>
+static inline glm::vec2 complexPow(glm::vec2 c)
 {
-    this->screenSize = screenSize;
-    this->camera = camera;
-    this->fractal = fractalInfo;
-    this->rendering = renderingInfo;
+	glm::vec2 result = glm::vec2(1.0f, 0.0f);
+
+	for (int n = N; n > 0; n >>= 1)
+	{
+		if (n & 1)
+			result = glm::vec2(result.x * c.x - result.y * c.y, result.x * c.y + result.y * c.x);
+		c = glm::vec2(c.x * c.x - c.y * c.y, 2.0f * c.x * c.y);
+	}
+
+	return result;
 }
 
-glm::vec3 Raymarcher::rayDirection(glm::vec2 pixelCoord) {
-    glm::vec2 xy = pixelCoord - screenSize / 2.0f;
-    float z = screenSize.y / camera->vFov;
-    return glm::normalize(glm::vec3(xy, -z));
+/**
+ * @brief Computes integer power of a complex number, power is known only at run time
+ */
+static inline glm::vec2 complexPow(glm::vec2 c, int n)
+{
+	glm::vec2 result = glm::vec2(1.0f, 0.0f);
+
+	for (; n > 0; n >>= 1)
+	{
+		if (n & 1)
+			result = glm::vec2(result.x * c.x - result.y * c.y, result.x * c.y + result.y * c.x);
+		c = glm::vec2(c.x * c.x - c.y * c.y, 2.0f * c.x * c.y);
+	}
+
+	return result;
 }
 
-float Raymarcher::sphereSDF(glm::vec3 sphereCenter, float sphereRadius, glm::vec3 point)
+static inline glm::dvec2 complexPow(glm::dvec2 c, int n)
 {
-    return glm::length(point - sphereCenter) - sphereRadius;
+	glm::dvec2 result = glm::dvec2(1.0, 0.0);
+
+	for (; n > 0; n >>= 1)
+	{
+		if (n & 1)
+			result = glm::dvec2(result.x * c.x - result.y * c.y, result.x * c.y + result.y * c.x);
+		c = glm::dvec2(c.x * c.x - c.y * c.y, 2.0 * c.x * c.y);
+	}
+
+	return result;
+}
+
+template<int N>
+static inline float realPow(float x)
+{
+	float result = 1.0f;
+
+	for (int n = N; n > 0; n >>= 1)
+	{
+		if (n & 1)
+			result *= x;
+		x *= x;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Mandelbulb of integer power N in triplex algebra, without trigonometric functions
+ * w = r(sin(theta)sin(phi), cos(theta), sin(theta)cos(phi)), where rho = r*sin(theta):
+ * (y + i*rho)^N = r^N(cos(N*theta) + i*sin(N*theta)) and ((z + i*x)/rho)^N = cos(N*phi) + i*sin(N*phi)
+ */
+template<int N>
+static float mandelbulbTriplexSDF(glm::vec3 p, int iterations)
+{
+	glm::vec3 w = p;
+	float m = glm::dot(w, w);
+
+	float dz = 1.0;
+	for (int i = 0; i < iterations; i++)
+	{
+		dz = float(N) * realPow<N - 1>(sqrt(m)) * dz + 1.0f;
+
+		float rho = sqrt(w.x * w.x + w.z * w.z);
+		glm::vec2 theta = complexPow<N>(glm::vec2(w.y, rho));
+		glm::vec2 phi = (rho > 0.0f) ? complexPow<N>(glm::vec2(w.z, w.x) / rho) : glm::vec2(1.0f, 0.0f);
+
+		w = p + glm::vec3(theta.y * phi.y, theta.x, theta.y * phi.x);
+
+		m = dot(w, w);
+		if (m > 256.0)
+			break;
+	}
+
+	return 0.25f * log(m) * sqrt(m) / dz;
+}
+
+typedef float (*TriplexFunc)(glm::vec3 p, int iterations);
+
+// specialized kernels indexed by power
+static const TriplexFunc triplexKernels[triplexPowerMax + 1] =
+{
+	nullptr, nullptr,
+	mandelbulbTriplexSDF<2>, mandelbulbTriplexSDF<3>, mandelbulbTriplexSDF<4>, mandelbulbTriplexSDF<5>,
+	mandelbulbTriplexSDF<6>, mandelbulbTriplexSDF<7>, mandelbulbTriplexSDF<8>, mandelbulbTriplexSDF<9>,
+	mandelbulbTriplexSDF<10>, mandelbulbTriplexSDF<11>, mandelbulbTriplexSDF<12>, mandelbulbTriplexSDF<13>,
+	mandelbulbTriplexSDF<14>, mandelbulbTriplexSDF<15>, mandelbulbTriplexSDF<16>
+};
+
+Fractal defaultFractal()
+{
+	Fractal fractal;
+	fractal.power = 8.0;
+	fractal.iterations = 6;
+	return fractal;
+}
+
+Rendering defaultRendering()
+{
+	Rendering rendering;
+	rendering.maxSteps = 80;
+	rendering.detail = 4;
+	rendering.detailPower = 1.5;
+	rendering.shadows = false;
+	rendering.shadowSoftness = 16.0;
+	rendering.ambientOcclusion = true;
+	rendering.antialiasing = 1;
+	rendering.lightPosition = glm::normalize(glm::vec3(0.0, 1.4, 1.7));
+	return rendering;
 }
 
-float Raymarcher::mandelbulbSDF(glm::vec3 p)
+Coloring defaultColoring()
 {
-	int Iterations = fractal->iterations;
-	float Power = fractal->power;
+	Coloring coloring;
+	coloring.bgColor = glm::vec3(0.53f, 0.8f, 0.8f);
+	coloring.fractalColor = glm::vec3(0.334f, 0.42f, 0.184f);
+	coloring.oTrapColor = glm::vec3(0.741f, 0.718f, 0.42f);
+	coloring.yTrapColor = glm::vec3(0.58f, 0.313f, 0.0f);
+	return coloring;
+}
+
+int getIntegerPower(float power)
+{
+	if (power != std::floor(power) || power < triplexPowerMin || power > triplexPowerMax)
+		return 0;
+
+	return int(power);
+}
+
+float mandelbulbDistance(const Fractal& fractal, int integerPower, glm::vec3 p)
+{
+	if (integerPower != 0)
+		return triplexKernels[integerPower](p, fractal.iterations);
+
+	int Iterations = fractal.iterations;
+	float Power = fractal.power;
 
 	glm::vec3 w = p;
 	float m = glm::dot(w, w);
@@ -55,13 +189,175 @@ float Raymarcher::mandelbulbSDF(glm::vec3 p)
 	return 0.25f * log(m) * sqrt(m) / dz;
 }
 
-float Raymarcher::sceneSDF(glm::vec3 point)
+double mandelbulbDistance(const Fractal& fractal, int integerPower, glm::dvec3 p)
+{
+	double Power = double(fractal.power);
+
+	glm::dvec3 w = p;
+	double m = glm::dot(w, w);
+
+	double dz = 1.0;
+	for (int i = 0; i < fractal.iterations; i++)
+	{
+		dz = Power * pow(sqrt(m), Power - 1.0) * dz + 1.0;
+
+		if (integerPower != 0)
+		{
+			double rho = sqrt(w.x * w.x + w.z * w.z);
+			glm::dvec2 theta = complexPow(glm::dvec2(w.y, rho), integerPower);
+			glm::dvec2 phi = (rho > 0.0) ? complexPow(glm::dvec2(w.z, w.x) / rho, integerPower) : glm::dvec2(1.0, 0.0);
+
+			w = p + glm::dvec3(theta.y * phi.y, theta.x, theta.y * phi.x);
+		}
+		else
+		{
+			double r = glm::length(w);
+			double b = Power * acos(w.y / r);
+			double a = Power * atan2(w.x, w.z);
+			w = p + pow(r, Power) * glm::dvec3(sin(b) * sin(a), cos(b), sin(b) * cos(a));
+		}
+
+		m = glm::dot(w, w);
+		if (m > 256.0)
+			break;
+	}
+
+	return 0.25 * log(m) * sqrt(m) / dz;
+}
+
+/**
+ * @brief Computes orbit trap of a point, iterates the fractal the same way as mandelbulbDistance
+ * Vector types select precision, deep zoom iterates in double.
+ * @return Square of the last orbit radius, minimal distances to planes x = 0 and y = 0 and minimal square radius
+ */
+template<typename Vec3, typename Vec2>
+static glm::vec4 mandelbulbOrbitTrap(const Fractal& fractal, int integerPower, Vec3 p)
+{
+	float Power = fractal.power;
+
+	Vec3 w = p;
+	auto m = glm::dot(w, w);
+
+	glm::vec4 trap = glm::vec4(glm::vec3(glm::abs(w)), float(m));
+
+	for (int i = 0; i < fractal.iterations; i++)
+	{
+		if (integerPower != 0)
+		{
+			auto rho = sqrt(w.x * w.x + w.z * w.z);
+			Vec2 theta = complexPow(Vec2(w.y, rho), integerPower);
+			Vec2 phi = (rho > 0.0f) ? complexPow(Vec2(w.z, w.x) / rho, integerPower) : Vec2(1.0f, 0.0f);
+
+			w = p + Vec3(theta.y * phi.y, theta.x, theta.y * phi.x);
+		}
+		else
+		{
+			auto r = glm::length(w);
+			auto b = Power * acos(w.y / r);
+			auto a = Power * atan2(w.x, w.z);
+			w = p + pow(r, Power) * Vec3(sin(b) * sin(a), cos(b), sin(b) * cos(a));
+		}
+
+		trap = glm::min(trap, glm::vec4(glm::vec3(glm::abs(w)), float(m)));
+
+		m = dot(w, w);
+		if (m > 256.0)
+			break;
+	}
+
+	return glm::vec4(float(m), trap.y, trap.z, trap.w);
+}
+
+float pixelNoise(glm::ivec2 pixel, int subframe)
+{
+	uint32_t h = (uint32_t(pixel.x) * 73856093u) ^ (uint32_t(pixel.y) * 19349663u) ^ (uint32_t(subframe) * 83492791u);
+
+	// lowbias32 finalizer
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+
+	// 24 bits are exactly representable in float
+	return float(h >> 8) / 16777216.0f;
+}
+
+Raymarcher::Raymarcher(glm::vec2 screenSize, Camera* camera, Fractal* fractalInfo, Rendering* renderingInfo, Coloring* coloringInfo)
+{
+    this->screenSize = screenSize;
+    this->camera = camera;
+    this->fractal = fractalInfo;
+    this->rendering = renderingInfo;
+    this->coloring = coloringInfo;
+    this->viewMatrix = camera->getViewMatrix();
+    this->integerPower = getIntegerPower(fractalInfo->power);
+    this->brickMap = nullptr;
+    this->occupancy = nullptr;
+    this->deepZoom = false;
+
+    // instruction set is detected only once
+    static const SimdLevel detectedLevel = detectSimdLevel();
+    setSimdLevel(detectedLevel);
+}
+
+glm::vec3 Raymarcher::rayDirection(glm::vec2 pixelCoord) const {
+    glm::vec2 xy = pixelCoord - screenSize / 2.0f;
+    float z = screenSize.y / camera->vFov;
+    return glm::normalize(glm::vec3(xy, -z));
+}
+
+glm::vec3 Raymarcher::rayOrigin() const
+{
+	return deepZoom ? glm::vec3(0.0f) : camera->position;
+}
+
+glm::vec2 Raymarcher::subframeOffset(int subframe) const
+{
+	int AA = rendering->antialiasing;
+	return glm::vec2(float(subframe / AA), float(subframe % AA)) / float(AA);
+}
+
+float Raymarcher::sphereSDF(glm::vec3 sphereCenter, float sphereRadius, glm::vec3 point) const
+{
+    return glm::length(point - sphereCenter) - sphereRadius;
+}
+
+float Raymarcher::mandelbulbSDF(glm::vec3 p) const
+{
+	if (deepZoom)
+		return float(mandelbulbDistance(*fractal, integerPower, camera->precisePosition + glm::dvec3(p)));
+
+	return mandelbulbDistance(*fractal, integerPower, p);
+}
+
+glm::vec4 Raymarcher::orbitTrap(glm::vec3 p) const
+{
+	if (deepZoom)
+		return mandelbulbOrbitTrap<glm::dvec3, glm::dvec2>(*fractal, integerPower, camera->precisePosition + glm::dvec3(p));
+
+	return mandelbulbOrbitTrap<glm::vec3, glm::vec2>(*fractal, integerPower, p);
+}
+
+float Raymarcher::marchingSDF(glm::vec3 point, float exactBelow) const
+{
+	if (brickMap != nullptr && !deepZoom)
+	{
+		float dist = brickMap->distance(point);
+		if (dist >= glm::max(exactBelow, brickMap->getNearDistance()))
+			return dist;
+	}
+
+	return sceneSDF(point);
+}
+
+float Raymarcher::sceneSDF(glm::vec3 point) const
 {
     //return sphereSDF(glm::vec3(0.0f), 1.0f, point);
 	return mandelbulbSDF(point);
 }
 
-glm::vec3 Raymarcher::estimateNormal(glm::vec3 p, float dist, float epsilon) {
+glm::vec3 Raymarcher::estimateNormal(glm::vec3 p, float dist, float epsilon) const {
     glm::vec3 n;
     n.x = sceneSDF(p + glm::vec3(epsilon, 0.0, 0.0)) - dist;
     n.z = sceneSDF(p + glm::vec3(0.0, 0.0, epsilon)) - dist;
@@ -69,36 +365,47 @@ glm::vec3 Raymarcher::estimateNormal(glm::vec3 p, float dist, float epsilon) {
     return normalize(n);
 }
 
-glm::vec3 Raymarcher::trace(Ray r)
+MarchResult Raymarcher::march(Ray r) const
 {
-	const glm::vec3 BgColor = glm::vec3(0.53, 0.8, 0.8);
 	float MinDist = 1.0f / powf(10, rendering->detail);
 	float DetailPower = rendering->detailPower;
 	int MaxMarchingSteps = rendering->maxSteps;
 
-	// background color
-	glm::vec3 color = BgColor;
+	MarchResult result;
+	result.sampleDist = 0.0f;
+	result.lastDist = 0.0f;
+	result.epsilon = MinDist;
+	result.status = marchExhausted;
 
-	float totalDist = NEAR_PLANE;
+	// bounding sphere is in world coordinates, rays of deep zoom start in the origin
+	float totalDist = startDistance(deepZoom ? camera->position : r.origin);
 	int steps = 0;
 
 	float epsilon = MinDist;
 	float epsilonModified = MinDist;		// SDF minimal distance based on zoom level
 
-	// bounding sphere
-	float boundingSphere = sphereSDF(glm::vec3(0.0, 0.0, 0.0), 1.2f, r.origin);
-
-	if (boundingSphere > 0.0)
-	{
-		totalDist += boundingSphere;
-	}
-
-	glm::vec3 col;
+	// cached distance is not accurate enough to end marching, hits are always found by exact distance
+	float hitDistanceMax = glm::clamp(epsilon * pow(FAR_PLANE, DetailPower), MinDist, FAR_PLANE);
 
 	for (steps = 0; steps < MaxMarchingSteps; steps++)
 	{
 		glm::vec3 samplePoint = r.origin + totalDist * r.dir;
-		float dist = sceneSDF(samplePoint);
+		result.sampleDist = totalDist;
+
+		// empty node of the octree is crossed in one step without distance estimation
+		float span = (occupancy != nullptr && !deepZoom) ? occupancy->emptySpan(samplePoint, r.dir) : 0.0f;
+		if (span > 0.0f)
+		{
+			totalDist += span;
+			if (totalDist >= FAR_PLANE)
+			{
+				result.status = marchMissed;
+				break;
+			}
+			continue;
+		}
+
+		float dist = marchingSDF(samplePoint, hitDistanceMax);
 
 		// Move along the view ray
 		totalDist += dist;
@@ -108,46 +415,192 @@ glm::vec3 Raymarcher::trace(Ray r)
 		if (dist < epsilonModified)
 		{
 			// Ray is inside the scene surface
-			totalDist -= (epsilonModified - dist);
-
-			col = glm::vec3(0.334, 0.42, 0.184);
-			col *= 0.5;
-
-			color = shade(samplePoint, r.dir, col, dist, epsilonModified);
-
-			// ambient occlusion based on number of marching steps
-			//color *= glm::vec3(1-float(steps)/float(MaxMarchingSteps));
-
+			result.lastDist = dist;
+			result.epsilon = epsilonModified;
+			result.status = marchHit;
 			break;
 		}
 
 		if (totalDist >= FAR_PLANE) {
 			// Ray reached far plane
+			result.status = marchMissed;
 			break;
 		}
 	}
 
-	if (steps == MaxMarchingSteps) color = glm::vec3(0.0);
+	result.steps = steps;
 
-	return color;
+	return result;
 }
 
-glm::vec3 Raymarcher::getColor(glm::vec2 pixelCoords)
+float Raymarcher::startDistance(glm::vec3 origin) const
 {
-	glm::vec3 direction = rayDirection(pixelCoords);
-	glm::vec4 dir = camera->getViewMatrix() * glm::vec4(direction, 0.0);
-	Ray r = { camera->position, glm::vec3(dir.x, dir.y, dir.z) };
+	// bounding sphere
+	float boundingSphere = sphereSDF(glm::vec3(0.0, 0.0, 0.0), 1.2f, origin);
 
-	glm::vec3 color = trace(r);
+	return NEAR_PLANE + glm::max(boundingSphere, 0.0f);
+}
 
-	color = sqrt(color);
-	return color;
+glm::vec3 Raymarcher::trace(Ray r, float noise) const
+{
+	return traceColor(r, march(r), noise);
 }
 
-glm::vec3 Raymarcher::shade(glm::vec3 point, glm::vec3 viewDirection, glm::vec3 color, float dist, float epsilon)
+glm::vec3 Raymarcher::traceColor(Ray r, const MarchResult& result, float noise) const
+{
+	if (result.status == marchMissed)
+		return coloring->bgColor;
+
+	if (result.status == marchExhausted)
+		return glm::vec3(0.0);
+
+	float MinDist = 1.0f / powf(10, rendering->detail);
+
+	glm::vec4 trap = orbitTrap(r.origin + result.sampleDist * r.dir);
+
+	glm::vec3 col = coloring->fractalColor;
+	col = glm::mix(col, coloring->yTrapColor, glm::clamp(trap.y, 0.0f, 1.0f));
+	col = glm::mix(col, coloring->oTrapColor, glm::clamp(pow(trap.w, 8.0f), 0.0f, 1.0f));
+	col *= 0.5f;
+
+	// ray is moved back by the part of the last step that got under the surface, as in the compute shader
+	float intersectionDist = result.sampleDist + 2.0f * result.lastDist - result.epsilon;
+	if (intersectionDist <= 0.0f)
+		return col;
+
+	glm::vec3 samplePoint = r.origin + (intersectionDist - result.lastDist) * r.dir;
+	float epsilon = glm::clamp(MinDist * pow(intersectionDist, rendering->detailPower), MinDist, FAR_PLANE);
+
+	glm::vec3 color = shade(samplePoint, r.dir, col, result.lastDist, epsilon, noise);
+
+	// ambient occlusion based on number of marching steps
+	return color * (1.0f - float(result.steps) / float(rendering->maxSteps));
+}
+
+glm::vec3 Raymarcher::getColor(glm::vec2 pixelCoords) const
+{
+	int samples = rendering->antialiasing * rendering->antialiasing;
+	glm::vec3 color = glm::vec3(0.0f);
+
+	for (int sample = 0; sample < samples; sample++)
+	{
+		glm::vec3 direction = rayDirection(pixelCoords + subframeOffset(sample));
+		glm::vec4 dir = viewMatrix * glm::vec4(direction, 0.0);
+		Ray r = { rayOrigin(), glm::vec3(dir.x, dir.y, dir.z) };
+
+		// samples are averaged after gamma correction, as in the accumulation buffer of the compute shader
+		color += sqrt(trace(r, pixelNoise(glm::ivec2(pixelCoords), sample)));
+	}
+
+	return color / float(samples);
+}
+
+void Raymarcher::getColors(glm::ivec2 firstPixel, int count, glm::vec4* colors) const
+{
+	if (marchPacketFunc == nullptr || deepZoom)
+	{
+		for (int i = 0; i < count; i++)
+			colors[i] = glm::vec4(getColor(glm::vec2(firstPixel.x + i, firstPixel.y)), 1.0f);
+		return;
+	}
+
+	MarchParams params;
+	params.power = fractal->power;
+	params.integerPower = integerPower;
+	params.iterations = fractal->iterations;
+	params.minDist = 1.0f / powf(10, rendering->detail);
+	params.detailPower = rendering->detailPower;
+	params.maxSteps = rendering->maxSteps;
+	params.farPlane = FAR_PLANE;
+	params.startDist = startDistance(camera->position);
+
+	RayPacket packet;
+	PacketResult result;
+	Ray rays[rayPacketSize];
+
+	packet.origin[0] = camera->position.x;
+	packet.origin[1] = camera->position.y;
+	packet.origin[2] = camera->position.z;
+
+	int samples = rendering->antialiasing * rendering->antialiasing;
+
+	for (int i = 0; i < count; i++)
+		colors[i] = glm::vec4(0.0f);
+
+	// every sample of the row is marched in packets, so neighbouring lanes stay coherent
+	for (int sample = 0; sample < samples; sample++)
+	{
+		glm::vec2 offset = subframeOffset(sample);
+
+		for (int first = 0; first < count; first += rayPacketSize)
+		{
+			packet.count = glm::min(rayPacketSize, count - first);
+
+			// unused lanes get valid rays too, their results are masked
+			for (int i = 0; i < rayPacketSize; i++)
+			{
+				int x = firstPixel.x + first + glm::min(i, packet.count - 1);
+				glm::vec4 dir = viewMatrix * glm::vec4(rayDirection(glm::vec2(x, firstPixel.y) + offset), 0.0);
+
+				rays[i].origin = camera->position;
+				rays[i].dir = glm::vec3(dir.x, dir.y, dir.z);
+				packet.dirX[i] = dir.x;
+				packet.dirY[i] = dir.y;
+				packet.dirZ[i] = dir.z;
+			}
+
+			marchPacketFunc(params, packet, result);
+
+			// shading is done per pixel, it is run only for rays which hit the fractal
+			for (int i = 0; i < packet.count; i++)
+			{
+				MarchResult march;
+				march.sampleDist = result.sampleDist[i];
+				march.lastDist = result.lastDist[i];
+				march.epsilon = result.epsilon[i];
+				march.steps = result.steps[i];
+				march.status = MarchStatus(result.status[i]);
+
+				float noise = pixelNoise(glm::ivec2(firstPixel.x + first + i, firstPixel.y), sample);
+				colors[first + i] += glm::vec4(sqrt(traceColor(rays[i], march, noise)), 0.0f);
+			}
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		colors[i] = glm::vec4(glm::vec3(colors[i]) / float(samples), 1.0f);
+}
+
+void Raymarcher::setSimdLevel(SimdLevel level)
+{
+	simdLevel = level;
+	marchPacketFunc = getMarchPacketFunc(level);
+}
+
+SimdLevel Raymarcher::getSimdLevel() const
+{
+	return simdLevel;
+}
+
+void Raymarcher::setBrickMap(const BrickMap* brickMap)
+{
+	this->brickMap = brickMap;
+}
+
+void Raymarcher::setOccupancyOctree(const OccupancyOctree* octree)
+{
+	occupancy = octree;
+}
+
+void Raymarcher::setDeepZoom(bool enabled)
+{
+	deepZoom = enabled;
+}
+
+glm::vec3 Raymarcher::shade(glm::vec3 point, glm::vec3 viewDirection, glm::vec3 color, float dist, float epsilon, float noise) const
 {
 	const glm::vec3 ambientLight = glm::vec3(0.1f);
-	const glm::vec3 light = glm::normalize(glm::vec3(0.0f, 1.4f, 1.7f));
+	const glm::vec3 light = rendering->lightPosition;
 	const glm::vec3 lightIntensity = glm::vec3(1.0f);
 
 	// normal vector of a given surface point
@@ -170,7 +623,64 @@ glm::vec3 Raymarcher::shade(glm::vec3 point, glm::vec3 viewDirection, glm::vec3
 	glm::vec3 result;
 	glm::vec3 ambientColor = color * ambientLight;
 
-	result = ambientColor + lightIntensity * (diffuse + Ks * specular);
+	if (rendering->shadows)
+		result = ambientColor + softShadow(point, epsilon) * (lightIntensity * (diffuse + Ks * specular));
+	else
+		result = ambientColor + lightIntensity * (diffuse + Ks * specular);
+
+	if (rendering->ambientOcclusion)
+		result *= ambientOcclusion(point, N, epsilon, noise);
 
 	return glm::clamp(result, 0.0f, 1.0f);
+}
+
+float Raymarcher::softShadow(glm::vec3 point, float epsilon) const
+{
+	Ray r;
+	r.dir = rendering->lightPosition;
+	r.origin = point + r.dir * 0.1f;
+
+	float res = 1.0f;
+	float depth = NEAR_PLANE;
+
+	int maxIterations = rendering->maxSteps / 2;
+
+	for (int i = 0; i < maxIterations; i++)
+	{
+		glm::vec3 samplePoint = r.origin + depth * r.dir;
+		float dist = marchingSDF(samplePoint, epsilon);
+		if (dist < epsilon)
+		{
+			// Point is in full shadow
+			return 0.0f;
+		}
+		res = glm::min(res, rendering->shadowSoftness * dist / depth);
+
+		// Move along the shadow ray
+		depth += dist;
+
+		if (depth >= FAR_PLANE) {
+			// Ray reached far plane
+			break;
+		}
+	}
+	return res;
+}
+
+// Credit to https://github.com/3Dickulus/Fragmentarium_Examples_Folder/blob/b6da79fc9ac346d0a7197b16f323e4759f3c68a6/Include/DE-Raytracer.frag
+float Raymarcher::ambientOcclusion(glm::vec3 p, glm::vec3 n, float epsilon, float noise) const
+{
+	float ao = 0.0f;
+	float wSum = 0.0f;
+	float de = sceneSDF(p);
+	float w = 1.0f;
+	float d = 1.0f - noise;
+	for (float i = 1.0f; i < 6.0f; i++)
+	{
+		float D = (sceneSDF(p + d * n * i * i * epsilon) - de) / (d * i * i * epsilon);
+		w *= 0.6f;
+		ao += w * glm::clamp(1.0f - D, 0.0f, 1.0f);
+		wSum += w;
+	}
+	return glm::clamp(ao / wSum, 0.0f, 1.0f);
 }
\ No newline at end of file
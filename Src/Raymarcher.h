@@ -13,6 +13,7 @@
 #define RAYMARCHER_H
 
 #include "Camera.h"
+#include "RayPacket.h"
 
 typedef struct fractal
 {
@@ -27,55 +28,241 @@ typedef struct rendering
 	float detailPower;
 	bool shadows;
 	float shadowSoftness;
+	bool ambientOcclusion;
 	int antialiasing;
 	glm::vec3 lightPosition;
 } Rendering;
 
+typedef struct coloring
+{
+	glm::vec3 bgColor;
+	glm::vec3 fractalColor;
+	glm::vec3 oTrapColor;		// color of points whose orbit comes close to the origin
+	glm::vec3 yTrapColor;		// color of points whose orbit comes close to the plane y = 0
+} Coloring;
+
+/**
+ * @brief Returns initial parameters of the fractal
+ */
+Fractal defaultFractal();
+
+/**
+ * @brief Returns initial parameters of rendering
+ */
+Rendering defaultRendering();
+
+/**
+ * @brief Returns initial colors of the fractal and background
+ */
+Coloring defaultColoring();
+
+// ranges of fractal and rendering parameters offered in GUI
+const float renderingDetailMin = 2.0f;
+const float renderingDetailMax = 6.0f;
+const float deepZoomDetailMax = 12.0f;		// double-float resolves detail far below float precision
+const float detailPowerMin = 1.0f;
+const float detailPowerMax = 4.0f;
+const int maxStepsMin = 1;
+const int maxStepsMax = 1024;
+const float shadowSoftnessMin = 1.0f;
+const float shadowSoftnessMax = 256.0f;
+const float fractalPowerMin = 1.0f;
+const float fractalPowerMax = 16.0f;
+const int fractalIterationsMin = 1;
+const int fractalIterationsMax = 32;
+const int antialiasingValues[] = { 1, 2, 4, 8, 16 };
+
 typedef struct ray
 {
 	glm::vec3 origin;
 	glm::vec3 dir;
 } Ray;
 
+typedef struct marchResult
+{
+	float sampleDist;	// distance along the ray of the last sample
+	float lastDist;		// distance estimation in the last sample
+	float epsilon;		// minimal distance in the last sample
+	int steps;
+	MarchStatus status;
+} MarchResult;
+
+// integer powers with specialized triplex kernels
+const int triplexPowerMin = 2;
+const int triplexPowerMax = 16;
+
+/**
+ * @brief Returns power as integer if it has a specialized triplex kernel, else 0
+ */
+int getIntegerPower(float power);
+
+/**
+ * @brief Returns random value in [0, 1) for a sample of a pixel, same as pixelNoise in compute shader
+ * Value is computed from integers only, so CPU and GPU get exactly the same noise.
+ */
+float pixelNoise(glm::ivec2 pixel, int subframe);
+
+/**
+ * @brief Mandelbulb distance estimation, integer powers use triplex kernels without trigonometry
+ * @param integerPower Power from getIntegerPower, 0 if power is fractional
+ */
+float mandelbulbDistance(const Fractal& fractal, int integerPower, glm::vec3 point);
+
+/**
+ * @brief Mandelbulb distance estimation in double precision, used by deep zoom
+ * Integer powers are iterated in triplex algebra like the compute shader iterates them in double-float.
+ */
+double mandelbulbDistance(const Fractal& fractal, int integerPower, glm::dvec3 point);
+
+class BrickMap;
+class OccupancyOctree;
+
 #define FAR_PLANE 15.0f		// far plane distance
 #define NEAR_PLANE 0.0f		// near plane distance
 
 class Raymarcher
 {
 public:
-	Raymarcher(glm::vec2 screenSize, Camera* camera, Fractal* fractalInfo, Rendering* renderingInfo);
+	Raymarcher(glm::vec2 screenSize, Camera* camera, Fractal* fractalInfo, Rendering* renderingInfo, Coloring* coloringInfo);
 
 	/**
 	 * @brief Computes color of a given pixel
+	 * Raymarcher doesn't change its state, so it can be shared by multiple rendering threads.
+	 * Pixel is supersampled on the same subpixel grid as the subframes of the compute shader.
+	 */
+	glm::vec3 getColor(glm::vec2 pixelCoords) const;
+
+	/**
+	 * @brief Computes colors of consecutive pixels in one row
+	 * Rays are marched in SIMD packets, if the CPU supports it.
+	 * @param firstPixel Coordinates of the first pixel
+	 * @param count Number of pixels
+	 * @param colors Output colors
+	 */
+	void getColors(glm::ivec2 firstPixel, int count, glm::vec4* colors) const;
+
+	/**
+	 * @brief Sets instruction set used for marching of ray packets, simdScalar disables packets
+	 */
+	void setSimdLevel(SimdLevel level);
+
+	SimdLevel getSimdLevel() const;
+
+	/**
+	 * @brief Sets brick map which rays march far from the surface, nullptr marches exact distance estimation only
+	 * Map has to be baked for the fractal of the raymarcher. It is used by rays marched one by one,
+	 * SIMD packets march exact distance estimation, which is faster than lookups of the map outside CPU cache.
 	 */
-	glm::vec3 getColor(glm::vec2 pixelCoords);
+	void setBrickMap(const BrickMap* brickMap);
+
+	/**
+	 * @brief Sets octree whose empty nodes rays skip, nullptr marches all space
+	 * Octree has to be built for the fractal of the raymarcher. It is used by rays marched one by one.
+	 */
+	void setOccupancyOctree(const OccupancyOctree* octree);
+
+	/**
+	 * @brief Sets whether rays are marched relative to the camera and the fractal is iterated in double precision
+	 * Sample points stay small offsets from the camera, which float represents precisely at any zoom, and the precise
+	 * position of the camera is added to them in double. Deep zoom marches rays one by one and does not use brick map
+	 * and octree, which are in world coordinates.
+	 */
+	void setDeepZoom(bool enabled);
 
 private:
+	// benchmark measures the stages of the pipeline separately
+	friend class RaymarcherBenchmark;
+
 	glm::vec2 screenSize;
+	glm::mat4 viewMatrix;	// camera to world transformation, computed once per frame
 	Fractal* fractal;		// fractal info
 	Rendering* rendering;	// rendering info
+	Coloring* coloring;		// coloring info
 	Camera* camera;
+	int integerPower;		// power of triplex kernel or 0 if power is fractional
+	SimdLevel simdLevel;
+	MarchPacketFunc marchPacketFunc;	// nullptr if packets are not used
+	const BrickMap* brickMap;	// cached distance estimation, nullptr if it is not used
+	const OccupancyOctree* occupancy;	// empty space that is skipped, nullptr if it is not used
+	bool deepZoom;			// rays start in the origin and sample points are relative to precise camera position
 
     /**
      * @brief Returns direction of a ray going through given pixel
      */
-    glm::vec3 rayDirection(glm::vec2 pixelCoord);
+    glm::vec3 rayDirection(glm::vec2 pixelCoord) const;
+
+	/**
+	 * @brief Returns origin of primary rays, camera position or zero in deep zoom
+	 */
+	glm::vec3 rayOrigin() const;
+
+	/**
+	 * @brief Returns offset of the sample in pixel, samples are ordered as subframes of the compute shader
+	 */
+	glm::vec2 subframeOffset(int subframe) const;
 
 	/**
 	 * @brief Signed distance function of a scene
 	 * @param point Point for which to calculate SDF
 	 */
-	float sceneSDF(glm::vec3 point);
+	float sceneSDF(glm::vec3 point) const;
+
+	/**
+	 * @brief Distance used for marching, brick map far from the surface and exact distance estimation near it
+	 * @param exactBelow Cached distances below this are replaced by exact distance, at least near distance of the map
+	 */
+	float marchingSDF(glm::vec3 point, float exactBelow) const;
+
+	/**
+	 * @brief Mandelbulb distance estimation of the fractal of the raymarcher
+	 */
+	float mandelbulbSDF(glm::vec3 point) const;
 
-	float mandelbulbSDF(glm::vec3 point);
+	/**
+	 * @brief Computes orbit trap of a point, iterates the fractal the same way as mandelbulbSDF
+	 * Traps are needed only for coloring of hit points, so distance estimation stays without them.
+	 * @return Square of the last orbit radius, minimal distances to planes x = 0 and y = 0 and minimal square radius
+	 */
+	glm::vec4 orbitTrap(glm::vec3 point) const;
+
+	float sphereSDF(glm::vec3 sphereCenter, float sphereRadius, glm::vec3 point) const;
 
-	float sphereSDF(glm::vec3 sphereCenter, float sphereRadius, glm::vec3 point);
+	glm::vec3 estimateNormal(glm::vec3 p, float dist, float epsilon) const;
+
+	/**
+	 * @param noise Random value in [0, 1) of the sample, see pixelNoise
+	 */
+	glm::vec3 trace(Ray r, float noise) const;
 
-	glm::vec3 estimateNormal(glm::vec3 p, float dist, float epsilon);
+	/**
+	 * @brief Marches the ray until it hits the fractal, reaches far plane or runs out of steps
+	 */
+	MarchResult march(Ray r) const;
 
-	glm::vec3 trace(Ray r);
+	/**
+	 * @brief Returns distance at which marching starts, rays skip the space outside bounding sphere
+	 */
+	float startDistance(glm::vec3 origin) const;
 
-	glm::vec3 shade(glm::vec3 point, glm::vec3 viewDirection, glm::vec3 color, float dist, float epsilon);
+	/**
+	 * @brief Computes color of a marched ray
+	 */
+	glm::vec3 traceColor(Ray r, const MarchResult& result, float noise) const;
+
+	glm::vec3 shade(glm::vec3 point, glm::vec3 viewDirection, glm::vec3 color, float dist, float epsilon, float noise) const;
+
+	/**
+	 * @brief Marches shadow ray towards the light
+	 * @return 0 for point in full shadow, 1 for lit point
+	 */
+	float softShadow(glm::vec3 point, float epsilon) const;
+
+	/**
+	 * @brief Ambient occlusion approximation
+	 * Samples proximity in a few points along a normal with origin in given point
+	 * @param noise Random offset of the samples
+	 */
+	float ambientOcclusion(glm::vec3 p, glm::vec3 n, float epsilon, float noise) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,207 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	RenderJob.cpp
+ *
+ */
+
+#include "RenderJob.h"
+#include "ImageWriter.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+const char checkpointMagic[8] = { 'F', 'R', 'A', 'C', 'J', 'O', 'B', '1' };
+
+static volatile std::sig_atomic_t terminationRequested = 0;
+
+static void requestTermination(int)
+{
+	terminationRequested = 1;
+}
+
+void installTerminationHandler()
+{
+	std::signal(SIGTERM, requestTermination);
+}
+
+bool isTerminationRequested()
+{
+	return terminationRequested != 0;
+}
+
+/**
+ * @brief Returns size of a file in bytes, 0 if file does not exist
+ */
+static size_t fileSize(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+
+	return size_t(file.tellg());
+}
+
+RenderJob::RenderJob()
+{
+	resolution = glm::ivec2(0);
+	tileCount = 0;
+	resumedTiles = 0;
+}
+
+bool RenderJob::open(const std::string& outputPath, glm::ivec2 resolution, glm::ivec2 tileSize, uint64_t paramsHash)
+{
+	this->outputPath = outputPath;
+	this->resolution = resolution;
+
+	glm::ivec2 tiles = (resolution + tileSize - 1) / tileSize;
+	tileCount = tiles.x * tiles.y;
+	resumedTiles = 0;
+	unsyncedTiles.clear();
+
+	std::string imagePath = outputPath + ".partial";
+	size_t imageSize = size_t(resolution.x) * resolution.y * 3 * sizeof(float);
+
+	// tiles can be reused only if their pixels survived as well
+	bool imageExists = fileSize(imagePath) == imageSize;
+
+	if (!checkpoint.open(outputPath + ".checkpoint", sizeof(CheckpointHeader) + tileCount) ||
+		!partialImage.open(imagePath, imageSize))
+		return false;
+
+	CheckpointHeader expected;
+	memcpy(expected.magic, checkpointMagic, sizeof(expected.magic));
+	expected.width = uint32_t(resolution.x);
+	expected.height = uint32_t(resolution.y);
+	expected.tileWidth = uint32_t(tileSize.x);
+	expected.tileHeight = uint32_t(tileSize.y);
+	expected.paramsHash = paramsHash;
+
+	CheckpointHeader* header = (CheckpointHeader*)checkpoint.getData();
+	uint8_t* flags = getTileFlags();
+
+	if (imageExists && memcmp(header, &expected, sizeof(CheckpointHeader)) == 0)
+	{
+		for (int i = 0; i < tileCount; i++)
+			resumedTiles += flags[i] != 0;
+	}
+	else
+	{
+		// new job, or the old one was rendered with different parameters
+		memset(flags, 0, tileCount);
+		memcpy(header, &expected, sizeof(CheckpointHeader));
+	}
+
+	return true;
+}
+
+bool RenderJob::isTileDone(int index) const
+{
+	return getTileFlags()[index] != 0;
+}
+
+void RenderJob::storeTile(int index, const Tile& tile, const glm::vec4* data)
+{
+	float* pixels = getPixels();
+
+	for (int y = 0; y < tile.size.y; y++)
+	{
+		float* row = pixels + (size_t(tile.origin.y + y) * resolution.x + tile.origin.x) * 3;
+		for (int x = 0; x < tile.size.x; x++)
+		{
+			const glm::vec4& pixel = data[y * tile.size.x + x];
+			row[x * 3 + 0] = pixel.x;
+			row[x * 3 + 1] = pixel.y;
+			row[x * 3 + 2] = pixel.z;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(syncMutex);
+	unsyncedTiles.push_back(index);
+
+	if (int(unsyncedTiles.size()) >= checkpointInterval)
+		syncTiles();
+}
+
+bool RenderJob::sync()
+{
+	std::lock_guard<std::mutex> lock(syncMutex);
+	return syncTiles();
+}
+
+bool RenderJob::syncTiles()
+{
+	// pages of both mappings reach the disk in any order, so pixels are flushed before the flags
+	// that refer to them, otherwise a lost node could resume tiles whose pixels were never written
+	if (!partialImage.flush())
+	{
+		std::cout << "Failed to write partial image " << outputPath << ".partial" << std::endl;
+		return false;
+	}
+
+	uint8_t* flags = getTileFlags();
+	for (int index : unsyncedTiles)
+		flags[index] = 1;
+	unsyncedTiles.clear();
+
+	if (!checkpoint.flush())
+	{
+		std::cout << "Failed to write checkpoint " << outputPath << ".checkpoint" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int RenderJob::getResumedTiles() const
+{
+	return resumedTiles;
+}
+
+bool RenderJob::finish()
+{
+	// if the image cannot be saved, the job is resumed from the checkpoint
+	sync();
+
+	ImageWriter writer;
+	if (!writer.open(outputPath, resolution.x, resolution.y))
+		return false;
+
+	const float* pixels = getPixels();
+	std::vector<glm::vec4> row(resolution.x);
+
+	for (int y = resolution.y - 1; y >= 0; y--)
+	{
+		const float* values = pixels + size_t(y) * resolution.x * 3;
+		for (int x = 0; x < resolution.x; x++)
+			row[x] = glm::vec4(values[x * 3 + 0], values[x * 3 + 1], values[x * 3 + 2], 1.0f);
+
+		if (!writer.writeRow(row.data()))
+			break;
+	}
+
+	if (!writer.close())
+		return false;
+
+	checkpoint.close();
+	partialImage.close();
+	std::remove((outputPath + ".checkpoint").c_str());
+	std::remove((outputPath + ".partial").c_str());
+
+	return true;
+}
+
+uint8_t* RenderJob::getTileFlags() const
+{
+	return checkpoint.getData() + sizeof(CheckpointHeader);
+}
+
+float* RenderJob::getPixels() const
+{
+	return (float*)partialImage.getData();
+}
@@ -0,0 +1,112 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	RenderJob.h
+ *
+ */
+
+#pragma once
+
+#ifndef RENDER_JOB_H
+#define RENDER_JOB_H
+
+#include "MappedFile.h"
+#include "TileRenderer.h"
+
+#include <mutex>
+#include <vector>
+
+// number of stored tiles after which the partial image and the checkpoint are written to the disk
+const int checkpointInterval = 64;
+
+/**
+ * @brief Makes SIGTERM only request termination, so a resumable render can sync its checkpoint before it exits
+ */
+void installTerminationHandler();
+
+/**
+ * @brief Returns TRUE if SIGTERM was received since installTerminationHandler
+ */
+bool isTerminationRequested();
+
+/**
+ * @brief Resumable offline render
+ * Rendered tiles are stored in a partial image and marked in a checkpoint file, both files
+ * are mapped to memory. When the job is opened again with the same parameters, finished tiles
+ * are skipped, so a killed render continues where it stopped. Tiles are marked only once their
+ * pixels were synced to the disk, so a lost node never resumes tiles whose pixels did not survive.
+ */
+class RenderJob
+{
+public:
+	RenderJob();
+
+	/**
+	 * @brief Opens checkpoint of the job or starts a new one
+	 * Checkpoint and partial image are stored next to the output image.
+	 * @param outputPath Path of the final image
+	 * @param paramsHash Hash of all parameters that affect the image, checkpoint with different hash is discarded
+	 * @return TRUE if job was opened, else FALSE
+	 */
+	bool open(const std::string& outputPath, glm::ivec2 resolution, glm::ivec2 tileSize, uint64_t paramsHash);
+
+	/**
+	 * @brief Returns TRUE if tile with a given index (in order of TileRenderer::createTiles) was already rendered
+	 */
+	bool isTileDone(int index) const;
+
+	/**
+	 * @brief Copies rendered tile to the partial image, it is marked as finished by the next sync
+	 * Can be called from multiple threads for different tiles, syncs every checkpointInterval tiles.
+	 * @param data Pixels of the tile row by row
+	 */
+	void storeTile(int index, const Tile& tile, const glm::vec4* data);
+
+	/**
+	 * @brief Writes the partial image to the disk and only then marks stored tiles in the checkpoint and writes it
+	 * @return TRUE if both files were written, else FALSE
+	 */
+	bool sync();
+
+	/**
+	 * @brief Returns number of tiles that were finished when the job was opened
+	 */
+	int getResumedTiles() const;
+
+	/**
+	 * @brief Saves finished image to the output file and removes checkpoint and partial image
+	 * @return TRUE if image was saved, else FALSE (checkpoint is kept)
+	 */
+	bool finish();
+
+private:
+	// header of the checkpoint file, followed by one byte for every tile
+	struct CheckpointHeader
+	{
+		char magic[8];
+		uint32_t width;
+		uint32_t height;
+		uint32_t tileWidth;
+		uint32_t tileHeight;
+		uint64_t paramsHash;
+	};
+
+	MappedFile checkpoint;
+	MappedFile partialImage;		// RGB floats, first row is the bottom row of the image
+
+	std::string outputPath;
+	glm::ivec2 resolution;
+	int tileCount;
+	int resumedTiles;
+
+	std::mutex syncMutex;
+	std::vector<int> unsyncedTiles;		// stored tiles which are not marked in the checkpoint yet
+
+	bool syncTiles();
+	uint8_t* getTileFlags() const;
+	float* getPixels() const;
+};
+
+#endif // !RENDER_JOB_H
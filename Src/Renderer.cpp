@@ -36,27 +36,80 @@ Renderer::Renderer()
 
 	GUIchanged = false;
 	fullscreen = false;
+	computeProgram = 0;
+	mainCamera = nullptr;
+	recording = false;
+	saveFrame = false;
+	captureFormat = 0;
+	meshResolutionMode = 1;
+	meshNumber = 0;
+	pathMode = pathIdle;
+	pathFrame = 0;
+	pathTime = 0.0;
+	lastFrameTime = 0.0;
+	progressive = true;
+	frameBudget = frameBudgetDefault;
+	progressiveScale = progressiveScaleInitial;
+	rayCost = 0.0;
+	rayCostFrame = 0;
+	displayedScale = 1.0f;
+	displayedRenderSize = resolution;
+	reprojection = true;
+	historyLength = historyLengthDefault;
+	historyValid = false;
+	previousView = glm::mat4(1.0f);
+	previousOrigin = glm::vec3(0.0f);
+	reprojectedFrames = 0;
+	currentBuffer = 0;
+	coneMarching = true;
+	conePrepassProgram = 0;
+	adaptiveSampling = false;
+	noiseThreshold = noiseThresholdDefault;
+	compactProgram = 0;
+	listProgram = 0;
+	brickMapMode = 0;
+	useBrickMap = false;
+	for (int i = 0; i < 3; i++)
+		brickMapTextures[i] = 0;
+	octreeMode = 0;
+	useOctree = false;
+	octreeTexture = 0;
+	deepZoom = false;
+
+	for (int i = 0; i < profilerFrames; i++)
+	{
+		dispatchRecords[i].frameNumber = 0;
+		dispatchRecords[i].rays = 0.0;
+	}
+	fractalType = fractalMandelbulb;
+	fixedIterations = false;
 
-	fractal.power = 8.0;
-	fractal.iterations = 6;
-	rendering.maxSteps = 80;
-	rendering.detail = 4;
-	rendering.detailPower = 1.5;
-	rendering.shadows = false;
-	rendering.shadowSoftness = 16.0;
-	rendering.antialiasing = 1;
-	rendering.lightPosition = glm::normalize(glm::vec3(0.0, 1.4, 1.7));
-
-	coloring.bgColor[0] = 0.53f; coloring.bgColor[1] = 0.8f; coloring.bgColor[2] = 0.8f;
-	coloring.fractalColor[0] = 0.334f; coloring.fractalColor[1] = 0.42f; coloring.fractalColor[2] = 0.184f;
-	coloring.oTrapColor[0] = 0.741f; coloring.oTrapColor[1] = 0.718f; coloring.oTrapColor[2] = 0.42f;
-	coloring.yTrapColor[0] = 0.58f; coloring.yTrapColor[1] = 0.313f; coloring.yTrapColor[2] = 0.0f;
+	fractal = defaultFractal();
+	rendering = defaultRendering();
+	coloring = defaultColoring();
 
 	glViewport(0, 0, resolution.x, resolution.y);
 }
 
 Renderer::~Renderer()
 {
+	// background baking has to finish before the textures are deleted
+	if (brickMapBake.valid())
+		brickMapBake.wait();
+
+	if (octreeBuild.valid())
+		octreeBuild.wait();
+
+	if (meshExport.valid())
+		meshExport.wait();
+
+	deleteImageBuffers();
+	glDeleteTextures(3, brickMapTextures);
+	glDeleteTextures(1, &octreeTexture);
+	parameterBuffer.destroy();
+	profiler.destroy();
+	frameCapture.destroy();
+
 	// cleanup imgui
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -84,8 +137,8 @@ bool Renderer::initialize()
 	qsPath += fs::path("Shaders/quadShader.frag");
 
 	// compute shader path
-	fs::path csPath = rootDir;
-	csPath += fs::path("Shaders/compShader.comp");
+	computeShaderPath = rootDir;
+	computeShaderPath += fs::path("Shaders/compShader.comp");
 
 	shaderManager = ShaderManager();
 
@@ -96,46 +149,202 @@ bool Renderer::initialize()
 		return false;
 	}
 
-	computeProgram = shaderManager.createComputeProgram(csPath);
-	if (computeProgram == 0)
+	if (!updateComputeProgram())
+		return false;
+
+	if (!parameterBuffer.create())
 	{
-		std::cout << "Failed to create compute shader program" << std::endl;
+		std::cout << "Failed to create parameter buffer" << std::endl;
 		return false;
 	}
 
-	getUniformLocations();
+	profiler.create();
 
-	// set rendering uniforms
-	shaderManager.setUniformFloat(uniformLocations.detail, 1.0f / powf(10, rendering.detail));
-	shaderManager.setUniformFloat(uniformLocations.detailPower, rendering.detailPower);
-	shaderManager.setUniformInt(uniformLocations.maxSteps, rendering.maxSteps);
-	shaderManager.setUniformInt(uniformLocations.shadows, rendering.shadows);
-	shaderManager.setUniformFloat(uniformLocations.shadowSoftness, rendering.shadowSoftness);
-	shaderManager.setUniformVec3(uniformLocations.light, rendering.lightPosition);
+	vao = shaderManager.createQuadVAO();
+	createImageBuffers();
 
-	// set fractal uniforms
-	shaderManager.setUniformFloat(uniformLocations.fractalPower, fractal.power);
-	shaderManager.setUniformInt(uniformLocations.fractalIter, fractal.iterations);
+	//shaderManager.printWorkGroupLimits();
 
-	// set coloring uniforms
-	shaderManager.setUniformVec3(uniformLocations.bgColor, 
-		glm::vec3(coloring.bgColor[0], coloring.bgColor[1], coloring.bgColor[2]));
-	shaderManager.setUniformVec3(uniformLocations.fractalColor,
-		glm::vec3(coloring.fractalColor[0], coloring.fractalColor[1], coloring.fractalColor[2]));
-	shaderManager.setUniformVec3(uniformLocations.oTrapColor,
-		glm::vec3(coloring.oTrapColor[0], coloring.oTrapColor[1], coloring.oTrapColor[2]));
-	shaderManager.setUniformVec3(uniformLocations.yTrapColor,
-		glm::vec3(coloring.yTrapColor[0], coloring.yTrapColor[1], coloring.yTrapColor[2]));
+	return true;
+}
 
-	vao = shaderManager.createQuadVAO();
-	frameBuffer = shaderManager.createTexture(resolution.x, resolution.y, 0, GL_WRITE_ONLY);
-	accumulationBuffer = shaderManager.createTexture(resolution.x, resolution.y, 1, GL_READ_WRITE);
+bool Renderer::updateComputeProgram()
+{
+	ShaderVariant variant;
+	variant.fractalType = fractalType;
+	variant.shadows = rendering.shadows;
+	variant.ambientOcclusion = rendering.ambientOcclusion;
+	variant.fixedIterations = fixedIterations ? fractal.iterations : 0;
+	variant.conePass = coneMarching ? coneStart : coneNone;
+	variant.brickMap = useBrickMap;
+	variant.occupancyOctree = useOctree;
+	variant.deepZoom = deepZoom && fractalType == fractalMandelbulb;
+	variant.adaptivePass = adaptiveSampling ? adaptiveFull : adaptiveNone;
+
+	GLuint program = shaderManager.getComputeProgram(computeShaderPath, variant);
+	if (program == 0)
+	{
+		std::cout << "Failed to create compute shader program" << std::endl;
+		return false;
+	}
 
-	//shaderManager.printWorkGroupLimits();
+	// prepass does not shade, so shading features do not need variants of it
+	GLuint prepassProgram = 0;
+	if (coneMarching)
+	{
+		ShaderVariant prepassVariant = variant;
+		prepassVariant.shadows = false;
+		prepassVariant.ambientOcclusion = false;
+		prepassVariant.conePass = conePrepass;
+		prepassVariant.adaptivePass = adaptiveNone;
+
+		prepassProgram = shaderManager.getComputeProgram(computeShaderPath, prepassVariant);
+		if (prepassProgram == 0)
+		{
+			std::cout << "Failed to create cone prepass program" << std::endl;
+			return false;
+		}
+	}
+
+	// compaction only reads moments, list pass differs from the full pass only in pixels it samples
+	GLuint compactionProgram = 0;
+	GLuint sampleListProgram = 0;
+	if (adaptiveSampling)
+	{
+		ShaderVariant compactVariant = variant;
+		compactVariant.shadows = false;
+		compactVariant.ambientOcclusion = false;
+		compactVariant.conePass = coneNone;
+		compactVariant.adaptivePass = adaptiveCompact;
+
+		ShaderVariant listVariant = variant;
+		listVariant.adaptivePass = adaptiveList;
+
+		compactionProgram = shaderManager.getComputeProgram(computeShaderPath, compactVariant);
+		sampleListProgram = shaderManager.getComputeProgram(computeShaderPath, listVariant);
+		if (compactionProgram == 0 || sampleListProgram == 0)
+		{
+			std::cout << "Failed to create adaptive sampling programs" << std::endl;
+			return false;
+		}
+	}
+
+	// parameters are in uniform buffer shared by all variants, so nothing has to be set again
+	computeProgram = program;
+	conePrepassProgram = prepassProgram;
+	compactProgram = compactionProgram;
+	listProgram = sampleListProgram;
 
 	return true;
 }
 
+void Renderer::startMeshExport()
+{
+	std::error_code error;
+	fs::create_directories(fs::u8path(captureDirectory), error);
+
+	char name[32];
+	snprintf(name, sizeof(name), "mesh_%03d.ply", meshNumber++);
+	std::string path = (fs::u8path(captureDirectory) / fs::u8path(name)).u8string();
+
+	Fractal meshFractal = fractal;
+	int cells = meshResolutions[meshResolutionMode];
+
+	meshExport = std::async(std::launch::async, [meshFractal, cells, path]()
+	{
+		MeshWriter writer;
+		if (!writer.open(path))
+			return std::string("Failed to create ") + path;
+
+		ThreadPool pool;
+		MeshExtractor extractor(&pool);
+		bool success = extractor.extract(meshFractal, cells, writer);
+
+		if (!writer.close() || !success)
+			return std::string("Failed to write ") + path;
+
+		return "Saved " + std::to_string(writer.getTriangleCount()) + " triangles to " + path;
+	});
+}
+
+void Renderer::updateBrickMap()
+{
+	int bricks = (brickMapMode > 0 && fractalType == fractalMandelbulb && !deepZoom) ? brickMapResolutions[brickMapMode - 1] : 0;
+
+	// finished map replaces the previous one, it is used only if the fractal did not change during baking
+	if (brickMapBake.valid() && brickMapBake.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		brickMap = brickMapBake.get();
+		brickMap->upload(brickMapTextures);
+	}
+
+	bool ready = bricks != 0 && brickMap && brickMap->matches(fractal, bricks);
+
+	if (bricks != 0 && !ready && !brickMapBake.valid())
+	{
+		Fractal bakedFractal = fractal;
+		brickMapBake = std::async(std::launch::async, [bakedFractal, bricks]()
+		{
+			ThreadPool pool;
+			std::unique_ptr<BrickMap> map(new BrickMap());
+			map->bake(bakedFractal, bricks, pool);
+			return map;
+		});
+	}
+
+	if (ready != useBrickMap)
+	{
+		useBrickMap = ready;
+		updateComputeProgram();
+	}
+}
+
+void Renderer::updateOccupancyOctree()
+{
+	int leaves = (octreeMode > 0 && fractalType == fractalMandelbulb && !deepZoom) ? occupancyResolutions[octreeMode - 1] : 0;
+
+	if (octreeBuild.valid() && octreeBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		octree = octreeBuild.get();
+		octree->upload(octreeTexture);
+	}
+
+	bool ready = leaves != 0 && octree && octree->matches(fractal, leaves);
+
+	if (leaves != 0 && !ready && !octreeBuild.valid())
+	{
+		Fractal builtFractal = fractal;
+		octreeBuild = std::async(std::launch::async, [builtFractal, leaves]()
+		{
+			ThreadPool pool;
+			std::unique_ptr<OccupancyOctree> built(new OccupancyOctree());
+			built->build(builtFractal, leaves, pool);
+			return built;
+		});
+	}
+
+	// skipped steps lighten step based ambient occlusion, so samples with and without octree are not mixed
+	if (ready != useOctree)
+	{
+		useOctree = ready;
+		updateComputeProgram();
+		guiChanged();
+	}
+}
+
+ShaderParameters Renderer::getShaderParameters() const
+{
+	ShaderParameters parameters = createShaderParameters(*mainCamera, fractal, rendering, coloring, resolution);
+
+	if (useBrickMap)
+		brickMap->setParameters(parameters);
+
+	if (useOctree)
+		octree->setParameters(parameters);
+
+	return parameters;
+}
+
 GLFWwindow* Renderer::createWindowAndGLContext()
 {
 	glfwInit();
@@ -159,10 +368,28 @@ GLFWwindow* Renderer::createWindowAndGLContext()
 
 void Renderer::draw()
 {
+	// results of older frames are collected here, so they are shown in this frame's GUI
+	profiler.beginFrame();
+
+	double currentTime = glfwGetTime();
+	double frameTime = currentTime - lastFrameTime;
+	lastFrameTime = currentTime;
+
+	updateCameraPath(frameTime);
+	updateBrickMap();
+	updateOccupancyOctree();
+
+	// camera of deep zoom slows down with its distance from the surface, so it can get closer than float resolves,
+	// it does not stop completely, so it can leave the surface again
+	mainCamera->speedScale = 1.0f;
+	if (deepZoom && fractalType == fractalMandelbulb)
+	{
+		double distance = mandelbulbDistance(fractal, getIntegerPower(fractal.power), mainCamera->precisePosition);
+		mainCamera->speedScale = glm::clamp(float(distance), powf(10.0f, -deepZoomDetailMax), 1.0f);
+	}
+
 #ifndef CPU_RAYMARCH
-	/*GLuint queryTime;
-	glGenQueries(1, &queryTime);
-	GLuint queryTimePassed = 0;*/
+	updateRayCost();
 
 	int AA = rendering.antialiasing;
 	static int AAsampleX = 0;
@@ -179,70 +406,143 @@ void Renderer::draw()
 		AAsampleX = 0;
 		AAsampleY = 0;
 		render = true;
+	}
 
-		// set camera uniforms
-		shaderManager.setUniformVec3(uniformLocations.origin, mainCamera->position);
-		shaderManager.setUniformMat4(uniformLocations.viewMatrix, mainCamera->getViewMatrix());
-		shaderManager.setUniformFloat(uniformLocations.vFov, mainCamera->vFov);
+	// moving camera is rendered coarse, full resolution subframes follow once it stops
+	float pixelScale = 1.0f;
+	if (render)
+	{
+		pixelScale = getProgressiveScale();
+		progressiveScale = pixelScale;
 	}
 
+	// full resolution frame of a moving camera continues samples of the previous frame,
+	// changed scene starts from nothing, motion of deep zoom is below float precision of the previous camera
+	bool reproject = render && reprojection && !deepZoom && historyValid && !GUIchanged && pixelScale == 1.0f;
+
 	if (render || ((AAsampleX < AA) && (AAsampleY < AA)))
 	{
 		glm::vec2 subframeOffset;
 		int subframeID = AAsampleX * AA + AAsampleY;
 
+		// reprojected frames go through all subframe offsets, so motion accumulates antialiased samples too
+		if (reproject)
+		{
+			subframeID = reprojectedFrames % (AA * AA);
+			reprojectedFrames++;
+		}
+		else if (render)
+		{
+			reprojectedFrames = 0;
+		}
+
+		// subframes after adaptiveStartSubframes sample only pixels whose mean is still noisy
+		bool listPass = adaptiveSampling && !render && subframeID >= adaptiveStartSubframes;
+
 		if (AA == 1)
 		{
 			subframeOffset.x = 0.0;
 			subframeOffset.y = 0.0;
 		}
+		else if (adaptiveSampling)
+		{
+			// first subframes have to cover the whole pixel, so noise of edges in any direction is found
+			subframeOffset = getStratifiedSubframeOffset(subframeID, AA);
+		}
 		else
 		{
-			subframeOffset.x = float(AAsampleX) / float(AA);
-			subframeOffset.y = float(AAsampleY) / float(AA);
+			subframeOffset.x = float(subframeID / AA) / float(AA);
+			subframeOffset.y = float(subframeID % AA) / float(AA);
 		}
 
 		/*std::cout << "subframeID: " << subframeID << std::endl;
 		std::cout << "X: " << AAsampleX << ", offsetX: " << subframeOffset.x << "\tY: " << AAsampleY << ", offsetY: " << subframeOffset.y << std::endl;
 		std::cout << "============================\n";*/
 
+		ScopedTimer timer(profiler, passDispatch);
+		profiler.beginGPU(passDispatch);
+
+		// new accumulation is written to the other buffers, buffers of the previous frame become history
+		if (render)
+		{
+			currentBuffer = 1 - currentBuffer;
+			bindImageBuffers();
+		}
+
 		glActiveTexture(GL_TEXTURE0);
 		glUseProgram(computeProgram);
-		shaderManager.setUniformVec2(uniformLocations.subframeOffset, subframeOffset);
-		shaderManager.setUniformInt(uniformLocations.subframeID, subframeID);
 
-		//glBeginQuery(GL_TIME_ELAPSED, queryTime);
-
-		glm::vec2 workGroupSize = glm::vec2(float(resolution.x) / tileDimensions.x, float(resolution.y) / tileDimensions.y);
-		workGroupSize += 0.5f;
+		// whole parameter block is uploaded once per subframe
+		parameters = getShaderParameters();
+		parameters.subframeOffset = subframeOffset;
+		parameters.subframeID = subframeID;
+		parameters.pixelScale = pixelScale;
+		parameters.renderSize = getRenderSize(resolution, pixelScale);
+		parameters.noiseThreshold = noiseThreshold;
+		if (reproject)
+		{
+			parameters.previousView = previousView;
+			parameters.previousOrigin = previousOrigin;
+			parameters.historyLimit = float(historyLength);
+		}
+		parameterBuffer.upload(parameters);
 
 		// start compute shader
-		// number of work groups is based on resolution and tile dimensions
-		glDispatchCompute(GLuint(workGroupSize.x), GLuint(workGroupSize.y), 1);
+		// number of work groups is based on rendered resolution and tile dimensions
+		glm::ivec2 renderSize = parameters.renderSize;
+		glm::ivec2 workGroups = (renderSize + tileDimensions - 1) / tileDimensions;
 
-		// wait for all invocations of compute shader to finish writing to an image
-		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		// one cone per work group of the main pass
+		if (coneMarching)
+		{
+			glm::ivec2 coneGroups = (workGroups + tileDimensions - 1) / tileDimensions;
 
-		/*glEndQuery(GL_TIME_ELAPSED);
+			glUseProgram(conePrepassProgram);
+			glDispatchCompute(GLuint(coneGroups.x), GLuint(coneGroups.y), 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+			glUseProgram(computeProgram);
+		}
 
-		int done = false;
-		while (!done) {
-			glGetQueryObjectiv(queryTime,
-				GL_QUERY_RESULT_AVAILABLE,
-				&done);
+		if (listPass)
+		{
+			adaptiveSampler.compact(compactProgram, workGroups);
+			adaptiveSampler.dispatchList(listProgram);
 		}
+		else
+		{
+			glDispatchCompute(GLuint(workGroups.x), GLuint(workGroups.y), 1);
+		}
+
+		// wait for all invocations of compute shader to finish writing to an image
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		parameterBuffer.frameSubmitted();
+		profiler.endGPU(passDispatch);
+
+		// GPU time of this dispatch is collected by profiler a few frames later,
+		// number of rays of the list pass is known only on GPU, so its time does not change the cost of a ray
+		DispatchRecord& record = dispatchRecords[profiler.getFrameNumber() % profilerFrames];
+		record.frameNumber = profiler.getFrameNumber();
+		record.rays = listPass ? 0.0 : double(renderSize.x) * renderSize.y;
 
-		glGetQueryObjectuiv(queryTime, GL_QUERY_RESULT, &queryTimePassed);
+		displayedScale = pixelScale;
+		displayedRenderSize = renderSize;
 
-		std::cout << "Time: " << queryTimePassed << "ns" << std::endl;*/
+		// coarse frame covers only the corner of the buffers
+		historyValid = pixelScale == 1.0f;
+		previousView = glm::inverse(parameters.viewMatrix);
+		previousOrigin = parameters.origin;
 
-		AAsampleY++;
-		if ((AAsampleY >= AA))
+		// coarse frame is not a subframe, full resolution starts from subframe 0 again
+		if (pixelScale == 1.0f)
 		{
-			if (AAsampleX < AA-1)
+			AAsampleY++;
+			if ((AAsampleY >= AA))
 			{
-				AAsampleX++;
-				AAsampleY = 0;
+				if (AAsampleX < AA-1)
+				{
+					AAsampleX++;
+					AAsampleY = 0;
+				}
 			}
 		}
 
@@ -257,20 +557,25 @@ void Renderer::draw()
 
 	if (mainCamera->cameraChanged || GUIchanged)
 	{
-		Raymarcher raymarcher(resolution, mainCamera, &fractal, &rendering);
-		int size = resolution.x * resolution.y;
+		ScopedTimer timer(profiler, passDispatch);
+		Raymarcher raymarcher(resolution, mainCamera, &fractal, &rendering, &coloring);
+		if (useBrickMap)
+			raymarcher.setBrickMap(brickMap.get());
+		if (useOctree)
+			raymarcher.setOccupancyOctree(octree.get());
+		raymarcher.setDeepZoom(deepZoom);
 
-		std::vector<glm::vec4> data(size, glm::vec4(0.0, 0.0, 0.0, 1.0));
+		if (!threadPool)
+			threadPool = std::make_unique<ThreadPool>();
 
-		std::cout << "CPU rendering\nThis might take a while..." << std::endl;
+		TileRenderer tileRenderer(threadPool.get());
+		std::vector<glm::vec4> data;
+
+		std::cout << "CPU rendering on " << threadPool->getThreadCount() << " threads\nThis might take a while..." << std::endl;
 
 		double startT = glfwGetTime();
 
-		for (int y = 0; y < resolution.y; y++)
-			for (int x = 0; x < resolution.x; x++)
-			{
-				data[y * resolution.x + x] = glm::vec4(raymarcher.getColor(glm::vec2(x, y)), 1.0f);
-			}
+		tileRenderer.render(raymarcher, resolution, data);
 
 		double endT = glfwGetTime();
 
@@ -284,21 +589,69 @@ void Renderer::draw()
 	}
 #endif // !CPU_RAYMARCH
 
-	glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(quadProgram);
-	glBindVertexArray(vao);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	{
+		ScopedTimer timer(profiler, passQuad);
+		profiler.beginGPU(passQuad);
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		glUseProgram(quadProgram);
+		shaderManager.setUniformFloat(0, displayedScale);
+		shaderManager.setUniformVec2(1, glm::vec2(displayedRenderSize));
+		glBindVertexArray(vao);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		profiler.endGPU(passQuad);
+	}
+
+	// copy of the frame runs on GPU while next frames are rendered, files are written by encoder thread
+	if (recording || saveFrame)
+	{
+		frameCapture.capture(frameBuffer, resolution.x, resolution.y);
+		saveFrame = false;
+	}
+	frameCapture.update();
 
 	renderGUI();
 }
 
+void Renderer::updateRayCost()
+{
+	float milliseconds = 0.0f;
+	uint64_t frame = 0;
+
+	if (!profiler.getLastGPUTime(passDispatch, milliseconds, frame) || frame == rayCostFrame)
+		return;
+	rayCostFrame = frame;
+
+	const DispatchRecord& record = dispatchRecords[frame % profilerFrames];
+	if (record.frameNumber != frame || record.rays <= 0.0)
+		return;
+
+	// cost changes with the view, so older measurements lose weight quickly
+	double cost = milliseconds / record.rays;
+	rayCost = rayCost > 0.0 ? 0.5 * rayCost + 0.5 * cost : cost;
+}
+
+float Renderer::getProgressiveScale() const
+{
+	if (!progressive || recording || saveFrame || pathMode == pathPlaying)
+		return 1.0f;
+
+	if (rayCost <= 0.0)
+		return progressiveScaleInitial;
+
+	// number of rays is proportional to 1 / scale^2
+	double rays = frameBudget / rayCost;
+	double scale = std::sqrt(double(resolution.x) * resolution.y / rays);
+
+	return float(glm::clamp(scale, 1.0, double(progressiveScaleMax)));
+}
+
 void Renderer::renderGUI()
 {
 	ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_FirstUseEver);
 	ImGui::SetNextWindowSize(ImVec2(425, 500), ImGuiCond_Once);
 
-	glUseProgram(computeProgram);	// because of setting uniforms
-
 	if (showGUI)
 	{
 		ImGui::Begin("Menu", &showGUI);
@@ -342,21 +695,30 @@ void Renderer::renderGUI()
 				guiChanged();
 			}
 
-			if (ImGui::SliderFloat("Detail", &(rendering.detail), renderingDetailMin, renderingDetailMax, "%.2f"))
+			if (ImGui::SliderFloat("Detail", &(rendering.detail), renderingDetailMin, deepZoom ? deepZoomDetailMax : renderingDetailMax, "%.2f"))
 			{
 				if (rendering.detail < renderingDetailMin)
 					rendering.detail = renderingDetailMin;
 
-				shaderManager.setUniformFloat(uniformLocations.detail, 1.0f / powf(10, rendering.detail));
 				guiChanged();
 			}
 
+			if (ImGui::Checkbox("Deep Zoom", &deepZoom))
+			{
+				// float does not resolve more detail
+				if (!deepZoom && rendering.detail > renderingDetailMax)
+					rendering.detail = renderingDetailMax;
+
+				updateComputeProgram();
+				guiChanged();
+			}
+			ImGui::SameLine(); HelpMarker("Marches rays relative to the camera and iterates the mandelbulb in double-float, so detail goes up to 12 and the camera slows down near the surface. Needs integer power, brick map, octree and reprojection are not used.");
+
 			if (ImGui::SliderFloat("Detail Power", &(rendering.detailPower), detailPowerMin, detailPowerMax, "%.2f"))
 			{
 				if (rendering.detailPower < detailPowerMin)
 					rendering.detailPower = detailPowerMin;
 
-				shaderManager.setUniformFloat(uniformLocations.detailPower, rendering.detailPower);
 				guiChanged();
 			}
 			ImGui::SameLine(); HelpMarker("Controls how detail changes with distance.");
@@ -366,22 +728,95 @@ void Renderer::renderGUI()
 				if (rendering.maxSteps < maxStepsMin)
 					rendering.maxSteps = maxStepsMin;
 
-				shaderManager.setUniformInt(uniformLocations.maxSteps, rendering.maxSteps);
 				guiChanged();
 			}
 			ImGui::SameLine(); HelpMarker("Maximal number of marching steps.");
 
-			const int AAvalues[] = { 1, 2, 4, 8, 16 };
 			static int itemCurrentAA = 0;
 			if (ImGui::Combo("Antialiasing", &itemCurrentAA, " Off\0 2x\0 4x\0 8x\0 16x\0\0"))
 			{
-				rendering.antialiasing = AAvalues[itemCurrentAA];
+				rendering.antialiasing = antialiasingValues[itemCurrentAA];
+				guiChanged();
+			}
+
+			if (ImGui::Checkbox("Adaptive Sampling", &adaptiveSampling))
+			{
+				updateComputeProgram();
+				guiChanged();
+			}
+			ImGui::SameLine(); HelpMarker("After the first few subframes of antialiasing only pixels whose color is still noisy get more samples.");
+
+			if (adaptiveSampling)
+			{
+				if (ImGui::SliderFloat("Noise Threshold", &noiseThreshold, noiseThresholdMin, noiseThresholdMax, "%.4f"))
+				{
+					if (noiseThreshold < noiseThresholdMin)
+						noiseThreshold = noiseThresholdMin;
+
+					if (noiseThreshold > noiseThresholdMax)
+						noiseThreshold = noiseThresholdMax;
+				}
+				ImGui::SameLine(); HelpMarker("Pixels stop getting samples once the standard error of their mean brightness is below this value.");
+			}
+
+			ImGui::Checkbox("Progressive", &progressive);
+			ImGui::SameLine(); HelpMarker("Renders lower resolution while the camera moves and refines the image once it stops.");
+
+			if (progressive)
+			{
+				if (ImGui::SliderFloat("Frame Budget", &frameBudget, frameBudgetMin, frameBudgetMax, "%.1f ms"))
+				{
+					if (frameBudget < frameBudgetMin)
+						frameBudget = frameBudgetMin;
+				}
+				ImGui::SameLine(); HelpMarker("GPU time of the fractal kept during motion, resolution is chosen from the measured GPU time of previous frames.");
+
+				glm::ivec2 motionResolution = getRenderSize(resolution, progressiveScale);
+				ImGui::Text("Motion resolution: %dx%d", motionResolution.x, motionResolution.y);
+			}
+
+			if (ImGui::Checkbox("Cone Prepass", &coneMarching))
+			{
+				updateComputeProgram();
 				guiChanged();
 			}
+			ImGui::SameLine(); HelpMarker("Marches one cone per 16x16 pixels first, rays start from the depth the cone reached instead of the bounding sphere.");
+
+			ImGui::Combo("Brick Map", &brickMapMode, " Off\0 16^3 bricks\0 32^3 bricks\0 64^3 bricks\0\0");
+			ImGui::SameLine(); HelpMarker("Bakes distance estimation of the mandelbulb around its surface in background. Rays march cached distances far from the surface and exact ones near it, changed fractal is baked again.");
+
+			if (useBrickMap)
+				ImGui::Text("Brick map: %d bricks, %.1f MB", int(brickMap->getBrickCount()), brickMap->getMemorySize() / (1024.0 * 1024.0));
+			else if (brickMapBake.valid())
+				ImGui::Text("Baking brick map...");
+
+			ImGui::Combo("Octree", &octreeMode, " Off\0 64^3 leaves\0 128^3 leaves\0 256^3 leaves\0\0");
+			ImGui::SameLine(); HelpMarker("Builds occupancy octree of the mandelbulb in background. Rays cross empty nodes in one step instead of marching them, so step based ambient occlusion gets lighter.");
+
+			if (useOctree)
+				ImGui::Text("Octree: %.1f %% empty, %.1f MB", 100.0f * octree->getEmptyFraction(), octree->getMemorySize() / (1024.0 * 1024.0));
+			else if (octreeBuild.valid())
+				ImGui::Text("Building octree...");
+
+			ImGui::Checkbox("Reprojection", &reprojection);
+			ImGui::SameLine(); HelpMarker("Full resolution frames of a moving camera reuse samples of the previous frame, pixels that were occluded start again.");
+
+			if (reprojection)
+			{
+				if (ImGui::SliderInt("History Samples", &historyLength, historyLengthMin, historyLengthMax, "%d"))
+				{
+					if (historyLength < historyLengthMin)
+						historyLength = historyLengthMin;
+
+					if (historyLength > historyLengthMax)
+						historyLength = historyLengthMax;
+				}
+				ImGui::SameLine(); HelpMarker("Largest number of samples taken over from the previous frame, more samples give smoother image with longer ghosting.");
+			}
 
 			if (ImGui::Checkbox("Shadows", &(rendering.shadows)))
 			{
-				shaderManager.setUniformInt(uniformLocations.shadows, rendering.shadows);
+				updateComputeProgram();
 				guiChanged();
 			}
 
@@ -396,10 +831,15 @@ void Renderer::renderGUI()
 					if (rendering.shadowSoftness > shadowSoftnessMax)
 						rendering.shadowSoftness = shadowSoftnessMax;
 
-					shaderManager.setUniformFloat(uniformLocations.shadowSoftness, rendering.shadowSoftness);
 					guiChanged();
 				}
 			}
+
+			if (ImGui::Checkbox("Ambient Occlusion", &(rendering.ambientOcclusion)))
+			{
+				updateComputeProgram();
+				guiChanged();
+			}
 		}
 
 		if (ImGui::CollapsingHeader("Fractal"))
@@ -412,9 +852,9 @@ void Renderer::renderGUI()
 				if (fractal.power > fractalPowerMax)
 					fractal.power = fractalPowerMax;
 
-				shaderManager.setUniformFloat(uniformLocations.fractalPower, fractal.power);
 				guiChanged();
 			}
+			ImGui::SameLine(); HelpMarker("Integer powers are rendered faster. Ctrl+click to enter exact value.");
 
 			if (ImGui::SliderInt("Iterations", &(fractal.iterations), fractalIterationsMin, fractalIterationsMax, "%d"))
 			{
@@ -423,38 +863,40 @@ void Renderer::renderGUI()
 					fractal.iterations = fractalIterationsMin;
 				}
 
-				shaderManager.setUniformInt(uniformLocations.fractalIter, fractal.iterations);
+				// iterations compiled into the shader need another variant
+				if (fixedIterations)
+					updateComputeProgram();
+				else
+				guiChanged();
+			}
+
+			if (ImGui::Checkbox("Fixed Iterations", &fixedIterations))
+			{
+				updateComputeProgram();
 				guiChanged();
 			}
+			ImGui::SameLine(); HelpMarker("Compiles number of iterations into the shader. Renders faster, but changing iterations compiles the shader again.");
 		}
 
 		if (ImGui::CollapsingHeader("Coloring"))
 		{
-			if (ImGui::ColorEdit3("Background", coloring.bgColor))
+			if (ImGui::ColorEdit3("Background", glm::value_ptr(coloring.bgColor)))
 			{
-				shaderManager.setUniformVec3(uniformLocations.bgColor,
-					glm::vec3(coloring.bgColor[0], coloring.bgColor[1], coloring.bgColor[2]));
 				guiChanged();
 			}
 
-			if (ImGui::ColorEdit3("Fractal Color", coloring.fractalColor))
+			if (ImGui::ColorEdit3("Fractal Color", glm::value_ptr(coloring.fractalColor)))
 			{
-				shaderManager.setUniformVec3(uniformLocations.fractalColor,
-					glm::vec3(coloring.fractalColor[0], coloring.fractalColor[1], coloring.fractalColor[2]));
 				guiChanged();
 			}
 
-			if (ImGui::ColorEdit3("O Trap Color", coloring.oTrapColor))
+			if (ImGui::ColorEdit3("O Trap Color", glm::value_ptr(coloring.oTrapColor)))
 			{
-				shaderManager.setUniformVec3(uniformLocations.oTrapColor,
-					glm::vec3(coloring.oTrapColor[0], coloring.oTrapColor[1], coloring.oTrapColor[2]));
 				guiChanged();
 			}
 
-			if (ImGui::ColorEdit3("Y Trap Color", coloring.yTrapColor))
+			if (ImGui::ColorEdit3("Y Trap Color", glm::value_ptr(coloring.yTrapColor)))
 			{
-				shaderManager.setUniformVec3(uniformLocations.yTrapColor,
-					glm::vec3(coloring.yTrapColor[0], coloring.yTrapColor[1], coloring.yTrapColor[2]));
 				guiChanged();
 			}
 		}
@@ -495,19 +937,276 @@ void Renderer::renderGUI()
 				lightPosition.z = cos(glm::radians(xAngle)) * cos(glm::radians(yAngle));
 				rendering.lightPosition = glm::normalize(lightPosition);
 
-				shaderManager.setUniformVec3(uniformLocations.light, rendering.lightPosition);
 				guiChanged();
 			}
 		}
 
+		if (ImGui::CollapsingHeader("Camera Path"))
+		{
+			if (pathMode == pathIdle)
+			{
+				if (ImGui::Button("Record"))
+				{
+					cameraPath.clear();
+					pathMode = pathRecording;
+					// first frame is recorded immediately
+					pathTime = pathTimestep;
+				}
+
+				ImGui::SameLine();
+				if (ImGui::Button("Play"))
+				{
+					if (cameraPath.load(cameraPathFile))
+						startPathPlayback();
+					else
+						std::cout << "Failed to load camera path " << cameraPathFile << std::endl;
+				}
+
+				ImGui::SameLine();
+				if (ImGui::Button("Play View Tour"))
+				{
+					cameraPath.createViewTour(getSceneState(), viewTourSegmentTime);
+					startPathPlayback();
+				}
+				ImGui::SameLine(); HelpMarker("Recorded path is saved to camera.path in working directory. Every drawn frame plays one recorded frame, frame times are written to camera_path_report.csv.");
+			}
+			else if (pathMode == pathRecording)
+			{
+				ImGui::Text("Recording frame %d", int(cameraPath.getFrameCount()));
+
+				if (ImGui::Button("Stop"))
+				{
+					pathMode = pathIdle;
+					if (!cameraPath.save(cameraPathFile))
+						std::cout << "Failed to save camera path " << cameraPathFile << std::endl;
+				}
+			}
+			else
+			{
+				ImGui::Text("Playing frame %d / %d", int(pathFrame), int(cameraPath.getFrameCount()));
+
+				if (ImGui::Button("Stop"))
+					finishPathPlayback();
+			}
+
+			if (!pathReport.empty())
+				ImGui::TextWrapped("%s", pathReport.c_str());
+		}
+
+		if (ImGui::CollapsingHeader("Capture"))
+		{
+			const char* const formatExtensions[] = { "png", "exr" };
+			ImGui::Combo("Format", &captureFormat, " PNG\0 OpenEXR\0\0");
+
+			if (ImGui::Checkbox("Record", &recording) && recording)
+			{
+				recording = frameCapture.start(captureDirectory, formatExtensions[captureFormat]);
+			}
+			ImGui::SameLine(); HelpMarker("Saves every drawn frame to capture directory in working directory. Frames are dropped when disk can not keep up.");
+
+			if (ImGui::Button("Save Frame"))
+			{
+				saveFrame = frameCapture.start(captureDirectory, formatExtensions[captureFormat]);
+			}
+
+			ImGui::Text("Saved %d frames, dropped %d frames", frameCapture.getSavedFrames(), frameCapture.getDroppedFrames());
+
+			ImGui::Combo("Mesh Cells", &meshResolutionMode, " 256^3\0 512^3\0 1024^3\0\0");
+
+			if (meshExport.valid() && meshExport.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+				meshStatus = meshExport.get();
+
+			if (ImGui::Button("Export Mesh") && !meshExport.valid() && fractalType == fractalMandelbulb)
+			{
+				startMeshExport();
+			}
+			ImGui::SameLine(); HelpMarker("Saves surface of the mandelbulb as a PLY mesh to capture directory. Surface is extracted in the background.");
+
+			if (meshExport.valid())
+				ImGui::Text("Extracting mesh...");
+			else if (!meshStatus.empty())
+				ImGui::TextWrapped("%s", meshStatus.c_str());
+		}
+
+		if (ImGui::CollapsingHeader("Profiler"))
+		{
+			renderProfiler();
+		}
+
 		ImGui::End();
 
+		ScopedTimer timer(profiler, passGUI);
+		profiler.beginGPU(passGUI);
+
 		// Render imgui into screen
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		profiler.endGPU(passGUI);
 	}
 }
 
+SceneState Renderer::getSceneState() const
+{
+	SceneState state;
+	state.fractal = fractal;
+	state.rendering = rendering;
+
+	for (int i = 0; i < 3; i++)
+	{
+		state.bgColor[i] = coloring.bgColor[i];
+		state.fractalColor[i] = coloring.fractalColor[i];
+		state.oTrapColor[i] = coloring.oTrapColor[i];
+		state.yTrapColor[i] = coloring.yTrapColor[i];
+	}
+
+	state.fractalType = fractalType;
+	state.fixedIterations = fixedIterations;
+
+	return state;
+}
+
+void Renderer::setSceneState(const SceneState& state)
+{
+	fractal = state.fractal;
+	rendering = state.rendering;
+
+	for (int i = 0; i < 3; i++)
+	{
+		coloring.bgColor[i] = state.bgColor[i];
+		coloring.fractalColor[i] = state.fractalColor[i];
+		coloring.oTrapColor[i] = state.oTrapColor[i];
+		coloring.yTrapColor[i] = state.yTrapColor[i];
+	}
+
+	fractalType = state.fractalType;
+	fixedIterations = state.fixedIterations;
+
+	updateComputeProgram();
+	guiChanged();
+}
+
+void Renderer::updateCameraPath(double frameTime)
+{
+	if (pathMode == pathRecording)
+	{
+		// frames are sampled at fixed timestep, independently of frame rate of the viewer
+		pathTime += frameTime;
+		while (pathTime >= pathTimestep)
+		{
+			cameraPath.addFrame(*mainCamera, getSceneState());
+			pathTime -= pathTimestep;
+		}
+	}
+	else if (pathMode == pathPlaying)
+	{
+		// previous played frame ends here
+		if (pathFrame > 0)
+			pathFrameTimes.push_back(float(frameTime * 1000.0));
+
+		if (pathFrame >= cameraPath.getFrameCount())
+		{
+			finishPathPlayback();
+			return;
+		}
+
+		const PathFrame& frame = cameraPath.getFrame(pathFrame++);
+		mainCamera->setPose(frame.position, frame.yaw, frame.pitch);
+
+		if (frame.stateChanged)
+			setSceneState(frame.state);
+	}
+}
+
+void Renderer::startPathPlayback()
+{
+	if (cameraPath.getFrameCount() == 0)
+		return;
+
+	pathMode = pathPlaying;
+	pathFrame = 0;
+	pathFrameTimes.clear();
+	pathReport.clear();
+}
+
+void Renderer::finishPathPlayback()
+{
+	pathMode = pathIdle;
+
+	PassStatistics statistics = computeStatistics(pathFrameTimes);
+
+	double totalTime = 0.0;
+	for (float time : pathFrameTimes)
+		totalTime += time;
+
+	char report[256];
+	snprintf(report, sizeof(report), "%d frames in %.2f s, frame time min %.3f ms, avg %.3f ms, p95 %.3f ms, p99 %.3f ms",
+		statistics.count, totalTime / 1000.0, statistics.min, statistics.avg, statistics.p95, statistics.p99);
+	pathReport = report;
+	std::cout << pathReport << std::endl;
+
+	std::ofstream file(pathReportFile, std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write " << pathReportFile << std::endl;
+		return;
+	}
+
+	file << "frame,frame_ms\n";
+	for (size_t i = 0; i < pathFrameTimes.size(); i++)
+		file << i << "," << pathFrameTimes[i] << "\n";
+}
+
+void Renderer::renderProfiler()
+{
+	ImGui::Text("Times in ms of last %d frames, GPU times are %d frames old.", profilerHistory, profilerFrames);
+
+	ImGui::Columns(6, "ProfilerColumns");
+	ImGui::Text("Pass"); ImGui::NextColumn();
+	ImGui::Text(""); ImGui::NextColumn();
+	ImGui::Text("Min"); ImGui::NextColumn();
+	ImGui::Text("Avg"); ImGui::NextColumn();
+	ImGui::Text("P95"); ImGui::NextColumn();
+	ImGui::Text("P99"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (int i = 0; i < profilerPasses; i++)
+	{
+		for (int gpu = 0; gpu < 2; gpu++)
+		{
+			PassStatistics statistics = profiler.getStatistics(ProfilerPass(i), gpu != 0);
+
+			// whole frame is measured only on CPU
+			if (gpu && statistics.count == 0)
+				continue;
+
+			ImGui::Text("%s", gpu ? "" : Profiler::getPassName(ProfilerPass(i))); ImGui::NextColumn();
+			ImGui::Text("%s", gpu ? "GPU" : "CPU"); ImGui::NextColumn();
+			ImGui::Text("%.3f", statistics.min); ImGui::NextColumn();
+			ImGui::Text("%.3f", statistics.avg); ImGui::NextColumn();
+			ImGui::Text("%.3f", statistics.p95); ImGui::NextColumn();
+			ImGui::Text("%.3f", statistics.p99); ImGui::NextColumn();
+		}
+	}
+
+	ImGui::Columns(1);
+
+	bool writingCSV = profiler.isWritingCSV();
+	if (ImGui::Checkbox("Write CSV", &writingCSV))
+	{
+		if (writingCSV)
+		{
+			if (!profiler.startCSV(profilerCSVPath))
+				std::cout << "Failed to open " << profilerCSVPath << std::endl;
+		}
+		else
+		{
+			profiler.stopCSV();
+		}
+	}
+	ImGui::SameLine(); HelpMarker("Writes CPU and GPU times of every frame to profiler.csv in working directory.");
+}
+
 void Renderer::HelpMarker(const char* desc)
 {
 	ImGui::TextDisabled("(?)");
@@ -521,36 +1220,55 @@ void Renderer::HelpMarker(const char* desc)
 	}
 }
 
-void Renderer::getUniformLocations()
-{
-	glUseProgram(computeProgram);
-	uniformLocations.origin = glGetUniformLocation(computeProgram, "Origin");
-	uniformLocations.viewMatrix = glGetUniformLocation(computeProgram, "ViewMatrix");
-	uniformLocations.vFov = glGetUniformLocation(computeProgram, "Vfov");
-	uniformLocations.fractalIter = glGetUniformLocation(computeProgram, "Iterations");
-	uniformLocations.fractalPower = glGetUniformLocation(computeProgram, "Power");
-	uniformLocations.maxSteps = glGetUniformLocation(computeProgram, "MaxMarchingSteps");
-	uniformLocations.detail = glGetUniformLocation(computeProgram, "MinDist");
-	uniformLocations.detailPower = glGetUniformLocation(computeProgram, "DetailPower");
-	uniformLocations.shadows = glGetUniformLocation(computeProgram, "Shadows");
-	uniformLocations.shadowSoftness = glGetUniformLocation(computeProgram, "ShadowSoftness");
-	uniformLocations.light = glGetUniformLocation(computeProgram, "Light");
-	uniformLocations.bgColor = glGetUniformLocation(computeProgram, "BgColor");
-	uniformLocations.fractalColor = glGetUniformLocation(computeProgram, "FractalColor");
-	uniformLocations.oTrapColor = glGetUniformLocation(computeProgram, "O_TrapColor");
-	uniformLocations.yTrapColor = glGetUniformLocation(computeProgram, "Y_TrapColor");
-	uniformLocations.subframeOffset = glGetUniformLocation(computeProgram, "SubframeOffset");
-	uniformLocations.subframeID = glGetUniformLocation(computeProgram, "SubframeID");
-}
-
 void Renderer::changeResolution()
 {
 	glfwSetWindowSize(window, resolution.x, resolution.y);
 	glViewport(0, 0, resolution.x, resolution.y);
-	glDeleteTextures(1, &frameBuffer);
-	glDeleteTextures(1, &accumulationBuffer);
+	deleteImageBuffers();
+	createImageBuffers();
+
+	// new textures are empty until the next dispatch
+	displayedScale = 1.0f;
+	displayedRenderSize = resolution;
+}
+
+void Renderer::createImageBuffers()
+{
 	frameBuffer = shaderManager.createTexture(resolution.x, resolution.y, 0, GL_WRITE_ONLY);
-	accumulationBuffer = shaderManager.createTexture(resolution.x, resolution.y, 1, GL_READ_WRITE);
+
+	glm::ivec2 tiles = (resolution + tileDimensions - 1) / tileDimensions;
+	coneBuffer = shaderManager.createTexture(tiles.x, tiles.y, 5, GL_READ_WRITE);
+
+	for (int i = 0; i < 2; i++)
+	{
+		accumulationBuffers[i] = shaderManager.createTexture(resolution.x, resolution.y, 1, GL_READ_WRITE);
+		depthBuffers[i] = shaderManager.createTexture(resolution.x, resolution.y, 2, GL_READ_WRITE);
+	}
+
+	adaptiveSampler.create(resolution);
+
+	currentBuffer = 0;
+	historyValid = false;
+	bindImageBuffers();
+}
+
+void Renderer::deleteImageBuffers()
+{
+	glDeleteTextures(1, &frameBuffer);
+	glDeleteTextures(1, &coneBuffer);
+	glDeleteTextures(2, accumulationBuffers);
+	glDeleteTextures(2, depthBuffers);
+	adaptiveSampler.destroy();
+}
+
+void Renderer::bindImageBuffers()
+{
+	int previousBuffer = 1 - currentBuffer;
+
+	glBindImageTexture(1, accumulationBuffers[currentBuffer], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+	glBindImageTexture(2, depthBuffers[currentBuffer], 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+	glBindImageTexture(3, accumulationBuffers[previousBuffer], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+	glBindImageTexture(4, depthBuffers[previousBuffer], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
 }
 
 void Renderer::setFullscreen()
@@ -12,33 +12,68 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <future>
 #include <iostream>
+#include <memory>
 #include "ShaderManager.h"
+#include "ParameterBuffer.h"
+#include "Profiler.h"
+#include "FrameCapture.h"
+#include "CameraPath.h"
 
 #include "helpers/RootDir.h"
 
 //#define CPU_RAYMARCH
 #include "Raymarcher.h"
+#include "TileRenderer.h"
+#include "BrickMap.h"
+#include "OccupancyOctree.h"
+#include "MeshExtractor.h"
+#include "AdaptiveSampler.h"
 
-const glm::ivec2 tileDimensions = glm::ivec2(16, 16);
-
-// max and min parameters
-const float renderingDetailMin = 2.0f;
-const float renderingDetailMax = 6.0f;
-const float detailPowerMin = 1.0f;
-const float detailPowerMax = 4.0f;
-const int maxStepsMin = 1;
-const int maxStepsMax = 1024;
-const float shadowSoftnessMin = 1.0f;
-const float shadowSoftnessMax = 256.0f;
-const float fractalPowerMin = 1.0f;
-const float fractalPowerMax = 16.0f;
-const int fractalIterationsMin = 1;
-const int fractalIterationsMax = 32;
+// max and min parameters, ranges of fractal and rendering parameters are in Raymarcher.h
 const float xAngleMax = 360.0f;
 const float xAngleMin = 0.0f;
 const float yAngleMax = 90.0f;
 const float yAngleMin = -90.0f;
+const float frameBudgetMin = 2.0f;
+const float frameBudgetMax = 100.0f;
+const int historyLengthMin = 1;
+const int historyLengthMax = 64;
+const float noiseThresholdMin = 0.0005f;
+const float noiseThresholdMax = 0.05f;
+
+// file with frame times written by profiler
+const char* const profilerCSVPath = "profiler.csv";
+
+// directory with captured frames and exported meshes
+const char* const captureDirectory = "capture";
+
+// numbers of mesh cells along the edge of the cube around the fractal selectable in GUI
+const int meshResolutions[] = { 256, 512, 1024 };
+
+// file with recorded camera path
+const char* const cameraPathFile = "camera.path";
+
+// file with frame times of the last played camera path
+const char* const pathReportFile = "camera_path_report.csv";
+
+// time of the flight between two preset views in the view tour in seconds
+const float viewTourSegmentTime = 4.0f;
+
+enum PathMode { pathIdle, pathRecording, pathPlaying };
+
+// largest pixel scale of frames rendered during camera motion, one ray per 8x8 pixels
+const float progressiveScaleMax = 8.0f;
+
+// pixel scale of motion frames until GPU time of the dispatch is measured
+const float progressiveScaleInitial = 2.0f;
+
+// GPU time of the dispatch kept during camera motion by default in milliseconds
+const float frameBudgetDefault = 16.6f;
+
+// number of samples taken over from the previous frame by reprojection by default
+const int historyLengthDefault = 8;
 
 
 class Renderer
@@ -81,17 +116,87 @@ private:
 	// shader program for drawing
 	GLuint quadProgram;
 
-	// shader program for compute shader
+	// shader program for compute shader, specialized for current variant
 	GLuint computeProgram;
 
+	// program marching one cone per tile before computeProgram, 0 if cone marching is disabled
+	GLuint conePrepassProgram;
+
+	// indicates whether rays start from depth of the cone of their tile
+	bool coneMarching;
+
+	// programs of adaptive sampling, compaction of noisy pixels and sampling of the work list, 0 if it is disabled
+	GLuint compactProgram;
+	GLuint listProgram;
+
+	// indicates whether subframes after adaptiveStartSubframes sample only pixels that are still noisy
+	bool adaptiveSampling;
+
+	// standard error of mean luminance below which pixels are not sampled anymore
+	float noiseThreshold;
+
+	// moments of samples and work list of noisy pixels
+	AdaptiveSampler adaptiveSampler;
+
+	// compute shader source path
+	fs::path computeShaderPath;
+
+	// type of rendered fractal, shader is compiled for one type, only Mandelbulb is offered in GUI,
+	// distance estimations of Sierpinski and Menger are not distances to their surfaces yet
+	int fractalType;
+
+	// indicates whether number of iterations is compiled into the shader
+	bool fixedIterations;
+
 	// VAO for quadProgram
 	GLuint vao;
 
 	// quad texture that is rendered to screen
 	GLuint frameBuffer;
 
-	// texture in which color values from all subframes are accumulated
-	GLuint accumulationBuffer;
+	// textures in which color values from all subframes are accumulated and distances of hits,
+	// one pair is written by current frame, the other holds the previous frame for reprojection
+	GLuint accumulationBuffers[2];
+	GLuint depthBuffers[2];
+
+	// index of the pair of buffers written by current frame
+	int currentBuffer;
+
+	// depth and marching steps of the cone of every tile
+	GLuint coneBuffer;
+
+	// index of brick map resolution in GUI, 0 if rays march exact distance estimation only
+	int brickMapMode;
+
+	// brick map of the fractal, nullptr until the first map is baked
+	std::unique_ptr<BrickMap> brickMap;
+
+	// brick map baked by a background thread, fractal is rendered without brick map meanwhile
+	std::future<std::unique_ptr<BrickMap>> brickMapBake;
+
+	// indicates whether brickMap matches current fractal and compute program marches it
+	bool useBrickMap;
+
+	// 3D textures with index, corners and atlas of brickMap
+	GLuint brickMapTextures[3];
+
+	// index of occupancy octree resolution in GUI, 0 if rays do not skip empty space
+	int octreeMode;
+
+	// occupancy octree of the fractal, nullptr until the first octree is built
+	std::unique_ptr<OccupancyOctree> octree;
+
+	// octree built by a background thread, fractal is rendered without octree meanwhile
+	std::future<std::unique_ptr<OccupancyOctree>> octreeBuild;
+
+	// indicates whether octree matches current fractal and compute program skips its empty nodes
+	bool useOctree;
+
+	// 3D texture with levels of octree in its mipmaps
+	GLuint octreeTexture;
+
+	// indicates whether rays are marched relative to the camera and mandelbulb is iterated in double-float
+	bool deepZoom;
 
 	// indicates whether values in GUI were changed and fractal needs to be re-rendered
 	bool GUIchanged;
@@ -105,38 +210,111 @@ private:
 	// stores window position when switching to fullscreen
 	glm::ivec2 windowPos;
 
-	struct UniformLocations
+	// worker threads of the CPU raymarcher, created with the first CPU rendered frame
+	std::unique_ptr<ThreadPool> threadPool;
+
+	// uniform buffer with parameters of compute program
+	ParameterBuffer parameterBuffer;
+
+	// parameters uploaded for the last subframe
+	ShaderParameters parameters;
+
+	// CPU and GPU times of the passes of the frame
+	Profiler profiler;
+
+	// saves drawn frames to files
+	FrameCapture frameCapture;
+
+	// indicates whether every drawn frame is captured
+	bool recording;
+
+	// indicates whether the next drawn frame is captured
+	bool saveFrame;
+
+	// index of captured image format in GUI
+	int captureFormat;
+
+	// index of mesh resolution in GUI
+	int meshResolutionMode;
+
+	// number of the next exported mesh
+	int meshNumber;
+
+	// mesh extracted in background, result is the message shown in GUI
+	std::future<std::string> meshExport;
+
+	// result of the last mesh export shown in GUI
+	std::string meshStatus;
+
+	// camera path that is recorded or played
+	CameraPath cameraPath;
+
+	PathMode pathMode;
+
+	// index of the next played frame of the path
+	size_t pathFrame;
+
+	// recorded time not covered by path frames yet
+	double pathTime;
+
+	// time of the last drawn frame
+	double lastFrameTime;
+
+	// durations of played frames in milliseconds
+	std::vector<float> pathFrameTimes;
+
+	// summary of the last played path shown in GUI
+	std::string pathReport;
+
+	// indicates whether frames are rendered coarse during camera motion
+	bool progressive;
+
+	// GPU time of the dispatch which progressive rendering keeps during camera motion in milliseconds
+	float frameBudget;
+
+	// pixel scale of the last frame rendered during motion
+	float progressiveScale;
+
+	// smoothed GPU time of marching one ray in milliseconds, 0 until it is measured
+	double rayCost;
+
+	// frame of the last GPU time included in rayCost
+	uint64_t rayCostFrame;
+
+	typedef struct dispatchRecord
 	{
-		GLuint origin;
-		GLuint viewMatrix;
-		GLuint vFov;
-		GLuint fractalPower;
-		GLuint fractalIter;
-		GLuint maxSteps;
-		GLuint detail;
-		GLuint detailPower;
-		GLuint shadows;
-		GLuint shadowSoftness;
-		GLuint bgColor;
-		GLuint fractalColor;
-		GLuint oTrapColor;
-		GLuint yTrapColor;
-		GLuint subframeOffset;
-		GLuint subframeID;
-		GLuint light;
-	} uniformLocations;
+		uint64_t frameNumber;
+		double rays;
+	} DispatchRecord;
+
+	// number of rays dispatched in the frames whose GPU times are not collected by profiler yet
+	DispatchRecord dispatchRecords[profilerFrames];
+
+	// pixel scale and render size of the image in frameBuffer
+	float displayedScale;
+	glm::ivec2 displayedRenderSize;
+
+	// indicates whether samples of the previous frame are reprojected during camera motion
+	bool reprojection;
+
+	// largest number of samples a pixel takes over from the previous frame
+	int historyLength;
+
+	// indicates whether buffers of the previous frame hold full resolution image of the current scene
+	bool historyValid;
+
+	// camera of the previous frame, world to camera space
+	glm::mat4 previousView;
+	glm::vec3 previousOrigin;
+
+	// number of reprojected frames since the camera started moving, selects subframe offset of the next one
+	int reprojectedFrames;
 
 	Fractal fractal;
 
 	Rendering rendering;
 
-	struct Coloring
-	{
-		float bgColor[3];
-		float fractalColor[3];
-		float oTrapColor[3];
-		float yTrapColor[3];
-	} coloring;
+	Coloring coloring;
 
 	/**
 	 * @brief Creates window and OpenGL context
@@ -149,15 +327,98 @@ private:
 	 */
 	void renderGUI();
 
+	/**
+	 * @brief Returns parameters of the scene set in GUI
+	 */
+	SceneState getSceneState() const;
+
+	/**
+	 * @brief Sets parameters of the scene, program variant is switched if needed
+	 */
+	void setSceneState(const SceneState& state);
+
+	/**
+	 * @brief Records current frame or sets camera and scene of the next played frame
+	 * Path frames are recorded at fixed timestep and every drawn frame plays one path frame,
+	 * so playback does not depend on frame rate.
+	 * @param frameTime Time since the previous frame in seconds
+	 */
+	void updateCameraPath(double frameTime);
+
+	/**
+	 * @brief Updates GPU time of one ray from the last dispatch measured by profiler
+	 * GPU times are available a few frames later, rays dispatched in those frames are remembered in dispatchRecords.
+	 */
+	void updateRayCost();
+
+	/**
+	 * @brief Returns pixel scale of a frame rendered during motion
+	 * Number of rays is chosen so their measured GPU time fits the frame budget.
+	 * Captured and played frames are always rendered in full resolution.
+	 */
+	float getProgressiveScale() const;
+
+	/**
+	 * @brief Starts playing of loaded path
+	 */
+	void startPathPlayback();
+
+	/**
+	 * @brief Stops playing of the path and writes frame time report
+	 */
+	void finishPathPlayback();
+
+	/**
+	 * @brief Draws statistics of profiled passes
+	 */
+	void renderProfiler();
+
 	/**
 	 * @brief Helper to display a little (?) mark which shows a tooltip when hovered. 
 	 */
 	void HelpMarker(const char* desc);
 
 	/**
-	 * @brief Gets locations of all uniforms and stores them in uniformLocations structure
+	 * @brief Gathers fractal, rendering, coloring and camera parameters of compute program
+	 * @return Parameters with zero subframe offset and ID
+	 */
+	ShaderParameters getShaderParameters() const;
+
+	/**
+	 * @brief Switches to compute program specialized for current parameters
+	 * Parameters do not have to be set again, all variants share the uniform buffer.
+	 * @return TRUE if program is available, else FALSE
+	 */
+	bool updateComputeProgram();
+
+	/**
+	 * @brief Starts baking of brick map for current fractal and switches to the map once it is baked
+	 * Map of previous parameters is not used, so changed fractal is rendered exactly until the new map is ready.
+	 */
+	void updateBrickMap();
+
+	/**
+	 * @brief Starts building of occupancy octree for current fractal and switches to it once it is built
+	 * Octree of previous parameters is not used, it could skip the surface of changed fractal.
+	 */
+	void updateOccupancyOctree();
+
+	/**
+	 * @brief Starts extraction of the surface of current fractal to a new mesh file in capture directory
+	 */
+	void startMeshExport();
+
+	/**
+	 * @brief Creates frame, accumulation, depth and moment textures and the work list in current resolution
+	 */
+	void createImageBuffers();
+
+	void deleteImageBuffers();
+
+	/**
+	 * @brief Binds buffers of current frame and the previous frame to image units of compute program
 	 */
-	void getUniformLocations();
+	void bindImageBuffers();
 
 	/**
 	 * @brief Changes resolution of a window to the value that is stored in resolution class field 
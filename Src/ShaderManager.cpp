@@ -9,11 +9,46 @@
 
 #include "ShaderManager.h"
 
-ShaderManager::ShaderManager() {}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-GLuint ShaderManager::createShader(fs::path shaderFile, GLenum shaderType)
+// identifies cached program binary files, changed whenever their layout changes
+const char programCacheMagic[8] = { 'F', 'R', 'A', 'C', 'P', 'R', 'G', '1' };
+
+struct ProgramCacheHeader
+{
+	char magic[8];
+	uint64_t key;
+	uint64_t checksum;		// hash of the binary, detects truncated or corrupted files
+	uint32_t format;
+	uint32_t size;
+};
+
+/**
+ * @brief Adds string to FNV-1a hash
+ */
+static uint64_t hashString(const std::string& text, uint64_t hash = 0xCBF29CE484222325ull)
+{
+	// terminating zero separates consecutive strings
+	for (size_t i = 0; i <= text.size(); i++)
+		hash = (hash ^ uint8_t(text.c_str()[i])) * 0x100000001B3ull;
+
+	return hash;
+}
+
+static uint64_t hashBytes(const std::vector<char>& data)
+{
+	return hashString(std::string(data.begin(), data.end()));
+}
+
+ShaderManager::ShaderManager()
+{
+	cacheDir = getCacheDirectory();
+}
+
+bool ShaderManager::readShaderFile(fs::path shaderFile, std::string& shaderCode)
 {
-	std::string shaderCode;
 	std::ifstream file;
 
 	// fstream object can throw exceptions
@@ -35,9 +70,14 @@ GLuint ShaderManager::createShader(fs::path shaderFile, GLenum shaderType)
 	catch (std::ifstream::failure e)
 	{
 		std::cout << "Failed to read shader file!" << std::endl;
-		return 0;
+		return false;
 	}
 
+	return true;
+}
+
+GLuint ShaderManager::compileShader(const std::string& shaderCode, GLenum shaderType)
+{
 	const GLchar* code = shaderCode.c_str();
 
 	// create and compile shader
@@ -49,6 +89,16 @@ GLuint ShaderManager::createShader(fs::path shaderFile, GLenum shaderType)
 	return shader;
 }
 
+GLuint ShaderManager::createShader(fs::path shaderFile, GLenum shaderType)
+{
+	std::string shaderCode;
+
+	if (!readShaderFile(shaderFile, shaderCode))
+		return 0;
+
+	return compileShader(shaderCode, shaderType);
+}
+
 std::string ShaderManager::shaderTypeToString(GLenum shaderType)
 {
 	switch (shaderType)
@@ -148,18 +198,40 @@ GLuint ShaderManager::createTexture(GLint textureWidth, GLint textureHeight, GLi
 }
 
 
-GLuint ShaderManager::createComputeProgram(fs::path computeFile)
+GLuint ShaderManager::createComputeProgram(fs::path computeFile, const std::string& defines)
 {
-	GLuint computeShader = createShader(computeFile, GL_COMPUTE_SHADER);
+	std::string shaderCode;
+
+	if (!readShaderFile(computeFile, shaderCode))
+		return 0;
+
+	// defines have to follow #version directive, #line keeps line numbers of compilation errors
+	if (!defines.empty())
+	{
+		size_t versionEnd = shaderCode.find('\n', shaderCode.find("#version"));
+		if (versionEnd != std::string::npos)
+			shaderCode.insert(versionEnd + 1, defines + "\n#line 2\n");
+	}
+
+	uint64_t key = programCacheKey(shaderCode, defines);
+
+	GLuint shaderProgram = loadProgramBinary(key);
+	if (shaderProgram != 0)
+		return shaderProgram;
+
+	GLuint computeShader = compileShader(shaderCode, GL_COMPUTE_SHADER);
 
 	if (computeShader == 0)
 		return 0;
 
 	// create and link shader program
-	GLuint shaderProgram = glCreateProgram();
+	shaderProgram = glCreateProgram();
+	glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(shaderProgram, computeShader);
 	glLinkProgram(shaderProgram);
-	checkProgramLinking(shaderProgram);
+
+	if (checkProgramLinking(shaderProgram))
+		saveProgramBinary(shaderProgram, key);
 
 	// shader program is created, shader is no longer needed
 	glDeleteShader(computeShader);
@@ -167,6 +239,211 @@ GLuint ShaderManager::createComputeProgram(fs::path computeFile)
 	return shaderProgram;
 }
 
+GLuint ShaderManager::getComputeProgram(fs::path computeFile, const ShaderVariant& variant)
+{
+	std::string defines = variantDefines(variant);
+	std::string key = computeFile.u8string() + "\n" + defines;
+
+	for (auto it = linkedPrograms.begin(); it != linkedPrograms.end(); ++it)
+	{
+		if (it->key == key)
+		{
+			linkedPrograms.splice(linkedPrograms.begin(), linkedPrograms, it);
+			return it->program;
+		}
+	}
+
+	GLuint program = createComputeProgram(computeFile, defines);
+	if (program == 0)
+		return 0;
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	linkedPrograms.push_front(LinkedProgram{ key, program });
+
+	if (linkedPrograms.size() > programCacheCapacity)
+	{
+		glDeleteProgram(linkedPrograms.back().program);
+		linkedPrograms.pop_back();
+	}
+
+	return program;
+}
+
+std::string ShaderManager::variantDefines(const ShaderVariant& variant)
+{
+	std::stringstream defines;
+
+	defines << "#define FRACTAL_TYPE " << variant.fractalType << "\n";
+	defines << "#define SHADOWS " << (variant.shadows ? 1 : 0) << "\n";
+	defines << "#define AMBIENT_OCCLUSION " << (variant.ambientOcclusion ? 1 : 0) << "\n";
+	defines << "#define CONE_PASS " << variant.conePass << "\n";
+	defines << "#define BRICK_MAP " << (variant.brickMap ? 1 : 0) << "\n";
+	defines << "#define OCCUPANCY_OCTREE " << (variant.occupancyOctree ? 1 : 0) << "\n";
+	defines << "#define DEEP_ZOOM " << (variant.deepZoom ? 1 : 0) << "\n";
+	defines << "#define ADAPTIVE_PASS " << variant.adaptivePass;
+
+	if (variant.fixedIterations > 0)
+		defines << "\n#define FIXED_ITERATIONS " << variant.fixedIterations;
+
+	return defines.str();
+}
+
+fs::path ShaderManager::getCacheDirectory()
+{
+	fs::path directory;
+
+#if defined(_WIN32)
+	const char* localAppData = std::getenv("LOCALAPPDATA");
+	if (localAppData == nullptr)
+		return fs::path();
+	directory = fs::u8path(localAppData);
+#elif defined(__APPLE__)
+	const char* home = std::getenv("HOME");
+	if (home == nullptr)
+		return fs::path();
+	directory = fs::u8path(home) / "Library" / "Caches";
+#else
+	const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+	const char* home = std::getenv("HOME");
+	if (xdgCache != nullptr && xdgCache[0] != '\0')
+		directory = fs::u8path(xdgCache);
+	else if (home != nullptr)
+		directory = fs::u8path(home) / ".cache";
+	else
+		return fs::path();
+#endif
+
+	directory /= fs::path("3D_Fractals") / "programs";
+
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if (error)
+		return fs::path();
+
+	return directory;
+}
+
+uint64_t ShaderManager::programCacheKey(const std::string& shaderCode, const std::string& defines)
+{
+	uint64_t key = hashString(shaderCode);
+	key = hashString(defines, key);
+
+	// binary is valid only for the driver that created it
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	for (GLenum name : driverStrings)
+	{
+		const GLubyte* value = glGetString(name);
+		key = hashString(value != nullptr ? (const char*)value : "", key);
+	}
+
+	return key;
+}
+
+GLuint ShaderManager::loadProgramBinary(uint64_t key)
+{
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	if (cacheDir.empty() || formats == 0)
+		return 0;
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	fs::path path = cacheDir / name;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return 0;
+
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+
+	bool valid = bool(file.read((char*)&header, sizeof(header))) &&
+		memcmp(header.magic, programCacheMagic, sizeof(header.magic)) == 0 && header.key == key;
+
+	if (valid)
+	{
+		binary.resize(header.size);
+		valid = bool(file.read(binary.data(), binary.size())) && hashBytes(binary) == header.checksum;
+	}
+	file.close();
+
+	GLuint program = 0;
+	GLint success = 0;
+
+	if (valid)
+	{
+		program = glCreateProgram();
+		glProgramBinary(program, header.format, binary.data(), GLsizei(binary.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+	}
+
+	// driver can reject binary even if its strings did not change, such binary is removed and program is compiled again
+	if (!success)
+	{
+		if (program != 0)
+			glDeleteProgram(program);
+
+		std::error_code error;
+		fs::remove(path, error);
+
+		return 0;
+	}
+
+	std::cout << "Compute shader program loaded from cache" << std::endl;
+
+	return program;
+}
+
+void ShaderManager::saveProgramBinary(GLuint program, uint64_t key)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (cacheDir.empty() || length <= 0)
+		return;
+
+	ProgramCacheHeader header;
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+
+	glGetProgramBinary(program, length, &written, &format, binary.data());
+	binary.resize(written);
+
+	memcpy(header.magic, programCacheMagic, sizeof(header.magic));
+	header.key = key;
+	header.checksum = hashBytes(binary);
+	header.format = format;
+	header.size = uint32_t(binary.size());
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	fs::path path = cacheDir / name;
+	fs::path temporaryPath = path;
+	temporaryPath += ".tmp";
+
+	// binary is written to a temporary file and renamed, so other instances never read a partial file
+	std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), binary.size());
+	file.close();
+
+	std::error_code error;
+	if (file.good())
+		fs::rename(temporaryPath, path, error);
+
+	if (!file.good() || error)
+		fs::remove(temporaryPath, error);
+}
+
 void ShaderManager::setUniformVec2(GLuint uniformLocation, glm::vec2 value)
 {
 	glUniform2fv(uniformLocation, 1, glm::value_ptr(value));
@@ -209,7 +486,7 @@ void ShaderManager::checkShaderCompilation(GLuint shader, std::string type)
 	}
 }
 
-void ShaderManager::checkProgramLinking(GLuint program)
+bool ShaderManager::checkProgramLinking(GLuint program)
 {
 	char infoLog[512];
 	int success = 0;
@@ -223,4 +500,6 @@ void ShaderManager::checkProgramLinking(GLuint program)
 		glGetProgramInfoLog(program, 512, NULL, infoLog);
 		std::cout << "Shader program linking failed!\n" << infoLog << std::endl;
 	}
+
+	return success != 0;
 }
\ No newline at end of file
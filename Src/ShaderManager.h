@@ -21,14 +21,43 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <list>
 #include <sstream>
 #include <vector>
 #include <experimental/filesystem>
 
 namespace fs = std::experimental::filesystem;
 
+enum FractalType { fractalMandelbulb, fractalSierpinski, fractalMenger };
+
+// cone marching pass of compute shader, values match CONE_ macros of the shader
+enum ConePass { coneNone, conePrepass, coneStart };
+
+// adaptive sampling pass of compute shader, values match ADAPTIVE_ macros of the shader
+enum AdaptivePass { adaptiveNone, adaptiveFull, adaptiveCompact, adaptiveList };
+
+// maximal number of linked compute shader variants kept in memory
+const size_t programCacheCapacity = 8;
+
+/**
+ * @brief Features of compute shader that are resolved at compile time
+ */
+typedef struct shaderVariant
+{
+	int fractalType;
+	bool shadows;
+	bool ambientOcclusion;
+	int fixedIterations;		// number of fractal iterations compiled into shader, 0 if it is given by uniform
+	int conePass;				// ConePass, prepass marches cones of tiles, main pass starts rays from their depth
+	bool brickMap;				// rays march distances cached in brick map far from the surface
+	bool occupancyOctree;		// rays skip empty nodes of occupancy octree
+	bool deepZoom;				// rays are marched relative to the camera and mandelbulb is iterated in double-float
+	int adaptivePass;			// AdaptivePass, full pass sums moments of samples, list pass samples pixels of the work list
+} ShaderVariant;
+
 class ShaderManager
 {
 public:
@@ -56,10 +85,26 @@ public:
 
 	/**
 	 * @brief Creates copmpute shader program
+	 * Linked program is stored in the program binary cache and loaded from it on the next start,
+	 * cached binary is used only if shader source, defines and driver are the same.
 	 * @param computeFile Path to compute shader source file
+	 * @param defines Lines inserted after #version directive of the shader
 	 * @return ID of created shader program or 0 if something went wrong
 	 */
-	GLuint createComputeProgram(fs::path computeFile);
+	GLuint createComputeProgram(fs::path computeFile, const std::string& defines = "");
+
+	/**
+	 * @brief Returns compute shader program specialized for a given variant
+	 * Recently used variants are kept linked, so switching between them does not compile anything.
+	 * Program of the least recently used variant is deleted when there are too many variants.
+	 * @return ID of the program or 0 if something went wrong
+	 */
+	GLuint getComputeProgram(fs::path computeFile, const ShaderVariant& variant);
+
+	/**
+	 * @brief Returns #define directives of a given variant
+	 */
+	static std::string variantDefines(const ShaderVariant& variant);
 
 	/**
 	 * @brief Sets uniform of a given location
@@ -77,6 +122,31 @@ public:
 	void setUniformFloat(GLuint uniformLocation, GLfloat value);
 
 private:
+	// directory with cached program binaries, empty if the cache is not available
+	fs::path cacheDir;
+
+	struct LinkedProgram
+	{
+		std::string key;		// path of the source file and defines
+		GLuint program;
+	};
+
+	// linked shader variants, most recently used first
+	std::list<LinkedProgram> linkedPrograms;
+
+	/**
+	 * @brief Reads whole shader source file
+	 * @param code Content of the file
+	 * @return TRUE if file was read, else FALSE
+	 */
+	bool readShaderFile(fs::path shaderFile, std::string& code);
+
+	/**
+	 * @brief Compiles shader from source code
+	 * @return ID of created shader or 0 if something went wrong
+	 */
+	GLuint compileShader(const std::string& shaderCode, GLenum shaderType);
+
 	/**
 	 * @brief Loads shader from file and compiles it
 	 * @param shaderFile Path to shader source file
@@ -102,7 +172,30 @@ private:
 	 * @brief Checks if there were any errors during shader program linking
 	 * @param program	ShaderManager program whose linking errors to check
 	 */
-	void checkProgramLinking(GLuint program);
+	bool checkProgramLinking(GLuint program);
+
+	/**
+	 * @brief Returns per-user cache directory of the application, creates it if it does not exist
+	 * @return Path of the directory or empty path if it cannot be created
+	 */
+	static fs::path getCacheDirectory();
+
+	/**
+	 * @brief Returns key of the cached program binary
+	 * Key is a hash of the source code, defines and the driver, so the binary is not used after any of them changes.
+	 */
+	static uint64_t programCacheKey(const std::string& shaderCode, const std::string& defines);
+
+	/**
+	 * @brief Creates program from cached binary
+	 * @return ID of created program or 0 if there is no valid binary for the key
+	 */
+	GLuint loadProgramBinary(uint64_t key);
+
+	/**
+	 * @brief Stores binary of linked program to the cache
+	 */
+	void saveProgramBinary(GLuint program, uint64_t key);
 };
 
 #endif // !SHADER_H
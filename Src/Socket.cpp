@@ -0,0 +1,289 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Socket.cpp
+ *
+ */
+
+#include "Socket.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+const SocketHandle invalidSocket = SocketHandle(INVALID_SOCKET);
+const int sendFlags = 0;
+
+#define closeSocket closesocket
+#define pollSockets WSAPoll
+
+// Winsock has to be initialized before the first socket is created
+struct WinsockInit
+{
+	WinsockInit()
+	{
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+	}
+
+	~WinsockInit()
+	{
+		WSACleanup();
+	}
+};
+
+static void initSockets()
+{
+	static WinsockInit init;
+}
+
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+const SocketHandle invalidSocket = -1;
+
+// broken connection is reported as error instead of killing the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+#define closeSocket ::close
+#define pollSockets ::poll
+
+static void initSockets()
+{
+}
+
+#endif
+
+Socket::Socket()
+{
+	handle = invalidSocket;
+}
+
+Socket::Socket(SocketHandle handle)
+{
+	this->handle = handle;
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+Socket::Socket(Socket&& other)
+{
+	handle = other.handle;
+	other.handle = invalidSocket;
+}
+
+Socket& Socket::operator=(Socket&& other)
+{
+	if (this != &other)
+	{
+		close();
+		handle = other.handle;
+		other.handle = invalidSocket;
+	}
+
+	return *this;
+}
+
+bool Socket::listen(uint16_t port, bool localOnly)
+{
+	initSockets();
+	close();
+
+	handle = SocketHandle(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+	if (handle == invalidSocket)
+		return false;
+
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(localOnly ? INADDR_LOOPBACK : INADDR_ANY);
+	address.sin_port = htons(port);
+
+	if (::bind(handle, (const sockaddr*)&address, sizeof(address)) != 0 || ::listen(handle, SOMAXCONN) != 0)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+Socket Socket::accept()
+{
+	SocketHandle client = SocketHandle(::accept(handle, nullptr, nullptr));
+	if (client == invalidSocket)
+		return Socket();
+
+	// results are sent as soon as they are ready
+	int noDelay = 1;
+	setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+	return Socket(client);
+}
+
+bool Socket::connect(const std::string& address)
+{
+	initSockets();
+	close();
+
+	size_t colon = address.find_last_of(':');
+	if (colon == std::string::npos)
+		return false;
+
+	std::string host = address.substr(0, colon);
+	std::string port = address.substr(colon + 1);
+
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	addrinfo* results = nullptr;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0)
+		return false;
+
+	for (addrinfo* result = results; result != nullptr; result = result->ai_next)
+	{
+		handle = SocketHandle(::socket(result->ai_family, result->ai_socktype, result->ai_protocol));
+		if (handle == invalidSocket)
+			continue;
+
+		if (::connect(handle, result->ai_addr, int(result->ai_addrlen)) == 0)
+			break;
+
+		close();
+	}
+	freeaddrinfo(results);
+
+	if (handle == invalidSocket)
+		return false;
+
+	int noDelay = 1;
+	setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+	return true;
+}
+
+bool Socket::send(const void* data, size_t size)
+{
+	const char* bytes = (const char*)data;
+
+	while (size > 0)
+	{
+		int chunk = int(size < (1u << 30) ? size : (1u << 30));
+		int sent = int(::send(handle, bytes, chunk, sendFlags));
+		if (sent <= 0)
+			return false;
+
+		bytes += sent;
+		size -= size_t(sent);
+	}
+
+	return true;
+}
+
+bool Socket::receive(void* data, size_t size)
+{
+	char* bytes = (char*)data;
+
+	while (size > 0)
+	{
+		int chunk = int(size < (1u << 30) ? size : (1u << 30));
+		int received = int(::recv(handle, bytes, chunk, 0));
+		if (received <= 0)
+			return false;
+
+		bytes += received;
+		size -= size_t(received);
+	}
+
+	return true;
+}
+
+bool Socket::setReceiveTimeout(int timeout)
+{
+#ifdef _WIN32
+	DWORD value = DWORD(timeout);
+#else
+	timeval value;
+	value.tv_sec = timeout / 1000;
+	value.tv_usec = (timeout % 1000) * 1000;
+#endif
+
+	return setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&value, sizeof(value)) == 0;
+}
+
+uint16_t Socket::getPort() const
+{
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+
+	if (getsockname(handle, (sockaddr*)&address, &length) != 0)
+		return 0;
+
+	return ntohs(address.sin_port);
+}
+
+bool Socket::isValid() const
+{
+	return handle != invalidSocket;
+}
+
+SocketHandle Socket::getHandle() const
+{
+	return handle;
+}
+
+void Socket::close()
+{
+	if (handle != invalidSocket)
+		closeSocket(handle);
+
+	handle = invalidSocket;
+}
+
+std::vector<size_t> Socket::waitReadable(const std::vector<const Socket*>& sockets, int timeout)
+{
+	std::vector<pollfd> descriptors(sockets.size());
+	for (size_t i = 0; i < sockets.size(); i++)
+	{
+		descriptors[i].fd = sockets[i]->handle;
+		descriptors[i].events = POLLIN;
+		descriptors[i].revents = 0;
+	}
+
+	std::vector<size_t> ready;
+	if (pollSockets(descriptors.data(), descriptors.size(), timeout) <= 0)
+		return ready;
+
+	// closed connection is reported as readable, following receive fails
+	for (size_t i = 0; i < descriptors.size(); i++)
+		if (descriptors[i].revents != 0)
+			ready.push_back(i);
+
+	return ready;
+}
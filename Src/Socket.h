@@ -0,0 +1,104 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	Socket.h
+ *
+ */
+
+#pragma once
+
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+typedef uintptr_t SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+/**
+ * @brief Blocking TCP socket
+ */
+class Socket
+{
+public:
+	Socket();
+	~Socket();
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+
+	Socket(Socket&& other);
+	Socket& operator=(Socket&& other);
+
+	/**
+	 * @brief Starts listening for connections
+	 * @param port Port number, 0 lets the system choose a free port
+	 * @param localOnly Listens only on the loopback interface, so only processes of this machine can connect
+	 * @return TRUE on success, else FALSE
+	 */
+	bool listen(uint16_t port, bool localOnly = false);
+
+	/**
+	 * @brief Waits for a new connection on a listening socket
+	 * @return Connected socket, invalid socket on error
+	 */
+	Socket accept();
+
+	/**
+	 * @brief Connects to a host given as host:port
+	 * @return TRUE on success, else FALSE
+	 */
+	bool connect(const std::string& address);
+
+	/**
+	 * @brief Sends all bytes, blocks until they are sent
+	 * @return TRUE on success, else FALSE
+	 */
+	bool send(const void* data, size_t size);
+
+	/**
+	 * @brief Receives exactly size bytes, blocks until they are received
+	 * @return TRUE on success, FALSE on error or when the connection was closed
+	 */
+	bool receive(void* data, size_t size);
+
+	/**
+	 * @brief Limits how long receive waits for more data, receive fails when the limit is exceeded
+	 * @param timeout Timeout in milliseconds, 0 waits without limit
+	 * @return TRUE on success, else FALSE
+	 */
+	bool setReceiveTimeout(int timeout);
+
+	/**
+	 * @brief Returns port on which the socket listens or to which it is bound
+	 */
+	uint16_t getPort() const;
+
+	bool isValid() const;
+
+	SocketHandle getHandle() const;
+
+	void close();
+
+	/**
+	 * @brief Waits until some of the sockets has data to read or a connection to accept
+	 * @param timeout Timeout in milliseconds, negative waits without limit
+	 * @return Indices of ready sockets, empty on timeout
+	 */
+	static std::vector<size_t> waitReadable(const std::vector<const Socket*>& sockets, int timeout);
+
+private:
+	explicit Socket(SocketHandle handle);
+
+	SocketHandle handle;
+};
+
+#endif // !SOCKET_H
@@ -0,0 +1,178 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ThreadPool.cpp
+ *
+ */
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+
+	// hardware_concurrency can return 0 if the value is not computable
+	if (threadCount == 0)
+		threadCount = 1;
+
+	nextQueue = 0;
+	queuedTasks = 0;
+	pendingTasks = 0;
+	stop = false;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		stop = true;
+	}
+	wakeCondition.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	unsigned int index = nextQueue.fetch_add(1) % queues.size();
+
+	pendingTasks++;
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+
+	{
+		// counter is changed under the lock, so that sleeping worker can't miss it
+		std::lock_guard<std::mutex> lock(stateMutex);
+		queuedTasks++;
+	}
+	wakeCondition.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::function<void()> task;
+
+	// help workers while there are tasks in queues
+	while (pendingTasks > 0)
+	{
+		if (stealTask((unsigned int)queues.size(), task))
+		{
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(stateMutex);
+		doneCondition.wait(lock, [this] { return pendingTasks == 0 || queuedTasks > 0; });
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		exception = taskException;
+		taskException = nullptr;
+	}
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return (unsigned int)workers.size();
+}
+
+bool ThreadPool::popTask(unsigned int queueIndex, std::function<void()>& task)
+{
+	WorkQueue& queue = *queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.tasks.empty())
+		return false;
+
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	queuedTasks--;
+
+	return true;
+}
+
+bool ThreadPool::stealTask(unsigned int thiefIndex, std::function<void()>& task)
+{
+	unsigned int queueCount = (unsigned int)queues.size();
+
+	// start with the neighbour, so that thieves don't all go after the same queue
+	for (unsigned int i = 1; i <= queueCount; i++)
+	{
+		unsigned int index = (thiefIndex + i) % queueCount;
+		if (index == thiefIndex)
+			continue;
+
+		WorkQueue& queue = *queues[index];
+		std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+
+		if (!lock.owns_lock() || queue.tasks.empty())
+			continue;
+
+		task = std::move(queue.tasks.front());
+		queue.tasks.pop_front();
+		queuedTasks--;
+
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::runTask(std::function<void()>& task)
+{
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		if (!taskException)
+			taskException = std::current_exception();
+	}
+
+	task = nullptr;
+
+	if (--pendingTasks == 0)
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		doneCondition.notify_all();
+	}
+}
+
+void ThreadPool::workerLoop(unsigned int index)
+{
+	std::function<void()> task;
+
+	while (true)
+	{
+		if (popTask(index, task) || stealTask(index, task))
+		{
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(stateMutex);
+		wakeCondition.wait(lock, [this] { return stop || queuedTasks > 0; });
+
+		if (stop && queuedTasks == 0)
+			return;
+	}
+}
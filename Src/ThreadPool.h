@@ -0,0 +1,113 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	ThreadPool.h
+ *
+ */
+
+#pragma once
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool of worker threads with work stealing
+ * Every worker owns a queue of tasks. Worker takes tasks from the back of its own queue
+ * and when the queue is empty, it steals tasks from the front of the queues of other workers.
+ * This keeps all workers busy even if the cost of the tasks differs a lot.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @brief Creates pool and starts worker threads
+	 * @param threadCount Number of worker threads, 0 means one thread per hardware thread
+	 */
+	explicit ThreadPool(unsigned int threadCount = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Adds task to the queue of one of the workers
+	 * @param task Task to be executed
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 * @brief Blocks until all submitted tasks are finished, calling thread helps with the tasks
+	 * Rethrows first exception thrown by any of the tasks.
+	 */
+	void wait();
+
+	/**
+	 * @brief Returns number of worker threads
+	 */
+	unsigned int getThreadCount() const;
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	// one queue for every worker
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+
+	std::vector<std::thread> workers;
+
+	// queue to which next task is submitted
+	std::atomic<unsigned int> nextQueue;
+
+	// number of tasks that are waiting in queues
+	std::atomic<int> queuedTasks;
+
+	// number of tasks that were submitted and are not finished yet
+	std::atomic<int> pendingTasks;
+
+	// indicates whether workers should exit
+	bool stop;
+
+	// first exception thrown by a task
+	std::exception_ptr taskException;
+
+	std::mutex stateMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	/**
+	 * @brief Takes task from the back of a given queue
+	 * @return TRUE if task was taken, else FALSE
+	 */
+	bool popTask(unsigned int queueIndex, std::function<void()>& task);
+
+	/**
+	 * @brief Takes task from the front of any queue other than the given one
+	 * @return TRUE if task was stolen, else FALSE
+	 */
+	bool stealTask(unsigned int thiefIndex, std::function<void()>& task);
+
+	/**
+	 * @brief Executes task and updates counters of unfinished tasks
+	 */
+	void runTask(std::function<void()>& task);
+
+	void workerLoop(unsigned int index);
+};
+
+#endif // !THREAD_POOL_H
@@ -0,0 +1,181 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	TileRenderer.cpp
+ *
+ */
+
+#include "TileRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+TileRenderer::TileRenderer(ThreadPool* pool, glm::ivec2 tileSize)
+{
+	this->pool = pool;
+	this->tileSize = tileSize;
+}
+
+void TileRenderer::render(const Raymarcher& raymarcher, glm::ivec2 resolution, std::vector<glm::vec4>& data)
+{
+	data.resize(size_t(resolution.x) * size_t(resolution.y));
+
+	glm::vec4* pixels = data.data();
+
+	// every tile is a separate task, cost of the tiles differs a lot (sky vs. fractal surface),
+	// so idle workers steal the remaining tiles from busy ones
+	for (const Tile& tile : createTiles(resolution))
+	{
+		pool->submit([&raymarcher, tile, pixels, resolution]()
+		{
+			glm::vec4* tileData = pixels + size_t(tile.origin.y) * resolution.x + tile.origin.x;
+			renderTile(raymarcher, tile, tileData, resolution.x);
+		});
+	}
+
+	pool->wait();
+}
+
+bool TileRenderer::renderBands(const Raymarcher& raymarcher, glm::ivec2 resolution, int bandsInFlight, const BandConsumer& consumer)
+{
+	int bandCount = (resolution.y + tileSize.y - 1) / tileSize.y;
+	int tilesPerBand = (resolution.x + tileSize.x - 1) / tileSize.x;
+	bandsInFlight = glm::clamp(bandsInFlight, 1, bandCount);
+
+	// ring of band buffers, band i is rendered to buffer i % bandsInFlight
+	std::vector<std::vector<glm::vec4>> buffers(bandsInFlight);
+	for (std::vector<glm::vec4>& buffer : buffers)
+		buffer.resize(size_t(resolution.x) * tileSize.y);
+
+	std::vector<int> remainingTiles(bandsInFlight, 0);
+	std::mutex mutex;
+	std::condition_variable bandFinished;
+	bool failed = false;
+
+	// tasks do not own a tile, each one claims the next tile in the top to bottom order,
+	// so the oldest band is finished first even though workers run their own tasks in LIFO order
+	std::atomic<int> nextTile(0);
+
+	auto bandRows = [&](int band, int& firstRow, int& rowCount)
+	{
+		int top = resolution.y - band * tileSize.y;
+		firstRow = std::max(0, top - tileSize.y);
+		rowCount = top - firstRow;
+	};
+
+	auto renderNextTile = [&]()
+	{
+		int index = nextTile++;
+		int band = index / tilesPerBand;
+		int slot = band % bandsInFlight;
+
+		Tile tile;
+		bandRows(band, tile.origin.y, tile.size.y);
+		tile.origin.x = (index % tilesPerBand) * tileSize.x;
+		tile.size.x = std::min(tileSize.x, resolution.x - tile.origin.x);
+
+		try
+		{
+			renderTile(raymarcher, tile, buffers[slot].data() + tile.origin.x, resolution.x);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			failed = true;
+			bandFinished.notify_all();
+			throw;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--remainingTiles[slot] == 0)
+			bandFinished.notify_all();
+	};
+
+	auto submitBand = [&](int band)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			remainingTiles[band % bandsInFlight] = tilesPerBand;
+		}
+
+		for (int i = 0; i < tilesPerBand; i++)
+			pool->submit(renderNextTile);
+	};
+
+	int submittedBands = 0;
+	while (submittedBands < bandsInFlight)
+		submitBand(submittedBands++);
+
+	bool success = true;
+	for (int band = 0; band < bandCount; band++)
+	{
+		int slot = band % bandsInFlight;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			bandFinished.wait(lock, [&]() { return remainingTiles[slot] == 0 || failed; });
+			if (failed)
+				break;
+		}
+
+		int firstRow, rowCount;
+		bandRows(band, firstRow, rowCount);
+		if (!consumer(buffers[slot].data(), firstRow, rowCount))
+		{
+			success = false;
+			break;
+		}
+
+		// buffer is free, next band can be rendered to it
+		if (submittedBands < bandCount)
+			submitBand(submittedBands++);
+	}
+
+	// finishes tasks that are still running, rethrows exception thrown by a task
+	pool->wait();
+
+	return success;
+}
+
+void TileRenderer::renderTiles(const Raymarcher& raymarcher, const std::vector<Tile>& tiles, const TileConsumer& consumer)
+{
+	for (int i = 0; i < int(tiles.size()); i++)
+	{
+		pool->submit([&raymarcher, &tiles, &consumer, i]()
+		{
+			const Tile& tile = tiles[i];
+			std::vector<glm::vec4> data(size_t(tile.size.x) * tile.size.y);
+			renderTile(raymarcher, tile, data.data(), tile.size.x);
+			consumer(i, data.data());
+		});
+	}
+
+	pool->wait();
+}
+
+std::vector<Tile> TileRenderer::createTiles(glm::ivec2 resolution) const
+{
+	std::vector<Tile> tiles;
+
+	for (int y = 0; y < resolution.y; y += tileSize.y)
+		for (int x = 0; x < resolution.x; x += tileSize.x)
+		{
+			Tile tile;
+			tile.origin = glm::ivec2(x, y);
+			tile.size.x = std::min(tileSize.x, resolution.x - x);
+			tile.size.y = std::min(tileSize.y, resolution.y - y);
+			tiles.push_back(tile);
+		}
+
+	return tiles;
+}
+
+void TileRenderer::renderTile(const Raymarcher& raymarcher, const Tile& tile, glm::vec4* data, int rowStride)
+{
+	// rows of the tile are marched in packets
+	for (int y = 0; y < tile.size.y; y++)
+		raymarcher.getColors(glm::ivec2(tile.origin.x, tile.origin.y + y), tile.size.x, data + size_t(y) * rowStride);
+}
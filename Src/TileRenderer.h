@@ -0,0 +1,98 @@
+/**
+ * PGPa, GMU - Visualization of 3D fractals
+ * VUT FIT, 2020/2021
+ *
+ * Autor:	Denis Leitner, xleitn02
+ * Subor:	TileRenderer.h
+ *
+ */
+
+#pragma once
+
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <functional>
+#include <vector>
+#include "Raymarcher.h"
+#include "ThreadPool.h"
+
+// size of the tile rendered by one compute shader work group or one CPU task
+const glm::ivec2 tileDimensions = glm::ivec2(16, 16);
+
+typedef struct tile
+{
+	glm::ivec2 origin;		// pixel coordinates of the top left corner
+	glm::ivec2 size;		// tiles on the right and bottom border can be smaller
+} Tile;
+
+/**
+ * @brief Receives finished band of the frame
+ * @param data Pixels of the band row by row, first row is the bottom one
+ * @param firstRow Row of the frame in which the band starts
+ * @param rowCount Number of rows in the band
+ * @return FALSE to stop rendering
+ */
+typedef std::function<bool(const glm::vec4* data, int firstRow, int rowCount)> BandConsumer;
+
+/**
+ * @brief Receives finished tile, called from the worker thread that rendered it
+ * @param index Index of the tile in the list of rendered tiles
+ * @param data Pixels of the tile row by row, first row is the bottom one
+ */
+typedef std::function<void(int index, const glm::vec4* data)> TileConsumer;
+
+/**
+ * @brief CPU render engine
+ * Splits frame into tiles and renders them in parallel on a thread pool.
+ */
+class TileRenderer
+{
+public:
+	/**
+	 * @param pool Thread pool on which tiles are rendered
+	 * @param tileSize Dimensions of one tile in pixels
+	 */
+	TileRenderer(ThreadPool* pool, glm::ivec2 tileSize = tileDimensions);
+
+	/**
+	 * @brief Renders whole frame
+	 * @param raymarcher Raymarcher used for computing colors of pixels
+	 * @param resolution Resolution of the frame
+	 * @param data Output pixels, row by row, resized to fit the frame
+	 */
+	void render(const Raymarcher& raymarcher, glm::ivec2 resolution, std::vector<glm::vec4>& data);
+
+	/**
+	 * @brief Renders frame by bands with memory bounded by the size of a few bands
+	 * Band is one row of tiles. Bands are rendered from the top of the frame to the bottom and
+	 * passed to the consumer strictly in this order, buffer of a band is reused once it is consumed.
+	 * @param bandsInFlight Maximal number of bands held in memory at once
+	 * @param consumer Called from the calling thread for every finished band
+	 * @return TRUE if all bands were rendered and consumed, FALSE if consumer stopped rendering
+	 */
+	bool renderBands(const Raymarcher& raymarcher, glm::ivec2 resolution, int bandsInFlight, const BandConsumer& consumer);
+
+	/**
+	 * @brief Renders given tiles in parallel, every tile is passed to the consumer as soon as it is finished
+	 */
+	void renderTiles(const Raymarcher& raymarcher, const std::vector<Tile>& tiles, const TileConsumer& consumer);
+
+	/**
+	 * @brief Splits frame of a given resolution into tiles, row by row
+	 */
+	std::vector<Tile> createTiles(glm::ivec2 resolution) const;
+
+	/**
+	 * @brief Renders one tile
+	 * @param data Pointer to the pixel in the top left corner of the tile
+	 * @param rowStride Number of pixels between two rows in data
+	 */
+	static void renderTile(const Raymarcher& raymarcher, const Tile& tile, glm::vec4* data, int rowStride);
+
+private:
+	ThreadPool* pool;
+	glm::ivec2 tileSize;
+};
+
+#endif // !TILE_RENDERER_H